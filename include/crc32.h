@@ -8,5 +8,16 @@ extern uint32_t ul_crc32(uint32_t seed, const unsigned char *buf, size_t len);
 extern uint32_t ul_crc32_exclude_offset(uint32_t seed, const unsigned char *buf, size_t len,
 		                              size_t exclude_off, size_t exclude_len);
 
-#endif
+/*
+ * CRC implementations; the best supported one is selected at runtime. The list
+ * of the implementations is exported for tests and benchmarks only.
+ */
+struct ul_crc_kernel {
+	const char	*name;
+	uint32_t	(*crc)(uint32_t seed, const unsigned char *buf, size_t len);
+	int		(*supported)(void);	/* NULL means always supported */
+};
+
+extern const struct ul_crc_kernel *ul_crc32_kernels(size_t *nkernels);
 
+#endif
@@ -4,6 +4,10 @@
 #include <sys/types.h>
 #include <stdint.h>
 
+#include "crc32.h"
+
 extern uint32_t crc32c(uint32_t crc, const void *buf, size_t size);
 
+extern const struct ul_crc_kernel *crc32c_kernels(size_t *nkernels);
+
 #endif /* UL_NG_CRC32C_H */
@@ -36,12 +36,29 @@
  *      using byte-swap instructions.
  *      polynomial $edb88320
  *
+ *  The table is used as a fallback. The PCLMULQDQ (x86_64) and ARMv8 CRC32
+ *  instructions are used if supported by the CPU, the implementation is
+ *  selected on the first call.
  */
 
 #include <stdio.h>
+#include <string.h>
 
+#include "c.h"
 #include "crc32.h"
 
+#if defined(__x86_64__) && defined(__GNUC__)
+# define UL_CRC32_PCLMUL	1
+# include <smmintrin.h>
+# include <wmmintrin.h>
+#elif defined(__aarch64__) && defined(__linux__) && defined(__GNUC__)
+# define UL_CRC32_ARMV8		1
+# include <sys/auxv.h>
+# ifndef HWCAP_CRC32
+#  define HWCAP_CRC32	(1 << 7)
+# endif
+#endif
+
 
 static const uint32_t crc32_tab[] = {
 	0x00000000L, 0x77073096L, 0xee0e612cL, 0x990951baL, 0x076dc419L,
@@ -103,6 +120,175 @@ static inline uint32_t crc32_add_char(uint32_t crc, unsigned char c)
 	return crc32_tab[(crc ^ c) & 0xff] ^ (crc >> 8);
 }
 
+static uint32_t crc32_generic(uint32_t crc, const unsigned char *p, size_t len)
+{
+	while (len) {
+		crc = crc32_add_char(crc, *p++);
+		len--;
+	}
+
+	return crc;
+}
+
+#ifdef UL_CRC32_PCLMUL
+static int crc32_pclmul_supported(void)
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+}
+
+/*
+ * Folding by carry-less multiplication, see Intel's "Fast CRC Computation for
+ * Generic Polynomials Using PCLMULQDQ Instruction". The data are folded by
+ * 4x128 bits, then by 128 bits, and the result is reduced to 32 bits by
+ * Barrett reduction. The tail (< 16 bytes) is processed by the table.
+ */
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t crc32_pclmul(uint32_t crc, const unsigned char *p, size_t len)
+{
+	const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+	const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+	const __m128i k5k0 = _mm_set_epi64x(0, 0x0163cd6124);
+	const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+	const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+	__m128i x1, x2, x3, x4, x5, x6, x7, x8;
+
+	if (len < 64)
+		return crc32_generic(crc, p, len);
+
+	x1 = _mm_loadu_si128((const __m128i *) (p + 0x00));
+	x2 = _mm_loadu_si128((const __m128i *) (p + 0x10));
+	x3 = _mm_loadu_si128((const __m128i *) (p + 0x20));
+	x4 = _mm_loadu_si128((const __m128i *) (p + 0x30));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int) crc));
+	p += 64;
+	len -= 64;
+
+	/* fold by 4x128 bits */
+	for ( ; len >= 64; p += 64, len -= 64) {
+		x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+		x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+		x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+		x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+
+		x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5),
+				_mm_loadu_si128((const __m128i *) (p + 0x00)));
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6),
+				_mm_loadu_si128((const __m128i *) (p + 0x10)));
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7),
+				_mm_loadu_si128((const __m128i *) (p + 0x20)));
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8),
+				_mm_loadu_si128((const __m128i *) (p + 0x30)));
+	}
+
+	/* fold 4x128 bits to 128 bits */
+	x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+	x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+	x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+	/* fold by 128 bits */
+	for ( ; len >= 16; p += 16, len -= 16) {
+		x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5),
+				_mm_loadu_si128((const __m128i *) p));
+	}
+
+	/* fold 128 bits to 64 bits */
+	x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, mask32);
+	x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	/* Barrett reduction to 32 bits */
+	x2 = _mm_and_si128(x1, mask32);
+	x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+	x2 = _mm_and_si128(x2, mask32);
+	x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	crc = (uint32_t) _mm_extract_epi32(x1, 1);
+
+	return crc32_generic(crc, p, len);
+}
+#endif /* UL_CRC32_PCLMUL */
+
+#ifdef UL_CRC32_ARMV8
+static int crc32_armv8_supported(void)
+{
+	return (getauxval(AT_HWCAP) & HWCAP_CRC32) ? 1 : 0;
+}
+
+__attribute__((target("+crc")))
+static uint32_t crc32_armv8(uint32_t crc, const unsigned char *p, size_t len)
+{
+	for ( ; len && ((uintptr_t) p & 7); len--)
+		__asm__("crc32b %w0, %w0, %w1" : "+r"(crc) : "r"(*p++));
+
+	for ( ; len >= 8; len -= 8, p += 8) {
+		uint64_t x;
+
+		memcpy(&x, p, sizeof(x));
+		__asm__("crc32x %w0, %w0, %x1" : "+r"(crc) : "r"(x));
+	}
+
+	for ( ; len; len--)
+		__asm__("crc32b %w0, %w0, %w1" : "+r"(crc) : "r"(*p++));
+
+	return crc;
+}
+#endif /* UL_CRC32_ARMV8 */
+
+/* the best implementation first */
+static const struct ul_crc_kernel kernels[] = {
+#ifdef UL_CRC32_PCLMUL
+	{ "pclmul", crc32_pclmul, crc32_pclmul_supported },
+#endif
+#ifdef UL_CRC32_ARMV8
+	{ "armv8", crc32_armv8, crc32_armv8_supported },
+#endif
+	{ "generic", crc32_generic, NULL }
+};
+
+const struct ul_crc_kernel *ul_crc32_kernels(size_t *nkernels)
+{
+	*nkernels = ARRAY_SIZE(kernels);
+	return kernels;
+}
+
+static uint32_t crc32_select(uint32_t seed, const unsigned char *buf, size_t len);
+
+static uint32_t (*crc32_fn)(uint32_t, const unsigned char *, size_t) = crc32_select;
+
+static uint32_t crc32_select(uint32_t seed, const unsigned char *buf, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(kernels); i++) {
+		if (!kernels[i].supported || kernels[i].supported()) {
+			crc32_fn = kernels[i].crc;
+			break;
+		}
+	}
+	return crc32_fn(seed, buf, len);
+}
+
 /*
  * This a generic crc32() function, it takes seed as an argument,
  * and does __not__ xor at the end. Then individual users can do
@@ -110,33 +296,144 @@ static inline uint32_t crc32_add_char(uint32_t crc, unsigned char c)
  */
 uint32_t ul_crc32(uint32_t seed, const unsigned char *buf, size_t len)
 {
+	return crc32_fn(seed, buf, len);
+}
+
+/*
+ * The excluded area is calculated as zeros.
+ */
+uint32_t ul_crc32_exclude_offset(uint32_t seed, const unsigned char *buf, size_t len,
+			      size_t exclude_off, size_t exclude_len)
+{
+	static const unsigned char zeros[64];
 	uint32_t crc = seed;
-	const unsigned char *p = buf;
 
-	while (len) {
-		crc = crc32_add_char(crc, *p++);
-		len--;
+	if (exclude_off >= len)
+		return ul_crc32(seed, buf, len);
+	if (exclude_len > len - exclude_off)
+		exclude_len = len - exclude_off;
+
+	crc = ul_crc32(crc, buf, exclude_off);
+	buf += exclude_off;
+	len -= exclude_off;
+
+	while (exclude_len) {
+		size_t sz = min(exclude_len, sizeof(zeros));
+
+		crc = ul_crc32(crc, zeros, sz);
+		exclude_len -= sz;
+		buf += sz;
+		len -= sz;
 	}
 
-	return crc;
+	return ul_crc32(crc, buf, len);
 }
 
-uint32_t ul_crc32_exclude_offset(uint32_t seed, const unsigned char *buf, size_t len,
-			      size_t exclude_off, size_t exclude_len)
+#ifdef TEST_PROGRAM_CRC32
+# include <stdlib.h>
+# include <time.h>
+# include "crc32c.h"
+
+static double now(void)
 {
-	uint32_t crc = seed;
-	const unsigned char *p = buf;
-	size_t i;
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* compares all supported implementations with the generic one */
+static int check_kernels(const char *name, const struct ul_crc_kernel *ks, size_t nks)
+{
+	const struct ul_crc_kernel *ref = &ks[nks - 1];
+	unsigned char buf[16 * 1024 + 16];
+	size_t i, len, off;
+	int rc = 0;
 
-	for (i = 0; i < len; i++) {
-		unsigned char x = *p++;
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = (unsigned char) (i * 2654435761U >> 13);
 
-		if (i >= exclude_off && i < exclude_off + exclude_len)
-			x = 0;
+	for (i = 0; i < nks - 1; i++) {
+		if (ks[i].supported && !ks[i].supported())
+			continue;
+		for (off = 0; off < 16; off++) {
+			for (len = 0; len + off <= sizeof(buf);
+			     len += (len < 512 ? 1 : 509)) {
+				uint32_t a = ks[i].crc(~0U, buf + off, len);
+				uint32_t b = ref->crc(~0U, buf + off, len);
 
-		crc = crc32_add_char(crc, x);
+				if (a != b) {
+					fprintf(stderr, "%s: %s: off=%zu len=%zu: %08x != %08x\n",
+							name, ks[i].name, off, len, a, b);
+					rc = 1;
+					break;
+				}
+			}
+		}
 	}
+	return rc;
+}
 
-	return crc;
+static void bench_kernels(const char *name, const struct ul_crc_kernel *ks,
+			  size_t nks, size_t size)
+{
+	unsigned char *buf = calloc(1, size);
+	size_t i;
+
+	if (!buf)
+		err(EXIT_FAILURE, "cannot allocate %zu bytes", size);
+
+	for (i = 0; i < nks; i++) {
+		double start, t;
+		uint64_t n = 0;
+		uint32_t crc = ~0U;
+
+		if (ks[i].supported && !ks[i].supported()) {
+			printf("%-8s %-8s   unsupported\n", name, ks[i].name);
+			continue;
+		}
+		start = now();
+		do {
+			crc = ks[i].crc(crc, buf, size);
+			n++;
+		} while ((t = now() - start) < 0.5);
+
+		printf("%-8s %-8s %8.2f GB/s [crc=%08x]\n", name, ks[i].name,
+				(double) n * size / t / 1e9, crc);
+	}
+	free(buf);
 }
 
+int main(int argc, char *argv[])
+{
+	const struct ul_crc_kernel *ks, *cks;
+	size_t nks, ncks;
+	const unsigned char check[] = "123456789";
+
+	ks = ul_crc32_kernels(&nks);
+	cks = crc32c_kernels(&ncks);
+
+	if (argc >= 2 && strcmp(argv[1], "--bench") == 0) {
+		size_t size = argc == 3 ? strtoul(argv[2], NULL, 10) : 16384;
+
+		if (!size)
+			errx(EXIT_FAILURE, "invalid size");
+		bench_kernels("crc32", ks, nks, size);
+		bench_kernels("crc32c", cks, ncks, size);
+		return EXIT_SUCCESS;
+	}
+	if (argc != 1) {
+		fprintf(stderr, "usage: %s [--bench [<size>]]\n",
+				program_invocation_short_name);
+		return EXIT_FAILURE;
+	}
+
+	if (check_kernels("crc32", ks, nks) || check_kernels("crc32c", cks, ncks))
+		return EXIT_FAILURE;
+
+	printf("crc32:  %08x\n", ul_crc32(~0U, check, sizeof(check) - 1) ^ ~0U);
+	printf("crc32c: %08x\n", crc32c(~0U, check, sizeof(check) - 1) ^ ~0U);
+	printf("gpt:    %08x\n", ul_crc32_exclude_offset(~0U, check, sizeof(check) - 1, 2, 4) ^ ~0U);
+	return EXIT_SUCCESS;
+}
+#endif /* TEST_PROGRAM_CRC32 */
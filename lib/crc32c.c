@@ -1,8 +1,9 @@
 /*
  * This code is from freebsd/sys/libkern/crc32.c
  *
- * Simplest table-based crc32c.  Performance is not important
- * for checking crcs on superblocks
+ * Simplest table-based crc32c is used as a fallback. The SSE4.2 (x86_64) and
+ * ARMv8 CRC32 instructions are used if supported by the CPU, the
+ * implementation is selected on the first call.
  */
 
 /*-
@@ -10,8 +11,22 @@
  *  code or tables extracted from it, as desired without restriction.
  */
 
+#include <string.h>
+
+#include "c.h"
 #include "crc32c.h"
 
+#if defined(__x86_64__) && defined(__GNUC__)
+# define UL_CRC32C_SSE42	1
+# include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__linux__) && defined(__GNUC__)
+# define UL_CRC32C_ARMV8	1
+# include <sys/auxv.h>
+# ifndef HWCAP_CRC32
+#  define HWCAP_CRC32	(1 << 7)
+# endif
+#endif
+
 static const uint32_t crc32Table[256] = {
 	0x00000000L, 0xF26B8303L, 0xE13B70F7L, 0x1350F3F4L,
 	0xC79A971FL, 0x35F1141CL, 0x26A1E7E8L, 0xD4CA64EBL,
@@ -90,13 +105,105 @@ static const uint32_t crc32Table[256] = {
  *    crc ^= ~0L
  *
  */
-uint32_t
-crc32c(uint32_t crc, const void *buf, size_t size)
+static uint32_t crc32c_generic(uint32_t crc, const unsigned char *p, size_t size)
 {
-	const uint8_t *p = buf;
-
 	while (size--)
 		crc = crc32Table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
 
 	return crc;
 }
+
+#ifdef UL_CRC32C_SSE42
+static int crc32c_sse42_supported(void)
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse4.2");
+}
+
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const unsigned char *p, size_t size)
+{
+	uint64_t crc64 = crc;
+
+	for ( ; size && ((uintptr_t) p & 7); size--)
+		crc64 = _mm_crc32_u8((uint32_t) crc64, *p++);
+
+	for ( ; size >= 8; size -= 8, p += 8) {
+		uint64_t x;
+
+		memcpy(&x, p, sizeof(x));
+		crc64 = _mm_crc32_u64(crc64, x);
+	}
+
+	for ( ; size; size--)
+		crc64 = _mm_crc32_u8((uint32_t) crc64, *p++);
+
+	return (uint32_t) crc64;
+}
+#endif /* UL_CRC32C_SSE42 */
+
+#ifdef UL_CRC32C_ARMV8
+static int crc32c_armv8_supported(void)
+{
+	return (getauxval(AT_HWCAP) & HWCAP_CRC32) ? 1 : 0;
+}
+
+__attribute__((target("+crc")))
+static uint32_t crc32c_armv8(uint32_t crc, const unsigned char *p, size_t size)
+{
+	for ( ; size && ((uintptr_t) p & 7); size--)
+		__asm__("crc32cb %w0, %w0, %w1" : "+r"(crc) : "r"(*p++));
+
+	for ( ; size >= 8; size -= 8, p += 8) {
+		uint64_t x;
+
+		memcpy(&x, p, sizeof(x));
+		__asm__("crc32cx %w0, %w0, %x1" : "+r"(crc) : "r"(x));
+	}
+
+	for ( ; size; size--)
+		__asm__("crc32cb %w0, %w0, %w1" : "+r"(crc) : "r"(*p++));
+
+	return crc;
+}
+#endif /* UL_CRC32C_ARMV8 */
+
+/* the best implementation first */
+static const struct ul_crc_kernel kernels[] = {
+#ifdef UL_CRC32C_SSE42
+	{ "sse4.2", crc32c_sse42, crc32c_sse42_supported },
+#endif
+#ifdef UL_CRC32C_ARMV8
+	{ "armv8", crc32c_armv8, crc32c_armv8_supported },
+#endif
+	{ "generic", crc32c_generic, NULL }
+};
+
+const struct ul_crc_kernel *crc32c_kernels(size_t *nkernels)
+{
+	*nkernels = ARRAY_SIZE(kernels);
+	return kernels;
+}
+
+static uint32_t crc32c_select(uint32_t crc, const unsigned char *p, size_t size);
+
+static uint32_t (*crc32c_fn)(uint32_t, const unsigned char *, size_t) = crc32c_select;
+
+static uint32_t crc32c_select(uint32_t crc, const unsigned char *p, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(kernels); i++) {
+		if (!kernels[i].supported || kernels[i].supported()) {
+			crc32c_fn = kernels[i].crc;
+			break;
+		}
+	}
+	return crc32c_fn(crc, p, size);
+}
+
+uint32_t
+crc32c(uint32_t crc, const void *buf, size_t size)
+{
+	return crc32c_fn(crc, buf, size);
+}
@@ -0,0 +1,686 @@
+/*
+ * bincache.c - binary version of the cache file
+ *
+ * This file may be redistributed under the terms of the
+ * GNU Lesser General Public License.
+ *
+ * The text cache file (blkid.tab) has to be tokenized line by line. The binary
+ * version is stored next to the text file (blkid.tab.bin), it's written by
+ * blkid_flush_cache() together with the text file and it's possible to mmap it
+ * and search in the file without any allocation.
+ *
+ * File format (all numbers in native byte order):
+ *
+ *	header
+ *	devices table	-- devices in the same order as in the cache
+ *	tags table	-- tags of all devices, tags of a device are together
+ *	hash table	-- the first tag for hash(NAME, value), chained by tag->next
+ *	strings pool	-- NUL terminated strings
+ *
+ * The binary file is used only if the text file has the same size and
+ * modification time as recorded in the header. In all other cases the library
+ * falls back to the text file.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+
+#include "blkidP.h"
+#include "all-io.h"
+#include "fileutils.h"
+#include "sysfs.h"
+
+#define BINCACHE_MAGIC		"BLKIDBIN"
+#define BINCACHE_VERSION	2
+#define BINCACHE_ENDIAN		0x01020304
+#define BINCACHE_SUFFIX		".bin"
+#define BINCACHE_NONE		UINT32_MAX
+
+struct bincache_hdr {
+	char		magic[8];	/* BINCACHE_MAGIC */
+	uint32_t	version;	/* BINCACHE_VERSION */
+	uint32_t	endian;		/* BINCACHE_ENDIAN */
+
+	uint64_t	text_size;	/* text cache file size */
+	int64_t		text_mtime;	/* text cache file modification time */
+	int64_t		text_mtime_ns;
+
+	uint32_t	ndevs;		/* number of devices */
+	uint32_t	ntags;		/* number of tags */
+	uint32_t	nbuckets;	/* size of the hash table */
+	uint32_t	strsz;		/* size of the strings pool */
+};
+
+struct bincache_dev {
+	uint64_t	devno;
+	int64_t		time;
+	int64_t		utime;
+	int32_t		pri;
+	uint32_t	name;		/* offset in strings pool */
+	uint32_t	tags;		/* index of the first tag */
+	uint32_t	ntags;		/* number of tags */
+};
+
+struct bincache_tag {
+	uint32_t	name;		/* offset in strings pool */
+	uint32_t	value;		/* offset in strings pool */
+	uint32_t	dev;		/* index in devices table */
+	uint32_t	next;		/* next tag in the hash chain */
+};
+
+struct blkid_bincache {
+	void				*map;
+	size_t				mapsz;
+
+	const struct bincache_hdr	*hdr;
+	const struct bincache_dev	*devs;
+	const struct bincache_tag	*tags;
+	const uint32_t			*hash;
+	const char			*strs;
+};
+
+static uint64_t bincache_size(uint64_t ndevs, uint64_t ntags,
+			      uint64_t nbuckets, uint64_t strsz)
+{
+	return sizeof(struct bincache_hdr)
+		+ ndevs * sizeof(struct bincache_dev)
+		+ ntags * sizeof(struct bincache_tag)
+		+ nbuckets * sizeof(uint32_t)
+		+ strsz;
+}
+
+static char *bincache_filename(const char *filename)
+{
+	size_t sz = strlen(filename);
+	char *bin = malloc(sz + sizeof(BINCACHE_SUFFIX));
+
+	if (bin) {
+		memcpy(bin, filename, sz);
+		memcpy(bin + sz, BINCACHE_SUFFIX, sizeof(BINCACHE_SUFFIX));
+	}
+	return bin;
+}
+
+/* returns string from the pool or NULL if @off is out of the pool */
+static inline const char *bincache_str(struct blkid_bincache *bc, uint32_t off)
+{
+	return off < bc->hdr->strsz ? bc->strs + off : NULL;
+}
+
+/*
+ * Maps binary version of the cache @filename. The @st is stat of the text
+ * cache file.
+ *
+ * Returns: new bincache handler or NULL if not available or not valid.
+ */
+struct blkid_bincache *blkid_bincache_open(const char *filename,
+					   const struct stat *st)
+{
+	struct blkid_bincache *bc = NULL;
+	const struct bincache_hdr *hdr;
+	struct stat bst;
+	char *binname;
+	void *map;
+	int fd;
+
+	binname = bincache_filename(filename);
+	if (!binname)
+		return NULL;
+
+	fd = open(binname, O_RDONLY|O_CLOEXEC);
+	if (fd < 0)
+		goto done;
+	if (fstat(fd, &bst) != 0 || !S_ISREG(bst.st_mode) ||
+	    (size_t) bst.st_size < sizeof(struct bincache_hdr))
+		goto done;
+
+	map = mmap(NULL, bst.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED)
+		goto done;
+
+	hdr = (const struct bincache_hdr *) map;
+	if (memcmp(hdr->magic, BINCACHE_MAGIC, sizeof(hdr->magic)) != 0
+	    || hdr->version != BINCACHE_VERSION
+	    || hdr->endian != BINCACHE_ENDIAN) {
+		DBG(READ, ul_debug("%s: unsupported binary cache", binname));
+		goto unmap;
+	}
+	if (hdr->text_size != (uint64_t) st->st_size
+	    || hdr->text_mtime != (int64_t) st->st_mtime
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+	    || hdr->text_mtime_ns != (int64_t) st->st_mtim.tv_nsec
+#endif
+	    ) {
+		DBG(READ, ul_debug("%s: outdated binary cache", binname));
+		goto unmap;
+	}
+	if (bincache_size(hdr->ndevs, hdr->ntags, hdr->nbuckets, hdr->strsz)
+			!= (uint64_t) bst.st_size
+	    || hdr->nbuckets == 0 || hdr->strsz == 0) {
+		DBG(READ, ul_debug("%s: corrupted binary cache", binname));
+		goto unmap;
+	}
+
+	bc = calloc(1, sizeof(*bc));
+	if (!bc)
+		goto unmap;
+
+	bc->map = map;
+	bc->mapsz = bst.st_size;
+	bc->hdr = hdr;
+	bc->devs = (const struct bincache_dev *) (hdr + 1);
+	bc->tags = (const struct bincache_tag *) (bc->devs + hdr->ndevs);
+	bc->hash = (const uint32_t *) (bc->tags + hdr->ntags);
+	bc->strs = (const char *) (bc->hash + hdr->nbuckets);
+
+	if (bc->strs[hdr->strsz - 1] != '\0') {
+		DBG(READ, ul_debug("%s: corrupted strings pool", binname));
+		blkid_bincache_close(bc);
+		bc = NULL;
+		goto done;
+	}
+
+	DBG(READ, ul_debug("%s: mapped binary cache [devs=%u, tags=%u]",
+				binname, hdr->ndevs, hdr->ntags));
+	goto done;
+unmap:
+	munmap(map, bst.st_size);
+done:
+	if (fd >= 0)
+		close(fd);
+	free(binname);
+	return bc;
+}
+
+void blkid_bincache_close(struct blkid_bincache *bc)
+{
+	if (!bc)
+		return;
+	munmap(bc->map, bc->mapsz);
+	free(bc);
+}
+
+/* returns the device with the highest priority and with the tag */
+static const struct bincache_dev *bincache_find_tag_dev(struct blkid_bincache *bc,
+					const char *name, const char *value)
+{
+	const struct bincache_dev *best = NULL;
+	uint32_t idx, n = 0;
+
+	idx = bc->hash[blkid_tag_hash(name, value) % bc->hdr->nbuckets];
+
+	/* @n protects against loop in corrupted file */
+	for ( ; idx < bc->hdr->ntags && n < bc->hdr->ntags; n++) {
+		const struct bincache_tag *tag = &bc->tags[idx];
+		const char *tn = bincache_str(bc, tag->name),
+			   *tv = bincache_str(bc, tag->value);
+
+		if (tn && tv && tag->dev < bc->hdr->ndevs
+		    && strcmp(tn, name) == 0 && strcmp(tv, value) == 0) {
+			const struct bincache_dev *dev = &bc->devs[tag->dev];
+
+			if (!best || dev->pri > best->pri)
+				best = dev;
+		}
+		idx = tag->next;
+	}
+
+	return best;
+}
+
+/*
+ * Returns: name of the device with the highest priority and with the tag, or
+ *          NULL. The string is in the mapped file.
+ */
+const char *blkid_bincache_find_tag(struct blkid_bincache *bc,
+				    const char *name, const char *value)
+{
+	const struct bincache_dev *dev = bincache_find_tag_dev(bc, name, value);
+
+	return dev ? bincache_str(bc, dev->name) : NULL;
+}
+
+/*
+ * Verifies that the device @bd from the binary cache still has the tag. The
+ * device is probed if the cache entry is older than the device (the same rules
+ * as in blkid_verify()).
+ *
+ * Returns: 1 if the tag is valid, 0 if not, or if it cannot be verified.
+ */
+static int bincache_verify_tag(blkid_cache cache, const char *devname,
+			       const struct bincache_dev *bd,
+			       const char *name, const char *value)
+{
+	blkid_dev dev;
+	struct stat st;
+	time_t now = time(NULL);
+	int fd, rc;
+
+	if (stat(devname, &st) != 0 || (uint64_t) st.st_rdev != bd->devno)
+		return 0;
+
+	if (now >= bd->time &&
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+	    (st.st_mtime < bd->time ||
+		(st.st_mtime == bd->time &&
+		 st.st_mtim.tv_nsec / 1000 <= bd->utime)) &&
+#else
+	    st.st_mtime <= bd->time &&
+#endif
+	    now - bd->time < BLKID_PROBE_MIN)
+		return 1;
+
+	if (sysfs_devno_is_dm_private(st.st_rdev, NULL))
+		return 0;
+
+	if (!cache->probe) {
+		cache->probe = blkid_new_probe();
+		if (!cache->probe)
+			return 0;
+	}
+	dev = blkid_new_dev();
+	if (!dev)
+		return 0;
+
+	rc = 0;
+	fd = open(devname, O_RDONLY|O_CLOEXEC|O_NONBLOCK);
+	if (fd >= 0) {
+		rc = blkid_verify_probe(cache->probe, fd, dev) == 0
+			&& blkid_dev_has_tag(dev, name, value);
+		close(fd);
+	}
+	blkid_free_dev(dev);
+
+	DBG(PROBE, ul_debug("%s: %s=%s %s", devname, name, value,
+				rc ? "verified" : "not found"));
+	return rc;
+}
+
+/*
+ * Searches for the device with the tag in the binary cache file without
+ * reading the whole cache to @cache. It's possible only if the cache has not
+ * been read yet.
+ *
+ * Returns: newly allocated device name, or NULL if not found, the entry is
+ *          stale or the binary cache is not available. The caller is expected
+ *          to fall back to blkid_find_dev_with_tag().
+ */
+char *blkid_bincache_get_devname(blkid_cache cache, const char *name,
+				 const char *value)
+{
+	struct blkid_bincache *bc;
+	const struct bincache_dev *bd;
+	const char *devname;
+	char *res = NULL;
+	struct stat st;
+
+	if (!cache->bic_filename
+	    || (cache->bic_flags & (BLKID_BIC_FL_READ | BLKID_BIC_FL_CHANGED)))
+		return NULL;
+
+	if (stat(cache->bic_filename, &st) != 0)
+		return NULL;
+	bc = blkid_bincache_open(cache->bic_filename, &st);
+	if (!bc)
+		return NULL;
+
+	bd = bincache_find_tag_dev(bc, name, value);
+	devname = bd ? bincache_str(bc, bd->name) : NULL;
+
+	if (devname && bincache_verify_tag(cache, devname, bd, name, value))
+		res = strdup(devname);
+
+	DBG(READ, ul_debug("binary cache: %s=%s: %s", name, value,
+				res ? res : "<none>"));
+	blkid_bincache_close(bc);
+	return res;
+}
+
+/*
+ * Adds all devices from the binary cache to @cache.
+ *
+ * Returns: 0 on success, <0 on error.
+ */
+int blkid_bincache_read(blkid_cache cache, struct blkid_bincache *bc)
+{
+	uint32_t i;
+
+	for (i = 0; i < bc->hdr->ndevs; i++) {
+		const struct bincache_dev *bd = &bc->devs[i];
+		const char *name = bincache_str(bc, bd->name);
+		blkid_dev dev;
+		uint32_t t;
+
+		if (!name || !*name
+		    || bd->tags > bc->hdr->ntags
+		    || bd->ntags > bc->hdr->ntags - bd->tags) {
+			DBG(READ, ul_debug("binary cache: corrupted device entry"));
+			return -BLKID_ERR_CACHE;
+		}
+
+		dev = blkid_get_dev(cache, name, BLKID_DEV_CREATE);
+		if (!dev)
+			return -BLKID_ERR_MEM;
+
+		dev->bid_devno = bd->devno;
+		dev->bid_time = bd->time;
+		dev->bid_utime = bd->utime;
+		dev->bid_pri = bd->pri;
+
+		for (t = bd->tags; t < bd->tags + bd->ntags; t++) {
+			const char *tn = bincache_str(bc, bc->tags[t].name),
+				   *tv = bincache_str(bc, bc->tags[t].value);
+			int rc;
+
+			if (!tn || !tv)
+				return -BLKID_ERR_CACHE;
+			rc = blkid_set_tag(dev, tn, tv, strlen(tv));
+			if (rc < 0)
+				return rc;
+		}
+
+		if (dev->bid_type == NULL) {
+			DBG(READ, ul_debug("blkid: device %s has no TYPE", dev->bid_name));
+			blkid_free_dev(dev);
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Strings pool builder, the tag names are stored only once.
+ */
+struct bincache_strs {
+	char		*data;
+	size_t		sz;
+	size_t		alloc;
+
+	uint32_t	names[32];	/* offsets of already stored tag names */
+	size_t		nnames;
+};
+
+static int bincache_add_str(struct bincache_strs *s, const char *str, uint32_t *off)
+{
+	size_t len = strlen(str) + 1;
+
+	if (s->sz + len > BINCACHE_NONE)
+		return -BLKID_ERR_BIG;
+	if (s->sz + len > s->alloc) {
+		size_t sz = max(s->alloc * 2, s->sz + len + 4096);
+		char *p = realloc(s->data, sz);
+
+		if (!p)
+			return -BLKID_ERR_MEM;
+		s->data = p;
+		s->alloc = sz;
+	}
+	memcpy(s->data + s->sz, str, len);
+	*off = s->sz;
+	s->sz += len;
+	return 0;
+}
+
+static int bincache_add_name(struct bincache_strs *s, const char *name, uint32_t *off)
+{
+	size_t i;
+	int rc;
+
+	for (i = 0; i < s->nnames; i++) {
+		if (strcmp(s->data + s->names[i], name) == 0) {
+			*off = s->names[i];
+			return 0;
+		}
+	}
+	rc = bincache_add_str(s, name, off);
+	if (rc == 0 && s->nnames < ARRAY_SIZE(s->names))
+		s->names[s->nnames++] = *off;
+	return rc;
+}
+
+static inline int bincache_is_saved(blkid_dev dev)
+{
+	/* the same devices as in the text file, see save.c */
+	return dev->bid_name && dev->bid_name[0] == '/' && dev->bid_type
+	       && !(dev->bid_flags & BLKID_BID_FL_REMOVABLE);
+}
+
+/*
+ * Writes binary version of the @cache for already written text cache
+ * file @filename. The file is written to a temporary file and renamed.
+ *
+ * Returns: 0 on success, <0 on error.
+ */
+int blkid_bincache_write(blkid_cache cache, const char *filename)
+{
+	struct bincache_strs strs = { .sz = 0 };
+	struct bincache_hdr *hdr;
+	struct bincache_dev *devs;
+	struct bincache_tag *tags, *btags;
+	uint32_t *hash;
+	uint32_t ndevs = 0, ntags = 0, nbuckets, d, t;
+	struct list_head *p, *pt;
+	char *binname = NULL, *tmp = NULL;
+	unsigned char *buf = NULL;
+	uint64_t sz;
+	struct stat st;
+	int fd = -1, rc;
+
+	if (stat(filename, &st) != 0 || !S_ISREG(st.st_mode))
+		return -BLKID_ERR_PARAM;
+
+	list_for_each(p, &cache->bic_devs) {
+		blkid_dev dev = list_entry(p, struct blkid_struct_dev, bid_devs);
+
+		if (!bincache_is_saved(dev))
+			continue;
+		ndevs++;
+		list_for_each(pt, &dev->bid_tags)
+			ntags++;
+	}
+
+	for (nbuckets = 16; nbuckets < ntags; nbuckets <<= 1);
+
+	/* the strings have to be stored to know the size of the file */
+	devs = calloc(ndevs ? ndevs : 1, sizeof(struct bincache_dev));
+	tags = calloc(ntags ? ntags : 1, sizeof(struct bincache_tag));
+	if (!devs || !tags) {
+		rc = -BLKID_ERR_MEM;
+		goto done;
+	}
+
+	d = t = 0;
+	list_for_each(p, &cache->bic_devs) {
+		blkid_dev dev = list_entry(p, struct blkid_struct_dev, bid_devs);
+		struct bincache_dev *bd = &devs[d];
+
+		if (!bincache_is_saved(dev))
+			continue;
+
+		bd->devno = dev->bid_devno;
+		bd->time = dev->bid_time;
+		bd->utime = dev->bid_utime;
+		bd->pri = dev->bid_pri;
+		bd->tags = t;
+		rc = bincache_add_str(&strs, dev->bid_name, &bd->name);
+		if (rc)
+			goto done;
+
+		list_for_each(pt, &dev->bid_tags) {
+			blkid_tag tag = list_entry(pt, struct blkid_struct_tag, bit_tags);
+
+			tags[t].dev = d;
+			rc = bincache_add_name(&strs, tag->bit_name, &tags[t].name);
+			if (!rc)
+				rc = bincache_add_str(&strs, tag->bit_val, &tags[t].value);
+			if (rc)
+				goto done;
+			t++;
+		}
+		bd->ntags = t - bd->tags;
+		d++;
+	}
+
+	if (!strs.sz) {
+		uint32_t off;
+
+		rc = bincache_add_str(&strs, "", &off);	/* empty pool */
+		if (rc)
+			goto done;
+	}
+
+	sz = bincache_size(ndevs, ntags, nbuckets, strs.sz);
+	buf = calloc(1, sz);
+	if (!buf) {
+		rc = -BLKID_ERR_MEM;
+		goto done;
+	}
+
+	hdr = (struct bincache_hdr *) buf;
+	memcpy(hdr->magic, BINCACHE_MAGIC, sizeof(hdr->magic));
+	hdr->version = BINCACHE_VERSION;
+	hdr->endian = BINCACHE_ENDIAN;
+	hdr->text_size = st.st_size;
+	hdr->text_mtime = st.st_mtime;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+	hdr->text_mtime_ns = st.st_mtim.tv_nsec;
+#endif
+	hdr->ndevs = ndevs;
+	hdr->ntags = ntags;
+	hdr->nbuckets = nbuckets;
+	hdr->strsz = strs.sz;
+
+	memcpy(hdr + 1, devs, ndevs * sizeof(struct bincache_dev));
+	btags = (struct bincache_tag *) ((struct bincache_dev *) (hdr + 1) + ndevs);
+	hash = (uint32_t *) (btags + ntags);
+	for (d = 0; d < nbuckets; d++)
+		hash[d] = BINCACHE_NONE;
+
+	/* add to the chains in reverse order to keep the cache order in chains */
+	for (t = ntags; t > 0; t--) {
+		struct bincache_tag *tag = &tags[t - 1];
+		uint32_t h = blkid_tag_hash(strs.data + tag->name,
+					    strs.data + tag->value) % nbuckets;
+		tag->next = hash[h];
+		hash[h] = t - 1;
+	}
+	memcpy(btags, tags, ntags * sizeof(struct bincache_tag));
+	memcpy((char *) (hash + nbuckets), strs.data, strs.sz);
+
+	binname = bincache_filename(filename);
+	tmp = binname ? malloc(strlen(binname) + 8) : NULL;
+	if (!tmp) {
+		rc = -BLKID_ERR_MEM;
+		goto done;
+	}
+	sprintf(tmp, "%s-XXXXXX", binname);
+	fd = mkstemp_cloexec(tmp);
+	if (fd < 0) {
+		rc = -errno;
+		goto done;
+	}
+	if (fchmod(fd, 0644) != 0 || write_all(fd, buf, sz) != 0) {
+		rc = -errno;
+		goto done;
+	}
+	if (close(fd) != 0) {
+		fd = -1;
+		rc = -errno;
+		goto done;
+	}
+	fd = -1;
+	if (rename(tmp, binname) != 0) {
+		rc = -errno;
+		goto done;
+	}
+
+	DBG(SAVE, ul_debug("wrote binary cache %s [devs=%u, tags=%u]",
+				binname, ndevs, ntags));
+	rc = 0;
+done:
+	if (rc && tmp) {
+		DBG(SAVE, ul_debug("failed to write binary cache %s", binname));
+		if (fd >= 0)
+			close(fd);
+		unlink(tmp);
+	}
+	free(tmp);
+	free(binname);
+	free(buf);
+	free(strs.data);
+	free(devs);
+	free(tags);
+	return rc;
+}
+
+#ifdef TEST_PROGRAM
+int main(int argc, char **argv)
+{
+	struct blkid_bincache *bc;
+	blkid_cache cache = NULL;
+	struct stat st;
+	int i, rc;
+
+	blkid_init_debug(BLKID_DEBUG_ALL);
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <cachefile> [NAME=value ...]\n"
+			"Convert text cache to binary and search for tags\n",
+			argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	if ((rc = blkid_get_cache(&cache, argv[1])) < 0) {
+		fprintf(stderr, "%s: error creating cache (%d)\n", argv[0], rc);
+		exit(EXIT_FAILURE);
+	}
+	blkid_read_cache(cache);
+	if ((rc = blkid_bincache_write(cache, argv[1])) < 0) {
+		fprintf(stderr, "%s: error writing binary cache (%d)\n", argv[0], rc);
+		exit(EXIT_FAILURE);
+	}
+	blkid_put_cache(cache);
+
+	if (stat(argv[1], &st) != 0 || !(bc = blkid_bincache_open(argv[1], &st))) {
+		fprintf(stderr, "%s: cannot open binary cache\n", argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	for (i = 2; i < argc; i++) {
+		char *name = NULL, *value = NULL;
+		const char *res;
+
+		if (blkid_parse_tag_string(argv[i], &name, &value) != 0
+		    || !name || !value) {
+			fprintf(stderr, "%s: cannot parse tag\n", argv[i]);
+			continue;
+		}
+		res = blkid_bincache_find_tag(bc, name, value);
+		printf("%s: %s\n", argv[i], res ? res : "<none>");
+
+		/* verified lookup by a new (not yet read) cache */
+		if (blkid_get_cache(&cache, argv[1]) == 0) {
+			char *devname = blkid_bincache_get_devname(cache, name, value);
+
+			printf("%s: verified: %s\n", argv[i], devname ? devname : "<none>");
+			free(devname);
+			blkid_put_cache(cache);
+		}
+		free(name);
+		free(value);
+	}
+
+	blkid_bincache_close(bc);
+	return EXIT_SUCCESS;
+}
+#endif
@@ -74,6 +74,7 @@ struct blkid_struct_tag
 {
 	struct list_head	bit_tags;	/* All tags for this device */
 	struct list_head	bit_names;	/* All tags with given NAME */
+	struct list_head	bit_hash;	/* Tags in the same NAME=value bucket */
 	char			*bit_name;	/* NAME of tag (shared) */
 	char			*bit_val;	/* value of tag */
 	blkid_dev		bit_dev;	/* pointer to device */
@@ -134,6 +135,7 @@ struct blkid_prval
 	const char	*name;		/* value name */
 	unsigned char	*data;		/* value data */
 	size_t		len;		/* length of value data */
+	size_t		datasz;		/* allocated size of data */
 
 	struct blkid_chain	*chain;		/* owner */
 	struct list_head	prvals;		/* list of results */
@@ -180,9 +182,24 @@ struct blkid_bufinfo {
 	unsigned char		*data;
 	uint64_t		off;
 	uint64_t		len;
+	uint64_t		size;	/* allocated size of data */
 	struct list_head	bufs;	/* list of buffers */
 };
 
+/*
+ * Unused buffers and values are kept by prober for the next probing, see
+ * blkid_probe_reset_buffers() and blkid_reset_probe().
+ */
+#define BLKID_POOL_MAXSZ	(2 * 1024 * 1024)	/* max. bytes in buffers pool */
+#define BLKID_PRVAL_MINSZ	64			/* min. size of value data */
+
+struct blkid_pool_stats {
+	size_t		bufs_alloc;	/* buffers allocated by malloc */
+	size_t		bufs_reused;	/* buffers from pool */
+	size_t		vals_alloc;	/* values allocated by malloc */
+	size_t		vals_reused;	/* values from pool */
+};
+
 /*
  * Low-level probing control struct
  */
@@ -205,6 +222,13 @@ struct blkid_struct_probe
 	struct blkid_chain	*wipe_chain;	/* superblock, partition, ... */
 
 	struct list_head	buffers;	/* list of buffers */
+	uint64_t		nbuffers;	/* number of buffers */
+	uint64_t		bufs_size;	/* bytes in buffers */
+
+	struct list_head	free_buffers;	/* pool of unused buffers */
+	uint64_t		free_bufs_size;	/* bytes in free_buffers */
+	struct list_head	free_values;	/* pool of unused values */
+	struct blkid_pool_stats	pool_stats;	/* for debug messages */
 
 	struct blkid_chain	chains[BLKID_NCHAINS];	/* array of chains */
 	struct blkid_chain	*cur_chain;		/* current chain */
@@ -213,6 +237,8 @@ struct blkid_struct_probe
 
 	struct blkid_struct_probe *parent;	/* for clones */
 	struct blkid_struct_probe *disk_probe;	/* whole-disk probing */
+
+	struct blkid_uring	*uring;		/* batched reads or NULL (uring.c) */
 };
 
 /* private flags library flags */
@@ -221,6 +247,7 @@ struct blkid_struct_probe
 #define BLKID_FL_CDROM_DEV	(1 << 3)	/* is a CD/DVD drive */
 #define BLKID_FL_NOSCAN_DEV	(1 << 4)	/* do not scan this device */
 #define BLKID_FL_MODIF_BUFF	(1 << 5)	/* cached buffers has been modified */
+#define BLKID_FL_NOURING	(1 << 6)	/* io_uring is not available */
 
 /* private per-probing flags */
 #define BLKID_PROBE_FL_IGNORE_PT (1 << 1)	/* ignore partition table */
@@ -246,6 +273,7 @@ struct blkid_config {
 	int nevals;			/* number of elems in eval array */
 	int uevent;			/* SEND_UEVENT=<yes|not> option */
 	char *cachefile;		/* CACHE_FILE=<path> option */
+	unsigned int nthreads;		/* PROBE_THREADS=<number> option */
 };
 
 extern struct blkid_config *blkid_read_config(const char *filename)
@@ -266,11 +294,28 @@ extern void blkid_free_config(struct blkid_config *conf);
  */
 #define BLKID_PROBE_INTERVAL	200
 
+/*
+ * The cache watcher updates mtime of the <cachefile>.watch lock file every
+ * BLKID_WATCH_HEARTBEAT seconds. The cached data are trusted without the
+ * BLKID_PROBE_MIN limit only if the last heartbeat is not older than
+ * BLKID_WATCH_MAXAGE seconds (the watcher may hang with the lock).
+ */
+#define BLKID_WATCH_HEARTBEAT	30
+#define BLKID_WATCH_MAXAGE	(2 * BLKID_WATCH_HEARTBEAT)
+
+/*
+ * Maximal number of threads used to probe devices by blkid_probe_all(), see
+ * blkid_cache_set_probe_threads().
+ */
+#define BLKID_MAX_THREADS	64
+
 /* This describes an entire blkid cache file and probed devices.
  * We can traverse all of the found devices via bic_list.
  * We can traverse all of the tag types by bic_tags, which hold empty tags
  * for each tag type.  Those tags can be used as list_heads for iterating
  * through all devices with a specific tag type (e.g. LABEL).
+ * The tags are also hashed by NAME=value in bic_hash, which is what
+ * blkid_find_dev_with_tag() uses.
  */
 struct blkid_struct_cache
 {
@@ -278,13 +323,38 @@ struct blkid_struct_cache
 	struct list_head	bic_tags;	/* List head of all tag types */
 	time_t			bic_time;	/* Last probe time */
 	time_t			bic_ftime;	/* Mod time of the cachefile */
+	time_t			bic_wtime;	/* Last heartbeat of the watcher */
 	unsigned int		bic_flags;	/* Status flags of the cache */
 	char			*bic_filename;	/* filename of cache */
 	blkid_probe		probe;		/* low-level probing stuff */
+
+	unsigned int		bic_nthreads;	/* number of probing threads */
+	struct blkid_prefetch	*bic_prefetch;	/* result for blkid_verify() or NULL */
+
+	struct list_head	*bic_hash;	/* NAME=value hash buckets (tag.c) */
+	size_t			bic_nbuckets;	/* number of buckets in bic_hash */
+	size_t			bic_nhashed;	/* number of tags in bic_hash */
+};
+
+/*
+ * Device probed in advance by a worker thread, see devname.c
+ */
+struct blkid_prefetch {
+	char		*ptname;	/* name in /sys/block */
+	dev_t		devno;		/* device number */
+	int		only_if_new;	/* probe_one() argument */
+
+	unsigned int	noprobe : 1;	/* don't probe in advance */
+	blkid_dev	dev;		/* detached device with probed tags */
+	int		rc;		/* 0 found, 1 nothing found, <0 not probed */
 };
 
 #define BLKID_BIC_FL_PROBED	0x0002	/* We probed /proc/partition devices */
 #define BLKID_BIC_FL_CHANGED	0x0004	/* Cache has changed from disk */
+#define BLKID_BIC_FL_WATCHED	0x0008	/* Cache file is kept up to date by uevents */
+#define BLKID_BIC_FL_READ	0x0010	/* Cache file has been read */
+
+#define BLKID_TAG_HASH_MINSZ	64	/* initial number of bic_hash buckets */
 
 /* config file */
 #define BLKID_CONFIG_FILE	"/etc/blkid.conf"
@@ -353,14 +423,70 @@ extern void blkid__scan_dir(char *, dev_t, struct dir_list **, char **)
 extern int blkid_driver_has_major(const char *drvname, int drvmaj)
 			__attribute__((warn_unused_result));
 
+/* verify.c */
+extern int blkid_verify_probe(blkid_probe pr, int fd, blkid_dev dev)
+			__attribute__((nonnull));
+
 /* read.c */
 extern void blkid_read_cache(blkid_cache cache)
 			__attribute__((nonnull));
+extern void blkid_read_cache_once(blkid_cache cache)
+			__attribute__((nonnull));
+
+/* bincache.c */
+struct blkid_bincache;
+
+extern struct blkid_bincache *blkid_bincache_open(const char *filename,
+					const struct stat *st)
+			__attribute__((nonnull))
+			__attribute__((warn_unused_result));
+extern void blkid_bincache_close(struct blkid_bincache *bc);
+extern const char *blkid_bincache_find_tag(struct blkid_bincache *bc,
+					const char *name, const char *value)
+			__attribute__((nonnull));
+extern char *blkid_bincache_get_devname(blkid_cache cache, const char *name,
+					const char *value)
+			__attribute__((nonnull));
+extern int blkid_bincache_read(blkid_cache cache, struct blkid_bincache *bc)
+			__attribute__((nonnull));
+extern int blkid_bincache_write(blkid_cache cache, const char *filename)
+			__attribute__((nonnull));
 
 /* save.c */
 extern int blkid_flush_cache(blkid_cache cache)
 			__attribute__((nonnull));
 
+/* uring.c */
+#ifdef HAVE_LINUX_IO_URING_H
+# include <sys/syscall.h>
+# if defined(SYS_io_uring_setup) && defined(SYS_io_uring_enter)
+#  define BLKID_USE_URING	1
+# endif
+#endif
+
+#define BLKID_URING_DEPTH	32	/* max. number of reads in one batch */
+
+struct blkid_uring;
+
+#ifdef BLKID_USE_URING
+extern struct blkid_uring *blkid_uring_new(unsigned int entries)
+			__attribute__((warn_unused_result));
+extern void blkid_uring_free(struct blkid_uring *ur);
+extern unsigned int blkid_uring_space(struct blkid_uring *ur)
+			__attribute__((nonnull));
+extern int blkid_uring_read(struct blkid_uring *ur, int fd, void *buf,
+			size_t len, uint64_t off, unsigned int idx)
+			__attribute__((nonnull));
+extern int blkid_uring_wait(struct blkid_uring *ur, int32_t *res)
+			__attribute__((nonnull));
+#endif
+
+/* uevent.c */
+extern int blkid_cache_is_watched(blkid_cache cache)
+			__attribute__((nonnull));
+extern int blkid_cache_trust_watcher(blkid_cache cache, time_t now)
+			__attribute__((nonnull));
+
 /* cache */
 extern char *blkid_safe_getenv(const char *arg)
 			__attribute__((nonnull))
@@ -379,6 +505,9 @@ extern blkid_tag blkid_find_tag_dev(blkid_dev dev, const char *type)
 extern int blkid_set_tag(blkid_dev dev, const char *name,
 			 const char *value, const int vlength)
 			__attribute__((nonnull(1,2)));
+extern uint32_t blkid_tag_hash(const char *name, const char *value)
+			__attribute__((nonnull));
+extern void blkid_free_tag_hash(blkid_cache cache);
 
 /*
  * Functions to create and find a specific tag type: dev.c
@@ -400,6 +529,9 @@ extern unsigned char *blkid_probe_get_buffer(blkid_probe pr,
 			__attribute__((nonnull))
 			__attribute__((warn_unused_result));
 
+extern int blkid_probe_readahead_idmags(blkid_probe pr, struct blkid_chain *chn)
+			__attribute__((nonnull));
+
 extern unsigned char *blkid_probe_get_sector(blkid_probe pr, unsigned int sector)
 			__attribute__((nonnull))
 			__attribute__((warn_unused_result));
@@ -441,14 +573,14 @@ extern struct blkid_prval *blkid_probe_assign_value(blkid_probe pr,
 			__attribute__((nonnull))
 			__attribute__((warn_unused_result));
 
-extern void blkid_probe_free_value(struct blkid_prval *v);
+extern void blkid_probe_free_value(blkid_probe pr, struct blkid_prval *v);
 
 
 extern void blkid_probe_append_values_list(blkid_probe pr,
 				    struct list_head *vals)
 			__attribute__((nonnull));
 
-extern void blkid_probe_free_values_list(struct list_head *vals);
+extern void blkid_probe_free_values_list(blkid_probe pr, struct list_head *vals);
 
 extern struct blkid_chain *blkid_probe_get_chain(blkid_probe pr)
 			__attribute__((nonnull))
@@ -482,6 +614,8 @@ extern struct blkid_prval *blkid_probe_new_val(void)
 extern int blkid_probe_set_value(blkid_probe pr, const char *name,
 				const unsigned char *data, size_t len)
 			__attribute__((nonnull));
+extern int blkid_probe_value_alloc_data(struct blkid_prval *v, size_t len)
+			__attribute__((nonnull));
 extern int blkid_probe_value_set_data(struct blkid_prval *v,
 				const unsigned char *data, size_t len)
 			__attribute__((nonnull));
@@ -93,6 +93,7 @@ char *blkid_get_cache_filename(struct blkid_config *conf)
 int blkid_get_cache(blkid_cache *ret_cache, const char *filename)
 {
 	blkid_cache cache;
+	struct blkid_config *conf;
 
 	if (!ret_cache)
 		return -BLKID_ERR_PARAM;
@@ -106,14 +107,22 @@ int blkid_get_cache(blkid_cache *ret_cache, const char *filename)
 	INIT_LIST_HEAD(&cache->bic_devs);
 	INIT_LIST_HEAD(&cache->bic_tags);
 
+	conf = blkid_read_config(NULL);
+	if (conf)
+		cache->bic_nthreads = conf->nthreads;
+
 	if (filename && !*filename)
 		filename = NULL;
 	if (filename)
 		cache->bic_filename = strdup(filename);
 	else
-		cache->bic_filename = blkid_get_cache_filename(NULL);
+		cache->bic_filename = blkid_get_cache_filename(conf);
+
+	blkid_free_config(conf);
 
-	blkid_read_cache(cache);
+	/* the cache file is read on the first access, see blkid_read_cache_once() */
+	if (blkid_cache_is_watched(cache))
+		cache->bic_flags |= BLKID_BIC_FL_WATCHED;
 	*ret_cache = cache;
 	return 0;
 }
@@ -159,6 +168,7 @@ void blkid_put_cache(blkid_cache cache)
 		}
 		blkid_free_tag(tag);
 	}
+	blkid_free_tag_hash(cache);
 
 	blkid_free_probe(cache->probe);
 
@@ -166,6 +176,37 @@ void blkid_put_cache(blkid_cache cache)
 	free(cache);
 }
 
+/**
+ * blkid_cache_set_probe_threads:
+ * @cache: cache handler
+ * @nthreads: number of threads
+ *
+ * Enables parallel probing in blkid_probe_all() and blkid_probe_all_new().
+ * The devices are probed by @nthreads worker threads, and the results are
+ * added to the @cache in the same order as by serial probing. The default is
+ * the PROBE_THREADS= option from blkid.conf; 0 or 1 means serial probing.
+ *
+ * The @cache is not thread-safe, don't use it from more threads.
+ *
+ * Returns: 0 on success, or -BLKID_ERR_PARAM for invalid arguments or if more
+ *          threads are requested and the library has been compiled without
+ *          threads support.
+ *
+ * Since: 2.37
+ */
+int blkid_cache_set_probe_threads(blkid_cache cache, unsigned int nthreads)
+{
+	if (!cache || nthreads > BLKID_MAX_THREADS)
+		return -BLKID_ERR_PARAM;
+#ifndef HAVE_LIBPTHREAD
+	if (nthreads > 1)
+		return -BLKID_ERR_PARAM;
+#endif
+	DBG(CACHE, ul_debugobj(cache, "set %u probing threads", nthreads));
+	cache->bic_nthreads = nthreads;
+	return 0;
+}
+
 /**
  * blkid_gc_cache:
  * @cache: cache handler
@@ -180,6 +221,8 @@ void blkid_gc_cache(blkid_cache cache)
 	if (!cache)
 		return;
 
+	blkid_read_cache_once(cache);
+
 	list_for_each_safe(p, pnext, &cache->bic_devs) {
 		blkid_dev dev = list_entry(p, struct blkid_struct_dev, bid_devs);
 		if (stat(dev->bid_name, &st) < 0) {
@@ -104,6 +104,19 @@ static int parse_next(FILE *fd, struct blkid_config *conf)
 		s += 9;
 		if (*s && parse_evaluate(conf, s) == -1)
 			return -1;
+	} else if (!strncmp(s, "PROBE_THREADS=", 14)) {
+		char *end = NULL;
+		unsigned long num;
+
+		s += 14;
+		errno = 0;
+		num = strtoul(s, &end, 10);
+		if (errno || !end || end == s || *end || num > BLKID_MAX_THREADS) {
+			DBG(CONFIG, ul_debug(
+				"config file: invalid number of threads '%s'.", s));
+			return -1;
+		}
+		conf->nthreads = num;
 	} else {
 		DBG(CONFIG, ul_debug(
 			"config file: unknown option '%s'.", s));
@@ -194,6 +207,7 @@ int main(int argc, char *argv[])
 
 	printf("SEND UEVENT: %s\n", conf->uevent ? "TRUE" : "FALSE");
 	printf("CACHE_FILE:  %s\n", conf->cachefile);
+	printf("THREADS:     %u\n", conf->nthreads);
 
 	blkid_free_config(conf);
 	return EXIT_SUCCESS;
@@ -34,6 +34,10 @@
 #endif
 #include <time.h>
 
+#ifdef HAVE_LIBPTHREAD
+# include <pthread.h>
+#endif
+
 #include "blkidP.h"
 
 #include "canonicalize.h"		/* $(top_srcdir)/include */
@@ -56,6 +60,8 @@ blkid_dev blkid_get_dev(blkid_cache cache, const char *devname, int flags)
 	if (!cache || !devname)
 		return NULL;
 
+	blkid_read_cache_once(cache);
+
 	/* search by name */
 	list_for_each(p, &cache->bic_devs) {
 		tmp = list_entry(p, struct blkid_struct_dev, bid_devs);
@@ -442,6 +448,180 @@ ubi_probe_all(blkid_cache cache, int only_if_new)
 	}
 }
 
+/*
+ * Parallel probing
+ *
+ * If enabled by blkid_cache_set_probe_threads(), sysfs_probe_all() does not
+ * call probe_one() for the devices, but it adds the devices to the queue. The
+ * queued devices are probed by worker threads (every thread uses its own
+ * prober and the results are stored in detached blkid_dev structs). The queue
+ * is then processed by probe_one() in the original order, and blkid_verify()
+ * uses the prefetched results rather than reads the devices again.
+ */
+#ifdef HAVE_LIBPTHREAD
+struct probe_queue {
+	struct blkid_prefetch	*items;
+	size_t			nitems;
+	size_t			size;
+
+	size_t			next;		/* next item for worker */
+	pthread_mutex_t		lock;
+};
+
+static int probe_queue_add(struct probe_queue *q, blkid_cache cache,
+			   const char *ptname, dev_t devno, int only_if_new)
+{
+	struct blkid_prefetch *pf;
+	struct list_head *p;
+
+	if (q->nitems == q->size) {
+		size_t sz = q->size ? q->size * 2 : 64;
+
+		pf = realloc(q->items, sz * sizeof(struct blkid_prefetch));
+		if (!pf)
+			return -BLKID_ERR_MEM;
+		q->items = pf;
+		q->size = sz;
+	}
+
+	pf = &q->items[q->nitems];
+	memset(pf, 0, sizeof(*pf));
+
+	pf->ptname = strdup(ptname);
+	if (!pf->ptname)
+		return -BLKID_ERR_MEM;
+	pf->devno = devno;
+	pf->only_if_new = only_if_new;
+	pf->rc = -1;
+
+	/* probe_one() will ignore the device, see the same check there */
+	if (only_if_new) {
+		list_for_each(p, &cache->bic_devs) {
+			blkid_dev tmp = list_entry(p, struct blkid_struct_dev,
+						   bid_devs);
+			if (tmp->bid_devno == devno && !access(tmp->bid_name, F_OK)) {
+				pf->noprobe = 1;
+				break;
+			}
+		}
+	}
+
+	q->nitems++;
+	return 0;
+}
+
+static void prefetch_one(blkid_probe pr, struct blkid_prefetch *pf)
+{
+	char device[256];
+	struct stat st;
+	int fd;
+
+	snprintf(device, sizeof(device), "/dev/%s", pf->ptname);
+
+	if (stat(device, &st) != 0 || st.st_rdev != pf->devno ||
+	    !(S_ISBLK(st.st_mode) ||
+	      (S_ISCHR(st.st_mode) && !strncmp(pf->ptname, "ubi", 3))))
+		return;		/* unusual device name, probe_one() will do it */
+
+	fd = open(device, O_RDONLY|O_CLOEXEC|O_NONBLOCK);
+	if (fd < 0)
+		return;
+
+	pf->dev = blkid_new_dev();
+	if (pf->dev) {
+		pf->rc = blkid_verify_probe(pr, fd, pf->dev);
+		if (pf->rc < 0) {
+			blkid_free_dev(pf->dev);
+			pf->dev = NULL;
+		}
+	}
+	close(fd);
+
+	DBG(DEVNAME, ul_debug(" prefetched %s [rc=%d]", device, pf->rc));
+}
+
+static void *prefetch_worker(void *data)
+{
+	struct probe_queue *q = (struct probe_queue *) data;
+	blkid_probe pr = blkid_new_probe();
+
+	if (!pr)
+		return NULL;
+
+	for (;;) {
+		struct blkid_prefetch *pf = NULL;
+
+		pthread_mutex_lock(&q->lock);
+		while (q->next < q->nitems) {
+			pf = &q->items[q->next++];
+			if (!pf->noprobe)
+				break;
+			pf = NULL;
+		}
+		pthread_mutex_unlock(&q->lock);
+
+		if (!pf)
+			break;
+		prefetch_one(pr, pf);
+	}
+
+	blkid_free_probe(pr);
+	return NULL;
+}
+
+static void probe_queue_prefetch(struct probe_queue *q, unsigned int nthreads)
+{
+	pthread_t threads[BLKID_MAX_THREADS];
+	unsigned int i, n = 0;
+
+	if (nthreads > q->nitems)
+		nthreads = q->nitems;
+	if (nthreads > BLKID_MAX_THREADS)
+		nthreads = BLKID_MAX_THREADS;
+
+	DBG(DEVNAME, ul_debug("prefetch %zu devices by %u threads", q->nitems, nthreads));
+
+	pthread_mutex_init(&q->lock, NULL);
+
+	/* the current thread is also a worker */
+	for (i = 1; i < nthreads; i++) {
+		if (pthread_create(&threads[n], NULL, prefetch_worker, q) != 0)
+			break;
+		n++;
+	}
+	prefetch_worker(q);
+
+	for (i = 0; i < n; i++)
+		pthread_join(threads[i], NULL);
+
+	pthread_mutex_destroy(&q->lock);
+}
+
+/*
+ * Probes all queued devices and adds them to the cache
+ */
+static void probe_queue_finish(struct probe_queue *q, blkid_cache cache)
+{
+	size_t i;
+
+	if (q->nitems)
+		probe_queue_prefetch(q, cache->bic_nthreads);
+	for (i = 0; i < q->nitems; i++) {
+		struct blkid_prefetch *pf = &q->items[i];
+
+		cache->bic_prefetch = pf;
+		probe_one(cache, pf->ptname, pf->devno, 0, pf->only_if_new, 0);
+		cache->bic_prefetch = NULL;
+
+		blkid_free_dev(pf->dev);
+		free(pf->ptname);
+	}
+
+	free(q->items);
+	memset(q, 0, sizeof(*q));
+}
+#endif /* HAVE_LIBPTHREAD */
+
 /*
  * This function uses /sys to read all block devices in way compatible with
  * /proc/partitions (like the original libblkid implementation)
@@ -451,11 +631,19 @@ sysfs_probe_all(blkid_cache cache, int only_if_new, int only_removable)
 {
 	DIR *sysfs;
 	struct dirent *dev;
+#ifdef HAVE_LIBPTHREAD
+	struct probe_queue queue = { .nitems = 0 }, *q = NULL;
+#endif
 
 	sysfs = opendir(_PATH_SYS_BLOCK);
 	if (!sysfs)
 		return -BLKID_ERR_SYSFS;
 
+#ifdef HAVE_LIBPTHREAD
+	if (cache->bic_nthreads > 1 && !only_removable)
+		q = &queue;
+#endif
+
 	/* scan /sys/block */
 	while ((dev = xreaddir(sysfs))) {
 		DIR *dir = NULL;
@@ -523,14 +711,20 @@ sysfs_probe_all(blkid_cache cache, int only_if_new, int only_removable)
 			DBG(DEVNAME, ul_debug(" Probe partition dev %s, devno 0x%04X",
                                    part->d_name, (unsigned int) partno));
 			nparts++;
-			probe_one(cache, part->d_name, partno, 0, only_if_new, 0);
+#ifdef HAVE_LIBPTHREAD
+			if (!q || probe_queue_add(q, cache, part->d_name, partno, only_if_new))
+#endif
+				probe_one(cache, part->d_name, partno, 0, only_if_new, 0);
 		}
 
 		if (!nparts) {
 			/* add non-partitioned whole disk to cache */
 			DBG(DEVNAME, ul_debug(" Probe whole dev %s, devno 0x%04X",
 				   dev->d_name, (unsigned int) devno));
-			probe_one(cache, dev->d_name, devno, 0, only_if_new, 0);
+#ifdef HAVE_LIBPTHREAD
+			if (!q || probe_queue_add(q, cache, dev->d_name, devno, only_if_new))
+#endif
+				probe_one(cache, dev->d_name, devno, 0, only_if_new, 0);
 		} else {
 			/* remove partitioned whole-disk from cache */
 			struct list_head *p, *pnext;
@@ -554,6 +748,10 @@ sysfs_probe_all(blkid_cache cache, int only_if_new, int only_removable)
 	}
 
 	closedir(sysfs);
+#ifdef HAVE_LIBPTHREAD
+	if (q)
+		probe_queue_finish(q, cache);
+#endif
 	return 0;
 }
 
@@ -658,8 +856,8 @@ int main(int argc, char **argv)
 	int ret;
 
 	blkid_init_debug(BLKID_DEBUG_ALL);
-	if (argc != 1) {
-		fprintf(stderr, "Usage: %s\n"
+	if (argc > 2) {
+		fprintf(stderr, "Usage: %s [<nthreads>]\n"
 			"Probe all devices and exit\n", argv[0]);
 		exit(1);
 	}
@@ -668,6 +866,11 @@ int main(int argc, char **argv)
 			argv[0], ret);
 		exit(1);
 	}
+	if (argc == 2 &&
+	    blkid_cache_set_probe_threads(cache, atoi(argv[1])) != 0) {
+		fprintf(stderr, "%s: unsupported number of threads\n", argv[0]);
+		exit(1);
+	}
 	if (blkid_probe_all(cache) < 0)
 		printf("%s: error probing devices\n", argv[0]);
 
@@ -1130,14 +1130,12 @@ int blkid_partitions_set_ptuuid(blkid_probe pr, unsigned char *uuid)
 	if (!v)
 		return -ENOMEM;
 
-	v->len = UUID_STR_LEN;
-	v->data = calloc(1, v->len);
-	if (v->data) {
+	if (blkid_probe_value_alloc_data(v, UUID_STR_LEN) == 0) {
 		blkid_unparse_uuid(uuid, (char *) v->data, v->len);
 		return 0;
 	}
 
-	blkid_probe_free_value(v);
+	blkid_probe_free_value(pr, v);
 	return -ENOMEM;
 }
 
@@ -121,6 +121,8 @@ static const struct blkid_chaindrv *chains_drvs[] = {
 };
 
 static void blkid_probe_reset_values(blkid_probe pr);
+static void free_values_pool(blkid_probe pr);
+static void free_buffers_pool(blkid_probe pr);
 
 /**
  * blkid_new_probe:
@@ -147,6 +149,8 @@ blkid_probe blkid_new_probe(void)
 	}
 	INIT_LIST_HEAD(&pr->buffers);
 	INIT_LIST_HEAD(&pr->values);
+	INIT_LIST_HEAD(&pr->free_buffers);
+	INIT_LIST_HEAD(&pr->free_values);
 	return pr;
 }
 
@@ -248,22 +252,32 @@ void blkid_free_probe(blkid_probe pr)
 		close(pr->fd);
 	blkid_probe_reset_buffers(pr);
 	blkid_probe_reset_values(pr);
+	free_buffers_pool(pr);
+	free_values_pool(pr);
 	blkid_free_probe(pr->disk_probe);
+#ifdef BLKID_USE_URING
+	blkid_uring_free(pr->uring);
+#endif
 
-	DBG(LOWPROBE, ul_debug("free probe"));
+	DBG(LOWPROBE, ul_debug("free probe [buffers: %zu allocated, %zu reused; "
+				"values: %zu allocated, %zu reused]",
+				pr->pool_stats.bufs_alloc, pr->pool_stats.bufs_reused,
+				pr->pool_stats.vals_alloc, pr->pool_stats.vals_reused));
 	free(pr);
 }
 
-void blkid_probe_free_value(struct blkid_prval *v)
+/*
+ * The value is not deallocated, it's moved to the pool of unused values.
+ */
+void blkid_probe_free_value(blkid_probe pr, struct blkid_prval *v)
 {
 	if (!v)
 		return;
 
-	list_del(&v->prvals);
-	free(v->data);
-
 	DBG(LOWPROBE, ul_debug(" free value %s", v->name));
-	free(v);
+
+	list_del(&v->prvals);
+	list_add(&v->prvals, &pr->free_values);
 }
 
 /*
@@ -284,7 +298,7 @@ void blkid_probe_chain_reset_values(blkid_probe pr, struct blkid_chain *chn)
 						struct blkid_prval, prvals);
 
 		if (v->chain == chn)
-			blkid_probe_free_value(v);
+			blkid_probe_free_value(pr, v);
 	}
 }
 
@@ -328,16 +342,25 @@ void blkid_probe_append_values_list(blkid_probe pr, struct list_head *vals)
 }
 
 
-void blkid_probe_free_values_list(struct list_head *vals)
+void blkid_probe_free_values_list(blkid_probe pr, struct list_head *vals)
 {
-	if (!vals)
+	if (!vals || list_empty(vals))
 		return;
 
 	DBG(LOWPROBE, ul_debug("freeing values list"));
 
-	while (!list_empty(vals)) {
-		struct blkid_prval *v = list_entry(vals->next, struct blkid_prval, prvals);
-		blkid_probe_free_value(v);
+	list_splice(vals, &pr->free_values);
+	INIT_LIST_HEAD(vals);
+}
+
+static void free_values_pool(blkid_probe pr)
+{
+	while (!list_empty(&pr->free_values)) {
+		struct blkid_prval *v = list_entry(pr->free_values.next,
+						struct blkid_prval, prvals);
+		list_del(&v->prvals);
+		free(v->data);
+		free(v);
 	}
 }
 
@@ -530,14 +553,49 @@ int __blkid_probe_filter_types(blkid_probe pr, int chain, int flag, char *names[
 	return 0;
 }
 
-static struct blkid_bufinfo *read_buffer(blkid_probe pr, uint64_t real_off, uint64_t len)
+static void free_buffers_pool(blkid_probe pr)
+{
+	while (!list_empty(&pr->free_buffers)) {
+		struct blkid_bufinfo *bf = list_entry(pr->free_buffers.next,
+						struct blkid_bufinfo, bufs);
+		list_del(&bf->bufs);
+		free(bf);
+	}
+	pr->free_bufs_size = 0;
+}
+
+/* returns unused buffer to the pool */
+static void release_buffer(blkid_probe pr, struct blkid_bufinfo *bf)
+{
+	list_add(&bf->bufs, &pr->free_buffers);
+	pr->free_bufs_size += bf->size;
+}
+
+/* adds buffer with data to the list of the probing buffers */
+static void add_buffer(blkid_probe pr, struct blkid_bufinfo *bf)
+{
+	list_add_tail(&bf->bufs, &pr->buffers);
+	pr->nbuffers++;
+	pr->bufs_size += bf->len;
+}
+
+static struct blkid_bufinfo *new_buffer(blkid_probe pr, uint64_t real_off, uint64_t len)
 {
-	ssize_t ret;
 	struct blkid_bufinfo *bf = NULL;
+	struct list_head *p;
 
-	if (lseek(pr->fd, real_off, SEEK_SET) == (off_t) -1) {
-		errno = 0;
-		return NULL;
+	/* the smallest large enough buffer from the pool */
+	list_for_each(p, &pr->free_buffers) {
+		struct blkid_bufinfo *x = list_entry(p, struct blkid_bufinfo, bufs);
+
+		if (x->size >= len && (!bf || x->size < bf->size))
+			bf = x;
+	}
+	if (bf) {
+		list_del(&bf->bufs);
+		pr->free_bufs_size -= bf->size;
+		pr->pool_stats.bufs_reused++;
+		goto done;
 	}
 
 	/* someone trying to overflow some buffers? */
@@ -554,9 +612,28 @@ static struct blkid_bufinfo *read_buffer(blkid_probe pr, uint64_t real_off, uint
 	}
 
 	bf->data = ((unsigned char *) bf) + sizeof(struct blkid_bufinfo);
+	bf->size = len;
+	pr->pool_stats.bufs_alloc++;
+done:
 	bf->len = len;
 	bf->off = real_off;
 	INIT_LIST_HEAD(&bf->bufs);
+	return bf;
+}
+
+static struct blkid_bufinfo *read_buffer(blkid_probe pr, uint64_t real_off, uint64_t len)
+{
+	ssize_t ret;
+	struct blkid_bufinfo *bf = NULL;
+
+	if (lseek(pr->fd, real_off, SEEK_SET) == (off_t) -1) {
+		errno = 0;
+		return NULL;
+	}
+
+	bf = new_buffer(pr, real_off, len);
+	if (!bf)
+		return NULL;
 
 	DBG(LOWPROBE, ul_debug("\tread: off=%"PRIu64" len=%"PRIu64"",
 	                       real_off, len));
@@ -564,7 +641,7 @@ static struct blkid_bufinfo *read_buffer(blkid_probe pr, uint64_t real_off, uint
 	ret = read(pr->fd, bf->data, len);
 	if (ret != (ssize_t) len) {
 		DBG(LOWPROBE, ul_debug("\tread failed: %m"));
-		free(bf);
+		release_buffer(pr, bf);
 
 		/* I/O errors on CDROMs are non-fatal to work with hybrid
 		 * audio+data disks */
@@ -679,7 +756,7 @@ unsigned char *blkid_probe_get_buffer(blkid_probe pr, uint64_t off, uint64_t len
 		if (!bf)
 			return NULL;
 
-		list_add_tail(&bf->bufs, &pr->buffers);
+		add_buffer(pr, bf);
 	}
 
 	assert(bf->off <= real_off);
@@ -689,6 +766,270 @@ unsigned char *blkid_probe_get_buffer(blkid_probe pr, uint64_t off, uint64_t len
 	return real_off ? bf->data + (real_off - bf->off) : bf->data;
 }
 
+/*
+ * Read-ahead for chains with magic strings.
+ *
+ * The probing functions read their magic strings by blkid_probe_get_idmag()
+ * in 1KiB areas, which is a lot of small read() calls scattered over the first
+ * MiBs of the device. This function collects the areas of all enabled probers
+ * in the chain, merges the near areas into a few large extents and reads the
+ * extents in advance. The later blkid_probe_get_buffer() calls are served from
+ * the cached buffers.
+ *
+ * If io_uring is available then all the extents are submitted at once.
+ */
+#define BLKID_RA_MAXGAP		(64 * 1024)	/* max. hole merged into extent */
+#define BLKID_RA_MAXLEN		(256 * 1024)	/* max. size of the extent */
+#define BLKID_RA_TAILSZ		(128 * 1024)	/* RAIDs and backup GPT at the end */
+#define BLKID_RA_HEADSZ		(8 * 1024)	/* MBR and GPT header */
+
+struct blkid_ra_extent {
+	uint64_t	off;
+	uint64_t	end;
+	size_t		nareas;		/* number of merged areas */
+};
+
+struct blkid_readahead {
+	struct blkid_ra_extent	*ex;
+	size_t			nex;
+	size_t			nalloc;
+};
+
+static int cmp_ra_extents(const void *a, const void *b)
+{
+	const struct blkid_ra_extent *x = a, *y = b;
+
+	return x->off < y->off ? -1 : x->off > y->off ? 1 : 0;
+}
+
+static int ra_add_area(blkid_probe pr, struct blkid_readahead *ra,
+		       uint64_t off, uint64_t len)
+{
+	struct blkid_ra_extent *ex;
+
+	if (!len || off + len > pr->size)
+		return 0;
+
+	if (ra->nex == ra->nalloc) {
+		ex = realloc(ra->ex, (ra->nalloc + 64) * sizeof(*ex));
+		if (!ex)
+			return -ENOMEM;
+		ra->ex = ex;
+		ra->nalloc += 64;
+	}
+
+	ex = &ra->ex[ra->nex++];
+	ex->off = off;
+	ex->end = off + len;
+	ex->nareas = 1;
+	return 0;
+}
+
+static int ra_add_idmags(blkid_probe pr, struct blkid_readahead *ra,
+			 struct blkid_chain *chn)
+{
+	const struct blkid_chaindrv *drv = chn->driver;
+	size_t i;
+
+	for (i = 0; i < drv->nidinfos; i++) {
+		const struct blkid_idinfo *id = drv->idinfos[i];
+		const struct blkid_idmag *mag = &id->magics[0];
+
+		if (chn->fltr && blkid_bmp_get_item(chn->fltr, i))
+			continue;
+		if (id->minsz && (unsigned) id->minsz > pr->size)
+			continue;
+
+		for ( ; mag->magic; mag++) {
+			if (mag->kboff < 0)
+				continue;
+
+			/* the same area as in blkid_probe_get_idmag() */
+			if (ra_add_area(pr, ra,
+					(mag->kboff + (mag->sboff >> 10)) << 10,
+					1024) != 0)
+				return -ENOMEM;
+		}
+	}
+	return 0;
+}
+
+#ifdef BLKID_USE_URING
+/*
+ * Submits reads of all not yet cached extents by io_uring. The failed extents
+ * are ignored, the caller reads them again by read().
+ *
+ * Returns: number of extents read.
+ */
+static size_t ra_read_uring(blkid_probe pr, struct blkid_ra_extent *ex, size_t nex)
+{
+	struct blkid_bufinfo *bfs[BLKID_URING_DEPTH];
+	int32_t res[BLKID_URING_DEPTH];
+	size_t i = 0, done = 0;
+
+	if (pr->flags & BLKID_FL_NOURING)
+		return 0;
+	if (!pr->uring) {
+		pr->uring = blkid_uring_new(BLKID_URING_DEPTH);
+		if (!pr->uring) {
+			pr->flags |= BLKID_FL_NOURING;
+			return 0;
+		}
+	}
+
+	while (i < nex) {
+		unsigned int n = 0, k;
+
+		for ( ; i < nex && blkid_uring_space(pr->uring); i++) {
+			uint64_t len = ex[i].end - ex[i].off;
+			struct blkid_bufinfo *bf;
+
+			if (get_cached_buffer(pr, ex[i].off, len))
+				continue;
+			bf = new_buffer(pr, pr->off + ex[i].off, len);
+			if (!bf)
+				break;
+			if (blkid_uring_read(pr->uring, pr->fd, bf->data, len,
+					     bf->off, n) != 0) {
+				release_buffer(pr, bf);
+				break;
+			}
+			res[n] = -EIO;
+			bfs[n++] = bf;
+		}
+		if (!n)
+			break;
+
+		if (blkid_uring_wait(pr->uring, res) != 0) {
+			for (k = 0; k < n; k++)
+				release_buffer(pr, bfs[k]);
+			blkid_uring_free(pr->uring);
+			pr->uring = NULL;
+			pr->flags |= BLKID_FL_NOURING;
+			break;
+		}
+
+		for (k = 0; k < n; k++) {
+			DBG(LOWPROBE, ul_debug("\turing read: off=%"PRIu64" len=%"PRIu64" [rc=%d]",
+						bfs[k]->off, bfs[k]->len, res[k]));
+			if (res[k] >= 0 && (uint64_t) res[k] == bfs[k]->len) {
+				add_buffer(pr, bfs[k]);
+				done++;
+			} else
+				release_buffer(pr, bfs[k]);
+		}
+	}
+	return done;
+}
+#endif
+
+/*
+ * Merges the areas and reads the result. Errors are not fatal here, the areas
+ * will be read later one by one by the probing functions.
+ */
+static int ra_read(blkid_probe pr, struct blkid_readahead *ra)
+{
+	struct blkid_ra_extent *ex = ra->ex;
+	size_t i, n, nex = ra->nex, nareas = 0, nreads = 0, nuring = 0;
+	uint64_t prev;
+
+	if (!nex)
+		goto done;
+
+	qsort(ex, nex, sizeof(struct blkid_ra_extent), cmp_ra_extents);
+
+	/* merge areas to extents, the result is stored in the begin of the array */
+	for (i = 1, n = 0, prev = ex[0].off; i < nex; i++) {
+		struct blkid_ra_extent *cur = &ex[n];
+
+		if (ex[i].off == prev && ex[i].end <= cur->end)
+			continue;			/* duplicate area */
+		prev = ex[i].off;
+		if (ex[i].off <= cur->end + BLKID_RA_MAXGAP
+		    && ex[i].end - cur->off <= BLKID_RA_MAXLEN) {
+			cur->end = max(cur->end, ex[i].end);
+			cur->nareas++;
+			continue;
+		}
+		ex[++n] = ex[i];
+	}
+	nex = n + 1;
+
+#ifdef BLKID_USE_URING
+	if (nex > 1 && !pr->parent)
+		nuring = ra_read_uring(pr, ex, nex);
+#endif
+	for (i = 0; i < nex; i++) {
+		DBG(BUFFER, ul_debug("\tread-ahead: off=%"PRIu64" len=%"PRIu64" (%zu areas)",
+					ex[i].off, ex[i].end - ex[i].off, ex[i].nareas));
+
+		/* already read (by io_uring or by previous read-ahead) */
+		if (get_cached_buffer(pr, ex[i].off, ex[i].end - ex[i].off)) {
+			nareas += ex[i].nareas;
+			continue;
+		}
+		if (!blkid_probe_get_buffer(pr, ex[i].off, ex[i].end - ex[i].off))
+			continue;
+		nreads++;
+		nareas += ex[i].nareas;
+	}
+	nreads += nuring;
+	errno = 0;
+done:
+	DBG(BUFFER, ul_debug("read-ahead summary: %zu areas by %zu reads (%zu by io_uring)",
+				nareas, nreads, nuring));
+	return 0;
+}
+
+int blkid_probe_readahead_idmags(blkid_probe pr, struct blkid_chain *chn)
+{
+	struct blkid_readahead ra = { .nex = 0 };
+	int rc;
+
+	if (S_ISCHR(pr->mode) || pr->size == 0)
+		return 0;
+
+	rc = ra_add_idmags(pr, &ra, chn);
+	if (!rc)
+		rc = ra_read(pr, &ra);
+	free(ra.ex);
+	return rc;
+}
+
+/*
+ * Reads in advance all areas usually needed by the enabled chains: magic
+ * strings, begin of the device (MBR, GPT header) and end of the device (backup
+ * GPT header, RAID superblocks). Used by blkid_do_safeprobe() and
+ * blkid_do_fullprobe().
+ */
+static int blkid_probe_readahead(blkid_probe pr)
+{
+	struct blkid_readahead ra = { .nex = 0 };
+	struct blkid_chain *sb = &pr->chains[BLKID_CHAIN_SUBLKS],
+			   *pt = &pr->chains[BLKID_CHAIN_PARTS];
+	int rc = 0;
+
+	if (S_ISCHR(pr->mode) || pr->size == 0 || (!sb->enabled && !pt->enabled))
+		return 0;
+
+	if (sb->enabled)
+		rc = ra_add_idmags(pr, &ra, sb);
+	if (!rc && pt->enabled) {
+		rc = ra_add_idmags(pr, &ra, pt);
+		if (!rc)
+			rc = ra_add_area(pr, &ra, 0, min(pr->size, (uint64_t) BLKID_RA_HEADSZ));
+	}
+	if (!rc) {
+		uint64_t off = pr->size > BLKID_RA_TAILSZ ?
+				(pr->size - BLKID_RA_TAILSZ) & ~((uint64_t) 4095) : 0;
+		rc = ra_add_area(pr, &ra, off, pr->size - off);
+	}
+	if (!rc)
+		rc = ra_read(pr, &ra);
+	free(ra.ex);
+	return rc;
+}
+
 /**
  * blkid_probe_reset_buffers:
  * @pr: prober
@@ -702,7 +1043,7 @@ unsigned char *blkid_probe_get_buffer(blkid_probe pr, uint64_t off, uint64_t len
  */
 int blkid_probe_reset_buffers(blkid_probe pr)
 {
-	uint64_t ct = 0, len = 0;
+	struct list_head *p;
 
 	pr->flags &= ~BLKID_FL_MODIF_BUFF;
 
@@ -711,23 +1052,25 @@ int blkid_probe_reset_buffers(blkid_probe pr)
 
 	DBG(BUFFER, ul_debug("Resetting probing buffers"));
 
-	while (!list_empty(&pr->buffers)) {
-		struct blkid_bufinfo *bf = list_entry(pr->buffers.next,
-						struct blkid_bufinfo, bufs);
-		ct++;
-		len += bf->len;
-		list_del(&bf->bufs);
-
-		DBG(BUFFER, ul_debug(" remove buffer: [off=%"PRIu64", len=%"PRIu64"]",
-		                     bf->off, bf->len));
-		free(bf);
+	/* the buffers are not deallocated, they are reused by the next read */
+	list_for_each(p, &pr->buffers) {
+		struct blkid_bufinfo *bf = list_entry(p, struct blkid_bufinfo, bufs);
+		pr->free_bufs_size += bf->size;
 	}
-
-	DBG(LOWPROBE, ul_debug(" buffers summary: %"PRIu64" bytes by %"PRIu64" read() calls",
-			len, ct));
-
+	list_splice(&pr->buffers, &pr->free_buffers);
 	INIT_LIST_HEAD(&pr->buffers);
 
+	DBG(LOWPROBE, ul_debug(" buffers summary: %"PRIu64" bytes by %"PRIu64" read() calls",
+			pr->bufs_size, pr->nbuffers));
+	pr->bufs_size = 0;
+	pr->nbuffers = 0;
+
+	/* don't keep too much memory in the pool */
+	if (pr->free_bufs_size > BLKID_POOL_MAXSZ) {
+		DBG(BUFFER, ul_debug(" pool too large (%"PRIu64" bytes), freeing",
+					pr->free_bufs_size));
+		free_buffers_pool(pr);
+	}
 	return 0;
 }
 
@@ -767,7 +1110,7 @@ static void blkid_probe_reset_values(blkid_probe pr)
 	while (!list_empty(&pr->values)) {
 		struct blkid_prval *v = list_entry(pr->values.next,
 						struct blkid_prval, prvals);
-		blkid_probe_free_value(v);
+		blkid_probe_free_value(pr, v);
 	}
 
 	INIT_LIST_HEAD(&pr->values);
@@ -1370,6 +1713,7 @@ int blkid_do_safeprobe(blkid_probe pr)
 		return 1;
 
 	blkid_probe_start(pr);
+	blkid_probe_readahead(pr);
 
 	for (i = 0; i < BLKID_NCHAINS; i++) {
 		struct blkid_chain *chn;
@@ -1424,6 +1768,7 @@ int blkid_do_fullprobe(blkid_probe pr)
 		return 1;
 
 	blkid_probe_start(pr);
+	blkid_probe_readahead(pr);
 
 	for (i = 0; i < BLKID_NCHAINS; i++) {
 		struct blkid_chain *chn;
@@ -1468,9 +1813,18 @@ struct blkid_prval *blkid_probe_assign_value(blkid_probe pr, const char *name)
 {
 	struct blkid_prval *v;
 
-	v = calloc(1, sizeof(struct blkid_prval));
-	if (!v)
-		return NULL;
+	if (!list_empty(&pr->free_values)) {
+		/* reuse unused value, keep the data buffer */
+		v = list_entry(pr->free_values.next, struct blkid_prval, prvals);
+		list_del(&v->prvals);
+		v->len = 0;
+		pr->pool_stats.vals_reused++;
+	} else {
+		v = calloc(1, sizeof(struct blkid_prval));
+		if (!v)
+			return NULL;
+		pr->pool_stats.vals_alloc++;
+	}
 
 	INIT_LIST_HEAD(&v->prvals);
 	v->name = name;
@@ -1489,15 +1843,35 @@ struct blkid_prval *blkid_probe_assign_value(blkid_probe pr, const char *name)
 int blkid_probe_value_set_data(struct blkid_prval *v,
 		const unsigned char *data, size_t len)
 {
-	v->data = calloc(1, len + 1);	/* always terminate by \0 */
+	int rc = blkid_probe_value_alloc_data(v, len + 1); /* always terminate by \0 */
 
-	if (!v->data)
-		return -ENOMEM;
+	if (rc)
+		return rc;
 	memcpy(v->data, data, len);
 	v->len = len;
 	return 0;
 }
 
+/*
+ * Allocates zeroized @len bytes for the value data and sets the value length.
+ * The data buffer of the reused value is reused if it's large enough.
+ */
+int blkid_probe_value_alloc_data(struct blkid_prval *v, size_t len)
+{
+	if (v->datasz < len) {
+		size_t sz = max(len, (size_t) BLKID_PRVAL_MINSZ);
+		unsigned char *data = realloc(v->data, sz);
+
+		if (!data)
+			return -ENOMEM;
+		v->data = data;
+		v->datasz = sz;
+	}
+	memset(v->data, 0, len);
+	v->len = len;
+	return 0;
+}
+
 int blkid_probe_set_value(blkid_probe pr, const char *name,
 		const unsigned char *data, size_t len)
 {
@@ -1514,16 +1888,26 @@ int blkid_probe_vsprintf_value(blkid_probe pr, const char *name,
 		const char *fmt, va_list ap)
 {
 	struct blkid_prval *v;
-	ssize_t len;
+	va_list ap2;
+	int len;
 
 	v = blkid_probe_assign_value(pr, name);
 	if (!v)
 		return -ENOMEM;
 
-	len = vasprintf((char **) &v->data, fmt, ap);
+	/* try to print to the (reused) data buffer first */
+	va_copy(ap2, ap);
+	len = vsnprintf((char *) v->data, v->datasz, fmt, ap2);
+	va_end(ap2);
 
+	if (len > 0 && (size_t) len >= v->datasz) {
+		if (blkid_probe_value_alloc_data(v, len + 1) != 0)
+			len = -1;
+		else
+			len = vsnprintf((char *) v->data, v->datasz, fmt, ap);
+	}
 	if (len <= 0) {
-		blkid_probe_free_value(v);
+		blkid_probe_free_value(pr, v);
 		return len == 0 ? -EINVAL : -ENOMEM;
 	}
 	v->len = len + 1;
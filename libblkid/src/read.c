@@ -366,6 +366,9 @@ void blkid_read_cache(blkid_cache cache)
 	char buf[4096];
 	int fd, lineno = 0;
 	struct stat st;
+	struct blkid_bincache *bc;
+
+	cache->bic_flags |= BLKID_BIC_FL_READ;
 
 	/*
 	 * If the file doesn't exist, then we just return an empty
@@ -382,6 +385,26 @@ void blkid_read_cache(blkid_cache cache)
 		goto errout;
 	}
 
+	/* try binary version of the cache file first */
+	bc = blkid_bincache_open(cache->bic_filename, &st);
+	if (bc) {
+		int rc = blkid_bincache_read(cache, bc);
+
+		blkid_bincache_close(bc);
+		if (rc == 0) {
+			DBG(CACHE, ul_debug("read binary cache for %s",
+						cache->bic_filename));
+			close(fd);
+			goto done;
+		}
+		/* corrupted binary file, start again from the text file */
+		while (!list_empty(&cache->bic_devs)) {
+			blkid_dev dev = list_entry(cache->bic_devs.next,
+					struct blkid_struct_dev, bid_devs);
+			blkid_free_dev(dev);
+		}
+	}
+
 	DBG(CACHE, ul_debug("reading cache file %s",
 				cache->bic_filename));
 
@@ -410,7 +433,7 @@ void blkid_read_cache(blkid_cache cache)
 		}
 	}
 	fclose(file);
-
+done:
 	/*
 	 * Initially we do not need to write out the cache file.
 	 */
@@ -422,6 +445,17 @@ errout:
 	close(fd);
 }
 
+/*
+ * Reads the cache file on the first access to the devices. The read is
+ * postponed by blkid_get_cache(), so blkid_get_devname() is able to use the
+ * binary cache without reading all the cache.
+ */
+void blkid_read_cache_once(blkid_cache cache)
+{
+	if (!(cache->bic_flags & BLKID_BIC_FL_READ))
+		blkid_read_cache(cache);
+}
+
 #ifdef TEST_PROGRAM
 
 int main(int argc, char**argv)
@@ -438,6 +472,8 @@ int main(int argc, char**argv)
 	if ((ret = blkid_get_cache(&cache, argv[1])) < 0)
 		fprintf(stderr, "error %d reading cache file %s\n", ret,
 			argv[1] ? argv[1] : blkid_get_cache_filename(NULL));
+	else
+		blkid_read_cache(cache);
 
 	blkid_put_cache(cache);
 
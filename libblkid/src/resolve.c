@@ -82,6 +82,11 @@ char *blkid_get_devname(blkid_cache cache, const char *token,
 		value = v;
 	}
 
+	/* try the binary cache without reading all the cache */
+	ret = blkid_bincache_get_devname(c, token, value);
+	if (ret)
+		goto out;
+
 	dev = blkid_find_dev_with_tag(c, token, value);
 	if (!dev)
 		goto out;
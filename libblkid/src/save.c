@@ -199,6 +199,11 @@ int blkid_flush_cache(blkid_cache cache)
 		}
 	}
 
+	/* binary version of the file; it's ignored when the text file is
+	 * modified without the binary file, so errors are not fatal */
+	if (ret == 1)
+		blkid_bincache_write(cache, filename);
+
 errout:
 	free(tmp);
 	if (filename != cache->bic_filename)
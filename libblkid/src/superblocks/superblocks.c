@@ -186,6 +186,171 @@ const struct blkid_chaindrv superblocks_drv = {
 	.safeprobe    = superblocks_safeprobe,
 };
 
+#ifdef HAVE_TLS
+# define THREAD_LOCAL static __thread
+#else
+# define THREAD_LOCAL static
+#endif
+
+/*
+ * Magic strings index
+ *
+ * All magic strings from idinfos[] sorted by offset and by the first byte of
+ * the magic string. The index is built only once (per thread) and it's used to
+ * find candidate probers by one lookup for each magic string offset rather than
+ * to call blkid_probe_get_idmag() for all probers. The probers without magic
+ * strings are not in the index and they are always called.
+ */
+#define SB_MAGIC_INDEX_MAX	256
+
+struct sb_magic_ent {
+	const struct blkid_idmag *mag;
+	uint32_t	off;		/* offset of the magic string */
+	uint16_t	idx;		/* index in idinfos[] */
+};
+
+THREAD_LOCAL struct sb_magic_ent magic_index[SB_MAGIC_INDEX_MAX];
+THREAD_LOCAL size_t magic_index_sz;
+THREAD_LOCAL int magic_index_ready;
+
+static int cmp_magic_ents(const void *a, const void *b)
+{
+	const struct sb_magic_ent *x = a, *y = b;
+	unsigned char cx, cy;
+
+	if (x->off != y->off)
+		return x->off < y->off ? -1 : 1;
+
+	cx = (unsigned char) *x->mag->magic;
+	cy = (unsigned char) *y->mag->magic;
+	if (cx != cy)
+		return cx < cy ? -1 : 1;
+
+	/* keep idinfos[] order for the same magic byte */
+	return x->idx < y->idx ? -1 : x->idx > y->idx ? 1 : 0;
+}
+
+static int build_magic_index(void)
+{
+	size_t i, n = 0;
+
+	for (i = 0; i < ARRAY_SIZE(idinfos); i++) {
+		const struct blkid_idmag *mag = &idinfos[i]->magics[0];
+
+		for ( ; mag->magic; mag++) {
+			uint64_t off;
+
+			if (n >= SB_MAGIC_INDEX_MAX || mag->kboff < 0 || !mag->len)
+				goto failed;
+
+			off = ((mag->kboff + (mag->sboff >> 10)) << 10)
+				+ (mag->sboff & 0x3ff);
+			if (off > UINT32_MAX)
+				goto failed;
+
+			magic_index[n].mag = mag;
+			magic_index[n].off = off;
+			magic_index[n].idx = i;
+			n++;
+		}
+	}
+
+	qsort(magic_index, n, sizeof(struct sb_magic_ent), cmp_magic_ents);
+	magic_index_sz = n;
+	magic_index_ready = 1;
+
+	DBG(LOWPROBE, ul_debug("magic index: %zu magic strings", n));
+	return 0;
+failed:
+	DBG(LOWPROBE, ul_debug("magic index: unsupported magic, index disabled"));
+	magic_index_sz = 0;
+	magic_index_ready = -1;
+	return -1;
+}
+
+/* returns 1 if the prober @idx is not filtered out and fits the device */
+static int is_wanted_prober(blkid_probe pr, struct blkid_chain *chn, size_t idx)
+{
+	const struct blkid_idinfo *id = idinfos[idx];
+
+	if (chn->fltr && blkid_bmp_get_item(chn->fltr, idx))
+		return 0;
+	if (id->minsz && (unsigned) id->minsz > pr->size)
+		return 0;
+	return 1;
+}
+
+/*
+ * Sets bits in @cands for all probers with a magic string on the device. The
+ * areas are read only for the probers which will be used by the probing loop.
+ *
+ * Returns 0 on success, or <0 if the index cannot be used (and the probers
+ * have to check the magic strings by blkid_probe_get_idmag()).
+ */
+static int get_magic_candidates(blkid_probe pr, struct blkid_chain *chn,
+				unsigned long *cands)
+{
+	size_t i = 0, nlookups = 0;
+
+	if (!magic_index_ready)
+		build_magic_index();
+	if (magic_index_ready < 0)
+		return -1;
+
+	while (i < magic_index_sz) {
+		uint32_t off = magic_index[i].off;
+		size_t end, lo, hi;
+		unsigned char *buf;
+
+		/* all entries with the same offset */
+		for (end = i + 1; end < magic_index_sz
+				  && magic_index[end].off == off; end++);
+
+		/* don't read the area if no prober needs it */
+		for (lo = i; lo < end; lo++) {
+			if (is_wanted_prober(pr, chn, magic_index[lo].idx))
+				break;
+		}
+		if (lo == end) {
+			i = end;
+			continue;
+		}
+
+		/* the same area as in blkid_probe_get_idmag() */
+		buf = blkid_probe_get_buffer(pr, off & ~0x3ffULL, 1024);
+		if (!buf) {
+			if (errno)
+				return -errno;
+			i = end;
+			continue;	/* out of the device */
+		}
+		buf += off & 0x3ff;
+		nlookups++;
+
+		/* binary search for the first byte of the magic string */
+		for (lo = i, hi = end; lo < hi; ) {
+			size_t mid = lo + (hi - lo) / 2;
+
+			if ((unsigned char) *magic_index[mid].mag->magic < *buf)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+
+		for ( ; lo < end && (unsigned char) *magic_index[lo].mag->magic == *buf; lo++) {
+			const struct blkid_idmag *mag = magic_index[lo].mag;
+
+			if (memcmp(mag->magic, buf, mag->len) == 0)
+				blkid_bmp_set_item(cands, magic_index[lo].idx);
+		}
+		i = end;
+	}
+
+	DBG(LOWPROBE, ul_debug("magic index: %zu lookups for %zu magic strings",
+				nlookups, magic_index_sz));
+	return 0;
+}
+
 /**
  * blkid_probe_enable_superblocks:
  * @pr: probe
@@ -341,7 +506,8 @@ int blkid_superblocks_get_name(size_t idx, const char **name, int *usage)
 static int superblocks_probe(blkid_probe pr, struct blkid_chain *chn)
 {
 	size_t i;
-	int rc = BLKID_PROBE_NONE;
+	int rc = BLKID_PROBE_NONE, has_cands;
+	unsigned long cands[blkid_bmp_nwords(ARRAY_SIZE(idinfos))];
 
 	if (chn->idx < -1)
 		return -EINVAL;
@@ -364,6 +530,16 @@ static int superblocks_probe(blkid_probe pr, struct blkid_chain *chn)
 	DBG(LOWPROBE, ul_debug("--> starting probing loop [SUBLKS idx=%d]",
 		chn->idx));
 
+	/* read all magic strings areas by a few large read() calls */
+	if (chn->idx < 0)
+		blkid_probe_readahead_idmags(pr, chn);
+
+	/* the buffers may be modified by blkid_probe_hide_range() between
+	 * the calls, so the candidates are always evaluated again */
+	memset(cands, 0, sizeof(cands));
+	has_cands = get_magic_candidates(pr, chn, cands) == 0;
+	errno = 0;
+
 	i = chn->idx < 0 ? 0 : chn->idx + 1U;
 
 	for ( ; i < ARRAY_SIZE(idinfos); i++) {
@@ -398,6 +574,13 @@ static int superblocks_probe(blkid_probe pr, struct blkid_chain *chn)
 			continue;
 		}
 
+		/* magic string not found by index */
+		if (has_cands && id->magics[0].magic
+		    && !blkid_bmp_get_item(cands, i)) {
+			rc = BLKID_PROBE_NONE;
+			continue;
+		}
+
 		DBG(LOWPROBE, ul_debug("[%zd] %s:", i, id->name));
 
 		rc = blkid_probe_get_idmag(pr, id, &off, &mag);
@@ -525,7 +708,7 @@ static int superblocks_safeprobe(blkid_probe pr, struct blkid_chain *chn)
 
 	rc = BLKID_PROBE_OK;
 done:
-	blkid_probe_free_values_list(&vals);
+	blkid_probe_free_values_list(pr, &vals);
 	return rc;
 }
 
@@ -607,7 +790,7 @@ int blkid_probe_set_id_label(blkid_probe pr, const char *name,
 			return 0;
 	}
 
-	blkid_probe_free_value(v);
+	blkid_probe_free_value(pr, v);
 	return rc;
 
 }
@@ -626,10 +809,7 @@ int blkid_probe_set_utf8_id_label(blkid_probe pr, const char *name,
 	if (!v)
 		return -ENOMEM;
 
-	v->len = (len * 3) + 1;
-	v->data = calloc(1, v->len);
-	if (!v->data)
-		rc = -ENOMEM;
+	rc = blkid_probe_value_alloc_data(v, (len * 3) + 1);
 
 	if (!rc) {
 		ul_encode_to_utf8(enc, v->data, v->len, data, len);
@@ -640,7 +820,7 @@ int blkid_probe_set_utf8_id_label(blkid_probe pr, const char *name,
 			return 0;
 	}
 
-	blkid_probe_free_value(v);
+	blkid_probe_free_value(pr, v);
 	return rc;
 }
 
@@ -668,7 +848,7 @@ int blkid_probe_set_label(blkid_probe pr, const unsigned char *label, size_t len
 			return 0;
 	}
 
-	blkid_probe_free_value(v);
+	blkid_probe_free_value(pr, v);
 	return rc;
 }
 
@@ -690,10 +870,7 @@ int blkid_probe_set_utf8label(blkid_probe pr, const unsigned char *label,
 	if (!v)
 		return -ENOMEM;
 
-	v->len = (len * 3) + 1;
-	v->data = calloc(1, v->len);
-	if (!v->data)
-		rc = -ENOMEM;
+	rc = blkid_probe_value_alloc_data(v, (len * 3) + 1);
 	if (!rc) {
 		ul_encode_to_utf8(enc, v->data, v->len, label, len);
 		v->len = blkid_rtrim_whitespace(v->data) + 1;
@@ -701,7 +878,7 @@ int blkid_probe_set_utf8label(blkid_probe pr, const unsigned char *label,
 			return 0;
 	}
 
-	blkid_probe_free_value(v);
+	blkid_probe_free_value(pr, v);
 	return rc;
 }
 
@@ -760,7 +937,7 @@ int blkid_probe_strncpy_uuid(blkid_probe pr, const unsigned char *str, size_t le
 			return 0;
 	}
 
-	blkid_probe_free_value(v);
+	blkid_probe_free_value(pr, v);
 	return rc;
 }
 
@@ -789,17 +966,14 @@ int blkid_probe_set_uuid_as(blkid_probe pr, const unsigned char *uuid, const cha
 	if (!v)
 		return -ENOMEM;
 
-	v->len = UUID_STR_LEN;
-	v->data = calloc(1, v->len);
-	if (!v->data)
-		rc = -ENOMEM;
+	rc = blkid_probe_value_alloc_data(v, UUID_STR_LEN);
 
 	if (!rc) {
 		blkid_unparse_uuid(uuid, (char *) v->data, v->len);
 		return 0;
 	}
 
-	blkid_probe_free_value(v);
+	blkid_probe_free_value(pr, v);
 	return rc;
 }
 
@@ -27,10 +27,113 @@ static blkid_tag blkid_new_tag(void)
 	DBG(TAG, ul_debugobj(tag, "alloc"));
 	INIT_LIST_HEAD(&tag->bit_tags);
 	INIT_LIST_HEAD(&tag->bit_names);
+	INIT_LIST_HEAD(&tag->bit_hash);
 
 	return tag;
 }
 
+/*
+ * FNV-1a hash of the "NAME=value" string. The function is also used for the
+ * binary cache file, so don't change it.
+ */
+uint32_t blkid_tag_hash(const char *name, const char *value)
+{
+	uint32_t h = 2166136261U;
+	const unsigned char *p;
+
+	for (p = (const unsigned char *) name; *p; p++)
+		h = (h ^ *p) * 16777619U;
+	h = (h ^ '=') * 16777619U;
+	for (p = (const unsigned char *) value; *p; p++)
+		h = (h ^ *p) * 16777619U;
+	return h;
+}
+
+static struct list_head *tag_hash_bucket(blkid_cache cache,
+					 const char *name, const char *value)
+{
+	return &cache->bic_hash[blkid_tag_hash(name, value) % cache->bic_nbuckets];
+}
+
+static int tag_hash_resize(blkid_cache cache, size_t nbuckets)
+{
+	struct list_head *old = cache->bic_hash;
+	size_t i, nold = cache->bic_nbuckets;
+
+	cache->bic_hash = malloc(nbuckets * sizeof(struct list_head));
+	if (!cache->bic_hash) {
+		cache->bic_hash = old;
+		return -BLKID_ERR_MEM;
+	}
+
+	DBG(TAG, ul_debugobj(cache, "resize tags hash %zu -> %zu", nold, nbuckets));
+
+	cache->bic_nbuckets = nbuckets;
+	for (i = 0; i < nbuckets; i++)
+		INIT_LIST_HEAD(&cache->bic_hash[i]);
+
+	/* keep order of the tags within the buckets */
+	for (i = 0; i < nold; i++) {
+		while (!list_empty(&old[i])) {
+			blkid_tag t = list_entry(old[i].next,
+					struct blkid_struct_tag, bit_hash);
+			list_del(&t->bit_hash);
+			list_add_tail(&t->bit_hash,
+				tag_hash_bucket(cache, t->bit_name, t->bit_val));
+		}
+	}
+	free(old);
+	return 0;
+}
+
+/*
+ * Adds @tag to the NAME=value hash of the @cache. The hash is allocated on
+ * demand and grows when there are more than two tags per bucket.
+ */
+static int tag_hash_add(blkid_cache cache, blkid_tag tag)
+{
+	if (!cache->bic_hash) {
+		if (tag_hash_resize(cache, BLKID_TAG_HASH_MINSZ) != 0)
+			return -BLKID_ERR_MEM;
+	} else if (cache->bic_nhashed >= cache->bic_nbuckets * 2)
+		/* not fatal, longer chains only */
+		tag_hash_resize(cache, cache->bic_nbuckets * 4);
+
+	list_add_tail(&tag->bit_hash,
+		      tag_hash_bucket(cache, tag->bit_name, tag->bit_val));
+	cache->bic_nhashed++;
+	return 0;
+}
+
+static void tag_hash_remove(blkid_tag tag)
+{
+	if (list_empty(&tag->bit_hash))
+		return;		/* not hashed */
+
+	list_del_init(&tag->bit_hash);
+	if (tag->bit_dev && tag->bit_dev->bid_cache)
+		tag->bit_dev->bid_cache->bic_nhashed--;
+}
+
+void blkid_free_tag_hash(blkid_cache cache)
+{
+	size_t i;
+
+	if (!cache->bic_hash)
+		return;
+
+	for (i = 0; i < cache->bic_nbuckets; i++) {
+		while (!list_empty(&cache->bic_hash[i])) {
+			blkid_tag t = list_entry(cache->bic_hash[i].next,
+					struct blkid_struct_tag, bit_hash);
+			list_del_init(&t->bit_hash);
+		}
+	}
+	free(cache->bic_hash);
+	cache->bic_hash = NULL;
+	cache->bic_nbuckets = cache->bic_nhashed = 0;
+}
+
 void blkid_free_tag(blkid_tag tag)
 {
 	if (!tag)
@@ -40,6 +143,7 @@ void blkid_free_tag(blkid_tag tag)
 
 	list_del(&tag->bit_tags);	/* list of tags for this device */
 	list_del(&tag->bit_names);	/* list of tags with this type */
+	tag_hash_remove(tag);		/* NAME=value hash */
 
 	free(tag->bit_name);
 	free(tag->bit_val);
@@ -141,6 +245,13 @@ int blkid_set_tag(blkid_dev dev, const char *name,
 		DBG(TAG, ul_debugobj(t, "update (%s) '%s' -> '%s'", t->bit_name, t->bit_val, val));
 		free(t->bit_val);
 		t->bit_val = val;
+
+		/* rehash, the tag is already in the cache */
+		if (!list_empty(&t->bit_hash)) {
+			list_del(&t->bit_hash);
+			list_add_tail(&t->bit_hash,
+				tag_hash_bucket(dev->bid_cache, t->bit_name, val));
+		}
 	} else {
 		/* Existing tag not present, add to device */
 		if (!(t = blkid_new_tag()))
@@ -168,6 +279,11 @@ int blkid_set_tag(blkid_dev dev, const char *name,
 					      &dev->bid_cache->bic_tags);
 			}
 			list_add_tail(&t->bit_names, &head->bit_names);
+
+			if (tag_hash_add(dev->bid_cache, t) != 0) {
+				head = NULL;	/* linked to the cache */
+				goto errout;
+			}
 		}
 	}
 
@@ -322,7 +438,6 @@ blkid_dev blkid_find_dev_with_tag(blkid_cache cache,
 					 const char *type,
 					 const char *value)
 {
-	blkid_tag	head;
 	blkid_dev	dev;
 	int		pri;
 	struct list_head *p;
@@ -338,14 +453,14 @@ blkid_dev blkid_find_dev_with_tag(blkid_cache cache,
 try_again:
 	pri = -1;
 	dev = NULL;
-	head = blkid_find_head_cache(cache, type);
 
-	if (head) {
-		list_for_each(p, &head->bit_names) {
+	if (cache->bic_hash) {
+		list_for_each(p, tag_hash_bucket(cache, type, value)) {
 			blkid_tag tmp = list_entry(p, struct blkid_struct_tag,
-						   bit_names);
+						   bit_hash);
 
 			if (!strcmp(tmp->bit_val, value) &&
+			    !strcmp(tmp->bit_name, type) &&
 			    (tmp->bit_dev->bid_pri > pri) &&
 			    !access(tmp->bit_dev->bid_name, F_OK)) {
 				dev = tmp->bit_dev;
@@ -382,15 +497,128 @@ extern char *optarg;
 extern int optind;
 #endif
 
+#include <sys/time.h>
+
 static void __attribute__((__noreturn__)) usage(char *prog)
 {
 	fprintf(stderr, "Usage: %s [-f blkid_file] [-m debug_mask] device "
 		"[type value]\n",
 		prog);
 	fprintf(stderr, "\tList all tags for a device and exit\n");
+	fprintf(stderr, "       %s -b <ndevs>\n", prog);
+	fprintf(stderr, "\tResolve UUIDs of <ndevs> fake devices\n");
 	exit(1);
 }
 
+static double time_diff(struct timeval *a, struct timeval *b)
+{
+	return (a->tv_sec - b->tv_sec) + (a->tv_usec - b->tv_usec) / 1E6;
+}
+
+/* the original lookup, walks all tags of the given type */
+static blkid_dev find_dev_linear(blkid_cache cache, const char *type,
+				 const char *value)
+{
+	blkid_tag head = blkid_find_head_cache(cache, type);
+	blkid_dev dev = NULL;
+	struct list_head *p;
+	int pri = -1;
+
+	if (!head)
+		return NULL;
+	list_for_each(p, &head->bit_names) {
+		blkid_tag tmp = list_entry(p, struct blkid_struct_tag,
+					   bit_names);
+
+		if (!strcmp(tmp->bit_val, value) &&
+		    (tmp->bit_dev->bid_pri > pri) &&
+		    !access(tmp->bit_dev->bid_name, F_OK)) {
+			dev = tmp->bit_dev;
+			pri = dev->bid_pri;
+		}
+	}
+	return dev;
+}
+
+/*
+ * Creates @ndevs verified devices with random UUIDs and resolves all the
+ * UUIDs (in random order) by the hash and by the linear scan.
+ */
+static int benchmark(size_t ndevs)
+{
+	blkid_cache cache = NULL;
+	struct timeval start, end;
+	char **uuids;
+	size_t i;
+	int rc = 0;
+
+	if (blkid_get_cache(&cache, "/dev/null") != 0)
+		return 1;
+	uuids = calloc(ndevs, sizeof(char *));
+	if (!uuids)
+		return 1;
+
+	srand(getpid());
+	for (i = 0; i < ndevs; i++) {
+		blkid_dev dev = blkid_new_dev();
+		char buf[37];
+
+		if (!dev)
+			return 1;
+		dev->bid_name = strdup("/dev/null");
+		dev->bid_cache = cache;
+		dev->bid_flags |= BLKID_BID_FL_VERIFIED;
+		list_add_tail(&dev->bid_devs, &cache->bic_devs);
+
+		snprintf(buf, sizeof(buf), "%08x-%04x-%04x-%04x-%04x%08x",
+			 rand(), rand() & 0xffff, rand() & 0xffff,
+			 rand() & 0xffff, rand() & 0xffff, (unsigned) i);
+		uuids[i] = strdup(buf);
+		if (blkid_set_tag(dev, "TYPE", "ext4", 4) != 0 ||
+		    blkid_set_tag(dev, "UUID", buf, strlen(buf)) != 0)
+			return 1;
+	}
+	cache->bic_flags |= BLKID_BIC_FL_PROBED;
+
+	/* shuffle */
+	for (i = ndevs; i > 1; i--) {
+		size_t x = rand() % i;
+		char *tmp = uuids[x];
+
+		uuids[x] = uuids[i - 1];
+		uuids[i - 1] = tmp;
+	}
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < ndevs; i++) {
+		blkid_dev dev = blkid_find_dev_with_tag(cache, "UUID", uuids[i]);
+
+		if (!dev || !blkid_dev_has_tag(dev, "UUID", uuids[i]))
+			rc = 1;
+	}
+	gettimeofday(&end, NULL);
+	printf("hash:   %zu lookups in %.6f s\n", ndevs, time_diff(&end, &start));
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < ndevs; i++) {
+		if (!find_dev_linear(cache, "UUID", uuids[i]))
+			rc = 1;
+	}
+	gettimeofday(&end, NULL);
+	printf("linear: %zu lookups in %.6f s\n", ndevs, time_diff(&end, &start));
+
+	for (i = 0; i < ndevs; i++)
+		free(uuids[i]);
+	free(uuids);
+
+	cache->bic_flags &= ~BLKID_BIC_FL_CHANGED;
+	blkid_put_cache(cache);
+
+	if (rc)
+		fprintf(stderr, "lookup failed\n");
+	return rc;
+}
+
 int main(int argc, char **argv)
 {
 	blkid_tag_iterate	iter;
@@ -405,8 +633,10 @@ int main(int argc, char **argv)
 	char			*search_value = NULL;
 	const char		*type, *value;
 
-	while ((c = getopt (argc, argv, "m:f:")) != EOF)
+	while ((c = getopt (argc, argv, "b:m:f:")) != EOF)
 		switch (c) {
+		case 'b':
+			return benchmark(strtoul(optarg, NULL, 0));
 		case 'f':
 			file = optarg;
 			break;
@@ -0,0 +1,470 @@
+/*
+ * uevent.c - keep the cache up to date by kernel uevents
+ *
+ * This file may be redistributed under the terms of the
+ * GNU Lesser General Public License.
+ *
+ * The kernel sends a message to NETLINK_KOBJECT_UEVENT socket for every added,
+ * changed or removed device. The message is "ACTION@DEVPATH" followed by NUL
+ * separated KEY=value strings (ACTION=, SUBSYSTEM=, DEVNAME=, ...). The cache
+ * watcher re-probes only the devices from the block subsystem messages and
+ * writes the cache file after every batch of the messages.
+ *
+ * The watcher holds an exclusive lock on <cachefile>.watch and updates mtime
+ * of the file every BLKID_WATCH_HEARTBEAT seconds. If the lock is held by
+ * another process and the heartbeat is recent then blkid_verify() trusts the
+ * cached data (the device has not been modified since the last probing)
+ * without the usual BLKID_PROBE_MIN time limit.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#ifdef __linux__
+# include <linux/netlink.h>
+#endif
+
+#include "blkidP.h"
+
+#define UEVENT_BUFSZ	8192
+
+struct uevent {
+	const char	*action;
+	const char	*subsystem;
+	const char	*devname;
+};
+
+static char *get_watch_lockname(blkid_cache cache)
+{
+	char *name;
+	size_t sz;
+
+	if (!cache->bic_filename || !strcmp(cache->bic_filename, "/dev/null"))
+		return NULL;
+
+	sz = strlen(cache->bic_filename);
+	name = malloc(sz + sizeof(".watch"));
+	if (name) {
+		memcpy(name, cache->bic_filename, sz);
+		memcpy(name + sz, ".watch", sizeof(".watch"));
+	}
+	return name;
+}
+
+static inline int is_recent_heartbeat(time_t beat, time_t now)
+{
+	return now >= beat && now - beat < BLKID_WATCH_MAXAGE;
+}
+
+/*
+ * Returns 1 if there is a process which keeps the cache file up to date.
+ */
+int blkid_cache_is_watched(blkid_cache cache)
+{
+	char *lockname = get_watch_lockname(cache);
+	struct stat st;
+	int fd, rc = 0;
+
+	if (!lockname)
+		return 0;
+
+	fd = open(lockname, O_RDONLY|O_CLOEXEC);
+	if (fd >= 0) {
+		if (flock(fd, LOCK_SH|LOCK_NB) != 0 && errno == EWOULDBLOCK
+		    && fstat(fd, &st) == 0
+		    && is_recent_heartbeat(st.st_mtime, time(NULL))) {
+			cache->bic_wtime = st.st_mtime;
+			rc = 1;
+		}
+		close(fd);
+	}
+	free(lockname);
+
+	DBG(CACHE, ul_debugobj(cache, "watched: %s", rc ? "yes" : "no"));
+	return rc;
+}
+
+/*
+ * Returns 1 if the cached data may be used without re-probing, because the
+ * cache file has been recently updated by the watcher.
+ */
+int blkid_cache_trust_watcher(blkid_cache cache, time_t now)
+{
+	if (!(cache->bic_flags & BLKID_BIC_FL_WATCHED))
+		return 0;
+	if (is_recent_heartbeat(cache->bic_wtime, now))
+		return 1;
+
+	/* the heartbeat is old, the watcher has been probably restarted or
+	 * does not work anymore */
+	if (blkid_cache_is_watched(cache))
+		return 1;
+	cache->bic_flags &= ~BLKID_BIC_FL_WATCHED;
+	return 0;
+}
+
+/**
+ * blkid_cache_open_uevent:
+ *
+ * Opens the kernel uevent netlink socket for blkid_cache_process_uevents().
+ * The socket is non-blocking and close-on-exec.
+ *
+ * Returns: file descriptor or negative errno.
+ */
+int blkid_cache_open_uevent(void)
+{
+#ifdef __linux__
+	struct sockaddr_nl snl = {
+		.nl_family = AF_NETLINK,
+		.nl_groups = 1		/* kernel events */
+	};
+	int fd;
+
+	fd = socket(AF_NETLINK, SOCK_DGRAM|SOCK_CLOEXEC|SOCK_NONBLOCK,
+			NETLINK_KOBJECT_UEVENT);
+	if (fd < 0)
+		return -errno;
+	if (bind(fd, (struct sockaddr *) &snl, sizeof(snl)) != 0) {
+		int rc = -errno;
+		close(fd);
+		return rc;
+	}
+	DBG(CACHE, ul_debug("opened uevent socket [fd=%d]", fd));
+	return fd;
+#else
+	return -ENOSYS;
+#endif
+}
+
+/*
+ * Reads one message. Returns message size, 0 if the message has been ignored,
+ * or negative errno (-EPIPE if the other side of the socket has been closed).
+ */
+static ssize_t recv_uevent(int fd, char *buf, size_t bufsz)
+{
+	struct iovec iov = { .iov_base = buf, .iov_len = bufsz - 1 };
+	struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1 };
+	ssize_t sz;
+#ifdef __linux__
+	struct sockaddr_nl snl = { .nl_family = 0 };
+
+	msg.msg_name = &snl;
+	msg.msg_namelen = sizeof(snl);
+#endif
+	sz = recvmsg(fd, &msg, MSG_DONTWAIT);
+	if (sz < 0)
+		return -errno;
+	if (sz == 0)
+		return -EPIPE;
+	if (msg.msg_flags & MSG_TRUNC) {
+		DBG(CACHE, ul_debug("uevent: ignore truncated message"));
+		return 0;
+	}
+#ifdef __linux__
+	/* accept netlink messages from kernel only; socketpair() (used by
+	 * tests) does not provide the address at all */
+	if (msg.msg_namelen == sizeof(snl) && snl.nl_family == AF_NETLINK
+	    && snl.nl_pid != 0) {
+		DBG(CACHE, ul_debug("uevent: ignore message from pid %u", snl.nl_pid));
+		return 0;
+	}
+#endif
+	buf[sz] = '\0';
+	return sz;
+}
+
+static int parse_uevent(char *buf, size_t sz, struct uevent *ev)
+{
+	char *p, *end = buf + sz;
+
+	memset(ev, 0, sizeof(*ev));
+
+	/* the first string is ACTION@DEVPATH, udevd messages start with
+	 * "libudev" and binary header */
+	if (!strchr(buf, '@'))
+		return -EINVAL;
+
+	for (p = buf + strlen(buf) + 1; p < end; p += strlen(p) + 1) {
+		if (!strncmp(p, "ACTION=", 7))
+			ev->action = p + 7;
+		else if (!strncmp(p, "SUBSYSTEM=", 10))
+			ev->subsystem = p + 10;
+		else if (!strncmp(p, "DEVNAME=", 8))
+			ev->devname = p + 8;
+	}
+	if (!ev->action || !ev->subsystem)
+		return -EINVAL;
+	return 0;
+}
+
+/*
+ * Returns 1 if the cache has been updated, 0 if event ignored, <0 on error.
+ */
+static int apply_uevent(blkid_cache cache, const struct uevent *ev)
+{
+	blkid_dev dev;
+	char *devname;
+	int rc = 0;
+
+	if (strcmp(ev->subsystem, "block") != 0 || !ev->devname || !*ev->devname)
+		return 0;
+
+	if (*ev->devname == '/')
+		devname = strdup(ev->devname);
+	else {
+		devname = malloc(sizeof("/dev/") + strlen(ev->devname));
+		if (devname) {
+			strcpy(devname, "/dev/");
+			strcat(devname, ev->devname);
+		}
+	}
+	if (!devname)
+		return -BLKID_ERR_MEM;
+
+	DBG(CACHE, ul_debugobj(cache, "uevent: %s %s", ev->action, devname));
+
+	if (!strcmp(ev->action, "remove")) {
+		dev = blkid_get_dev(cache, devname, BLKID_DEV_FIND);
+		if (dev) {
+			blkid_free_dev(dev);
+			rc = 1;
+		}
+	} else if (!strcmp(ev->action, "add") || !strcmp(ev->action, "change")) {
+		dev = blkid_get_dev(cache, devname, BLKID_DEV_CREATE);
+		if (dev) {
+			/* force re-probe, blkid_verify() removes the device
+			 * from the cache if there is nothing */
+			dev->bid_time = 0;
+			dev->bid_utime = 0;
+			dev->bid_flags &= ~BLKID_BID_FL_VERIFIED;
+			blkid_verify(cache, dev);
+			rc = 1;
+		}
+	}
+
+	if (rc == 1)
+		cache->bic_flags |= BLKID_BIC_FL_CHANGED;
+	free(devname);
+	return rc;
+}
+
+/* events have been lost, re-probe all */
+static void resync_cache(blkid_cache cache)
+{
+	struct list_head *p;
+
+	DBG(CACHE, ul_debugobj(cache, "uevent: events lost, re-probing all"));
+
+	list_for_each(p, &cache->bic_devs) {
+		blkid_dev dev = list_entry(p, struct blkid_struct_dev, bid_devs);
+
+		dev->bid_time = 0;
+		dev->bid_utime = 0;
+	}
+	cache->bic_flags &= ~BLKID_BIC_FL_PROBED;
+	blkid_probe_all(cache);
+}
+
+/**
+ * blkid_cache_process_uevents:
+ * @cache: cache handler
+ * @fd: uevent socket (see blkid_cache_open_uevent())
+ *
+ * Reads all pending uevent messages from @fd, re-probes added and changed
+ * block devices, removes deleted devices from the cache and writes the cache
+ * file if anything has been modified. The function never blocks.
+ *
+ * The @fd does not have to be netlink socket, it's also possible to send the
+ * messages (in the kernel format) over a socketpair().
+ *
+ * Returns: number of the updated devices, -EPIPE if the other side of
+ * the socket has been closed, or another negative number in case of error.
+ */
+int blkid_cache_process_uevents(blkid_cache cache, int fd)
+{
+	char buf[UEVENT_BUFSZ];
+	int rc = 0, count = 0;
+
+	if (!cache || fd < 0)
+		return -EINVAL;
+
+	blkid_read_cache(cache);
+
+	while (rc == 0) {
+		struct uevent ev;
+		ssize_t sz = recv_uevent(fd, buf, sizeof(buf));
+
+		if (sz == -EAGAIN || sz == -EWOULDBLOCK)
+			break;
+		if (sz == -EINTR || sz == 0)
+			continue;
+		if (sz == -ENOBUFS) {
+			resync_cache(cache);
+			count++;
+			continue;
+		}
+		if (sz < 0) {
+			rc = sz;
+			break;
+		}
+		if (parse_uevent(buf, sz, &ev) != 0) {
+			DBG(CACHE, ul_debug("uevent: ignore unknown message"));
+			continue;
+		}
+		rc = apply_uevent(cache, &ev);
+		if (rc > 0)
+			count++;
+		if (rc >= 0)
+			rc = 0;
+	}
+
+	if (cache->bic_flags & BLKID_BIC_FL_CHANGED)
+		blkid_flush_cache(cache);
+
+	return count ? count : rc;
+}
+
+/**
+ * blkid_cache_watch:
+ * @cache: cache handler
+ * @fd: uevent socket or -1
+ *
+ * Keeps the cache file up to date until the other side of @fd is closed or
+ * an error. If @fd is -1 then the function opens the kernel uevent socket
+ * and never returns on success. See also blkid_cache_process_uevents().
+ *
+ * The library does not verify the devices (if not modified) in other
+ * processes when the cache file is watched. The watcher proves it is alive by
+ * a periodic update of the lock file modification time.
+ *
+ * Returns: 0 on success, or number less than zero in case of error.
+ */
+int blkid_cache_watch(blkid_cache cache, int fd)
+{
+	char *lockname;
+	int lockfd = -1, rc = 0, myfd = -1;
+	time_t beat = 0;
+
+	if (!cache)
+		return -EINVAL;
+
+	if (fd < 0) {
+		fd = myfd = blkid_cache_open_uevent();
+		if (fd < 0)
+			return fd;
+	}
+
+	lockname = get_watch_lockname(cache);
+	if (lockname) {
+		lockfd = open(lockname, O_RDWR|O_CREAT|O_CLOEXEC,
+				S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+		if (lockfd >= 0 && flock(lockfd, LOCK_EX|LOCK_NB) != 0) {
+			DBG(CACHE, ul_debugobj(cache, "%s is locked by another watcher", lockname));
+			close(lockfd);
+			lockfd = -1;
+		}
+		free(lockname);
+	}
+
+	if (cache->bic_flags & BLKID_BIC_FL_CHANGED)
+		blkid_flush_cache(cache);
+
+	while (rc >= 0) {
+		struct pollfd pfd = { .fd = fd, .events = POLLIN };
+		time_t now = time(NULL);
+		int n;
+
+		if (lockfd >= 0 && !(now >= beat && now - beat < BLKID_WATCH_HEARTBEAT / 2)) {
+			DBG(CACHE, ul_debugobj(cache, "uevent: heartbeat"));
+			futimens(lockfd, NULL);
+			beat = now;
+		}
+
+		n = poll(&pfd, 1, lockfd >= 0 ? BLKID_WATCH_HEARTBEAT * 1000 : -1);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			rc = -errno;
+			break;
+		}
+		if (n > 0)
+			rc = blkid_cache_process_uevents(cache, fd);
+	}
+
+	if (rc == -EPIPE)
+		rc = 0;
+	if (lockfd >= 0)
+		close(lockfd);
+	if (myfd >= 0)
+		close(myfd);
+	return rc;
+}
+
+#ifdef TEST_PROGRAM
+/*
+ * Sends the events to the watcher by socketpair(), the events are in format
+ * <action>:<devname>, for example "add:/dev/sda1".
+ */
+int main(int argc, char **argv)
+{
+	blkid_cache cache = NULL;
+	blkid_dev_iterate iter;
+	blkid_dev dev;
+	int sv[2], i, rc;
+
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s <cachefile> <action>:<devname> ...\n"
+			"Update cache by synthetic uevents\n", argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	blkid_init_debug(0);
+	if (blkid_get_cache(&cache, argv[1]) < 0)
+		exit(EXIT_FAILURE);
+	if (socketpair(AF_UNIX, SOCK_SEQPACKET|SOCK_CLOEXEC, 0, sv) != 0)
+		err(EXIT_FAILURE, "socketpair failed");
+
+	for (i = 2; i < argc; i++) {
+		char msg[UEVENT_BUFSZ], *dev = strchr(argv[i], ':');
+		int sz;
+
+		if (!dev)
+			errx(EXIT_FAILURE, "%s: unexpected event", argv[i]);
+		*dev++ = '\0';
+		sz = snprintf(msg, sizeof(msg), "%s@/devices/virtual/block/test%c"
+				"ACTION=%s%cSUBSYSTEM=block%cDEVNAME=%s%cSEQNUM=%d",
+				argv[i], 0, argv[i], 0, 0, dev, 0, i);
+		if (send(sv[1], msg, sz + 1, 0) != sz + 1)
+			err(EXIT_FAILURE, "send failed");
+	}
+	close(sv[1]);
+
+	rc = blkid_cache_watch(cache, sv[0]);
+	close(sv[0]);
+	if (rc < 0)
+		errx(EXIT_FAILURE, "watch failed [rc=%d]", rc);
+
+	iter = blkid_dev_iterate_begin(cache);
+	while (blkid_dev_next(iter, &dev) == 0) {
+		blkid_tag_iterate titer = blkid_tag_iterate_begin(dev);
+		const char *type, *value;
+
+		printf("%s:", blkid_dev_devname(dev));
+		while (blkid_tag_next(titer, &type, &value) == 0)
+			printf(" %s=\"%s\"", type, value);
+		printf("\n");
+		blkid_tag_iterate_end(titer);
+	}
+	blkid_dev_iterate_end(iter);
+
+	blkid_put_cache(cache);
+	return EXIT_SUCCESS;
+}
+#endif
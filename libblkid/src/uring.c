@@ -0,0 +1,237 @@
+/*
+ * uring.c - minimal io_uring interface for batched probing reads
+ *
+ * This file may be redistributed under the terms of the
+ * GNU Lesser General Public License.
+ *
+ * The library does not depend on liburing; the ring is set up by the raw
+ * syscalls and used only for IORING_OP_READV requests. All requests are
+ * submitted by one io_uring_enter() and the function waits for all
+ * completions, so the ring is always empty outside blkid_uring_wait().
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "blkidP.h"
+
+#ifdef BLKID_USE_URING
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+struct blkid_uring {
+	int			fd;
+	unsigned int		nqueued;	/* number of prepared requests */
+
+	/* submission queue */
+	unsigned int		*sq_tail;
+	unsigned int		*sq_mask;
+	unsigned int		*sq_array;
+	unsigned int		sq_entries;
+	struct io_uring_sqe	*sqes;
+
+	/* completion queue */
+	unsigned int		*cq_head;
+	unsigned int		*cq_tail;
+	unsigned int		*cq_mask;
+	struct io_uring_cqe	*cqes;
+
+	struct iovec		*iovs;		/* iovec for every sqe */
+
+	void			*sq_ring;
+	void			*cq_ring;
+	size_t			sq_ring_sz;
+	size_t			cq_ring_sz;
+	size_t			sqes_sz;
+};
+
+void blkid_uring_free(struct blkid_uring *ur)
+{
+	if (!ur)
+		return;
+	if (ur->sqes)
+		munmap(ur->sqes, ur->sqes_sz);
+	if (ur->cq_ring && ur->cq_ring != ur->sq_ring)
+		munmap(ur->cq_ring, ur->cq_ring_sz);
+	if (ur->sq_ring)
+		munmap(ur->sq_ring, ur->sq_ring_sz);
+	if (ur->fd >= 0)
+		close(ur->fd);
+	free(ur->iovs);
+	free(ur);
+}
+
+struct blkid_uring *blkid_uring_new(unsigned int entries)
+{
+	struct io_uring_params p;
+	struct blkid_uring *ur;
+	char *sq, *cq;
+
+	ur = calloc(1, sizeof(*ur));
+	if (!ur)
+		return NULL;
+
+	memset(&p, 0, sizeof(p));
+	ur->fd = syscall(SYS_io_uring_setup, entries, &p);
+	if (ur->fd < 0) {
+		DBG(BUFFER, ul_debug("io_uring setup failed: %m"));
+		goto err;
+	}
+
+	ur->sq_ring_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+	ur->cq_ring_sz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		ur->sq_ring_sz = ur->cq_ring_sz = max(ur->sq_ring_sz, ur->cq_ring_sz);
+
+	ur->sq_ring = mmap(NULL, ur->sq_ring_sz, PROT_READ|PROT_WRITE,
+			MAP_SHARED|MAP_POPULATE, ur->fd, IORING_OFF_SQ_RING);
+	if (ur->sq_ring == MAP_FAILED) {
+		ur->sq_ring = NULL;
+		goto err;
+	}
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		ur->cq_ring = ur->sq_ring;
+	else {
+		ur->cq_ring = mmap(NULL, ur->cq_ring_sz, PROT_READ|PROT_WRITE,
+				MAP_SHARED|MAP_POPULATE, ur->fd, IORING_OFF_CQ_RING);
+		if (ur->cq_ring == MAP_FAILED) {
+			ur->cq_ring = NULL;
+			goto err;
+		}
+	}
+
+	ur->sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+	ur->sqes = mmap(NULL, ur->sqes_sz, PROT_READ|PROT_WRITE,
+			MAP_SHARED|MAP_POPULATE, ur->fd, IORING_OFF_SQES);
+	if (ur->sqes == MAP_FAILED) {
+		ur->sqes = NULL;
+		goto err;
+	}
+
+	ur->iovs = calloc(p.sq_entries, sizeof(struct iovec));
+	if (!ur->iovs)
+		goto err;
+
+	sq = ur->sq_ring;
+	ur->sq_tail = (unsigned int *) (sq + p.sq_off.tail);
+	ur->sq_mask = (unsigned int *) (sq + p.sq_off.ring_mask);
+	ur->sq_array = (unsigned int *) (sq + p.sq_off.array);
+	ur->sq_entries = p.sq_entries;
+
+	cq = ur->cq_ring;
+	ur->cq_head = (unsigned int *) (cq + p.cq_off.head);
+	ur->cq_tail = (unsigned int *) (cq + p.cq_off.tail);
+	ur->cq_mask = (unsigned int *) (cq + p.cq_off.ring_mask);
+	ur->cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+
+	DBG(BUFFER, ul_debug("io_uring initialized [entries=%u]", ur->sq_entries));
+	return ur;
+err:
+	blkid_uring_free(ur);
+	return NULL;
+}
+
+/*
+ * Returns number of requests which could be still added by blkid_uring_read().
+ */
+unsigned int blkid_uring_space(struct blkid_uring *ur)
+{
+	return ur->sq_entries - ur->nqueued;
+}
+
+/*
+ * Prepares read request; @idx is returned by blkid_uring_wait().
+ */
+int blkid_uring_read(struct blkid_uring *ur, int fd, void *buf, size_t len,
+		     uint64_t off, unsigned int idx)
+{
+	unsigned int tail, n;
+	struct io_uring_sqe *sqe;
+
+	if (ur->nqueued >= ur->sq_entries)
+		return -EAGAIN;
+
+	tail = *ur->sq_tail + ur->nqueued;
+	n = tail & *ur->sq_mask;
+
+	ur->iovs[n].iov_base = buf;
+	ur->iovs[n].iov_len = len;
+
+	sqe = &ur->sqes[n];
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_READV;
+	sqe->fd = fd;
+	sqe->off = off;
+	sqe->addr = (unsigned long) &ur->iovs[n];
+	sqe->len = 1;
+	sqe->user_data = idx;
+
+	ur->sq_array[n] = n;
+	ur->nqueued++;
+	return 0;
+}
+
+/* reads the completed requests, returns number of the requests */
+static unsigned int uring_reap(struct blkid_uring *ur, int32_t *res)
+{
+	unsigned int head, tail, n = 0;
+
+	head = *ur->cq_head;
+	tail = __atomic_load_n(ur->cq_tail, __ATOMIC_ACQUIRE);
+	for ( ; head != tail; head++) {
+		struct io_uring_cqe *cqe = &ur->cqes[head & *ur->cq_mask];
+
+		res[cqe->user_data] = cqe->res;
+		n++;
+	}
+	__atomic_store_n(ur->cq_head, head, __ATOMIC_RELEASE);
+	return n;
+}
+
+/*
+ * Submits all prepared requests and waits for them. The result of the request
+ * @idx (bytes or -errno) is stored to @res[idx].
+ *
+ * Returns: 0 or negative errno; the ring is unusable after error.
+ */
+int blkid_uring_wait(struct blkid_uring *ur, int32_t *res)
+{
+	unsigned int total = ur->nqueued, nsubmit = total, ndone = 0;
+
+	if (!total)
+		return 0;
+
+	__atomic_store_n(ur->sq_tail, *ur->sq_tail + total, __ATOMIC_RELEASE);
+	ur->nqueued = 0;
+
+	while (ndone < total) {
+		int rc = syscall(SYS_io_uring_enter, ur->fd, nsubmit, 1,
+				IORING_ENTER_GETEVENTS, NULL, 0);
+
+		if (rc < 0 && errno != EINTR) {
+			int err = errno;
+
+			DBG(BUFFER, ul_debug("io_uring enter failed: %m"));
+
+			/* don't submit more, but wait for the requests in
+			 * flight -- the kernel still writes to the buffers */
+			while (ndone < total - nsubmit) {
+				ndone += uring_reap(ur, res);
+				if (ndone < total - nsubmit
+				    && syscall(SYS_io_uring_enter, ur->fd, 0, 1,
+					       IORING_ENTER_GETEVENTS, NULL, 0) < 0
+				    && errno != EINTR)
+					break;
+			}
+			return -err;
+		}
+		if (rc > 0)
+			nsubmit -= rc;
+
+		ndone += uring_reap(ur, res);
+	}
+	return 0;
+}
+#endif /* BLKID_USE_URING */
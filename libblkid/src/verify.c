@@ -62,9 +62,13 @@ blkid_dev blkid_verify(blkid_cache cache, blkid_dev dev)
 {
 	blkid_tag_iterate iter;
 	const char *type, *value;
+	struct blkid_prefetch *pf;
 	struct stat st;
 	time_t diff, now;
-	int fd;
+	int fd, rc;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+	struct timeval tv;
+#endif
 
 	if (!dev || !cache)
 		return NULL;
@@ -95,7 +99,8 @@ blkid_dev blkid_verify(blkid_cache cache, blkid_dev dev)
 #else
 	    st.st_mtime <= dev->bid_time &&
 #endif
-	    diff >= 0 && diff < BLKID_PROBE_MIN) {
+	    diff >= 0 &&
+	    (diff < BLKID_PROBE_MIN || blkid_cache_trust_watcher(cache, now))) {
 		dev->bid_flags |= BLKID_BID_FL_VERIFIED;
 		return dev;
 	}
@@ -118,28 +123,6 @@ blkid_dev blkid_verify(blkid_cache cache, blkid_dev dev)
 		blkid_free_dev(dev);
 		return NULL;
 	}
-	if (!cache->probe) {
-		cache->probe = blkid_new_probe();
-		if (!cache->probe) {
-			blkid_free_dev(dev);
-			return NULL;
-		}
-	}
-
-	fd = open(dev->bid_name, O_RDONLY|O_CLOEXEC|O_NONBLOCK);
-	if (fd < 0) {
-		DBG(PROBE, ul_debug("blkid_verify: error %s (%d) while "
-					"opening %s", strerror(errno), errno,
-					dev->bid_name));
-		goto open_err;
-	}
-
-	if (blkid_probe_set_device(cache->probe, fd, 0, 0)) {
-		/* failed to read the device */
-		close(fd);
-		blkid_free_dev(dev);
-		return NULL;
-	}
 
 	/* remove old cache info */
 	iter = blkid_tag_iterate_begin(dev);
@@ -147,49 +130,99 @@ blkid_dev blkid_verify(blkid_cache cache, blkid_dev dev)
 		blkid_set_tag(dev, type, NULL, 0);
 	blkid_tag_iterate_end(iter);
 
-	/* enable superblocks probing */
-	blkid_probe_enable_superblocks(cache->probe, TRUE);
-	blkid_probe_set_superblocks_flags(cache->probe,
-		BLKID_SUBLKS_LABEL | BLKID_SUBLKS_UUID |
-		BLKID_SUBLKS_TYPE | BLKID_SUBLKS_SECTYPE);
+	pf = cache->bic_prefetch;
+	if (pf && pf->devno == st.st_rdev && pf->rc >= 0) {
+		/* already probed by blkid_probe_all() worker thread */
+		DBG(PROBE, ul_debug("%s: use prefetched result", dev->bid_name));
+		rc = pf->rc;
+		if (rc == 0) {
+			iter = blkid_tag_iterate_begin(pf->dev);
+			while (blkid_tag_next(iter, &type, &value) == 0)
+				blkid_set_tag(dev, type, value, strlen(value));
+			blkid_tag_iterate_end(iter);
+		}
+	} else {
+		if (!cache->probe) {
+			cache->probe = blkid_new_probe();
+			if (!cache->probe) {
+				blkid_free_dev(dev);
+				return NULL;
+			}
+		}
 
-	/* enable partitions probing */
-	blkid_probe_enable_partitions(cache->probe, TRUE);
-	blkid_probe_set_partitions_flags(cache->probe, BLKID_PARTS_ENTRY_DETAILS);
+		fd = open(dev->bid_name, O_RDONLY|O_CLOEXEC|O_NONBLOCK);
+		if (fd < 0) {
+			DBG(PROBE, ul_debug("blkid_verify: error %s (%d) while "
+						"opening %s", strerror(errno), errno,
+						dev->bid_name));
+			goto open_err;
+		}
 
-	/* probe */
-	if (blkid_do_safeprobe(cache->probe)) {
-		/* found nothing or error */
+		rc = blkid_verify_probe(cache->probe, fd, dev);
+		close(fd);
+	}
+
+	if (rc != 0) {
+		/* failed to read the device, found nothing or error */
 		blkid_free_dev(dev);
-		dev = NULL;
+		return NULL;
 	}
 
-	if (dev) {
 #ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
-		struct timeval tv;
-		if (!gettimeofday(&tv, NULL)) {
-			dev->bid_time = tv.tv_sec;
-			dev->bid_utime = tv.tv_usec;
-		} else
+	if (!gettimeofday(&tv, NULL)) {
+		dev->bid_time = tv.tv_sec;
+		dev->bid_utime = tv.tv_usec;
+	} else
 #endif
-			dev->bid_time = time(NULL);
+		dev->bid_time = time(NULL);
 
-		dev->bid_devno = st.st_rdev;
-		dev->bid_flags |= BLKID_BID_FL_VERIFIED;
-		cache->bic_flags |= BLKID_BIC_FL_CHANGED;
+	dev->bid_devno = st.st_rdev;
+	dev->bid_flags |= BLKID_BID_FL_VERIFIED;
+	cache->bic_flags |= BLKID_BIC_FL_CHANGED;
 
-		blkid_probe_to_tags(cache->probe, dev);
+	DBG(PROBE, ul_debug("%s: devno 0x%04llx, type %s",
+		   dev->bid_name, (long long)st.st_rdev, dev->bid_type));
+	return dev;
+}
 
-		DBG(PROBE, ul_debug("%s: devno 0x%04llx, type %s",
-			   dev->bid_name, (long long)st.st_rdev, dev->bid_type));
-	}
+/*
+ * Probes @fd by @pr and adds the results to @dev tags. The function does not
+ * use dev->bid_cache, so it's possible to call it for detached devices in more
+ * threads (every thread with its own @pr).
+ *
+ * Returns: 0 on success, 1 if nothing found, <0 on error.
+ */
+int blkid_verify_probe(blkid_probe pr, int fd, blkid_dev dev)
+{
+	int rc;
+
+	if (blkid_probe_set_device(pr, fd, 0, 0))
+		return -BLKID_ERR_IO;
+
+	/* enable superblocks probing */
+	blkid_probe_enable_superblocks(pr, TRUE);
+	blkid_probe_set_superblocks_flags(pr,
+		BLKID_SUBLKS_LABEL | BLKID_SUBLKS_UUID |
+		BLKID_SUBLKS_TYPE | BLKID_SUBLKS_SECTYPE);
+
+	/* enable partitions probing */
+	blkid_probe_enable_partitions(pr, TRUE);
+	blkid_probe_set_partitions_flags(pr, BLKID_PARTS_ENTRY_DETAILS);
+
+	/* probe */
+	rc = blkid_do_safeprobe(pr);
+	if (rc == 0)
+		blkid_probe_to_tags(pr, dev);
+	else if (rc < 0)
+		rc = -BLKID_ERR_IO;
+	else
+		rc = 1;		/* found nothing or ambivalent result */
 
 	/* reset prober */
-	blkid_probe_reset_superblocks_filter(cache->probe);
-	blkid_probe_set_device(cache->probe, -1, 0, 0);
-	close(fd);
+	blkid_probe_reset_superblocks_filter(pr);
+	blkid_probe_set_device(pr, -1, 0, 0);
 
-	return dev;
+	return rc;
 }
 
 #ifdef TEST_PROGRAM
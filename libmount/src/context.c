@@ -40,8 +40,11 @@
 #include "fileutils.h"
 #include "strutils.h"
 #include "namespace.h"
+#include "monotonic.h"
+#include "pidfd-utils.h"
 
 #include <sys/wait.h>
+#include <poll.h>
 
 /**
  * mnt_new_context:
@@ -88,6 +91,8 @@ struct libmnt_context *mnt_new_context(void)
  */
 void mnt_free_context(struct libmnt_context *cxt)
 {
+	int i;
+
 	if (!cxt)
 		return;
 
@@ -108,6 +113,11 @@ void mnt_free_context(struct libmnt_context *cxt)
 
 	mnt_context_set_target_ns(cxt, NULL);
 
+	for (i = 0; i < cxt->nchildren; i++) {
+		mnt_unref_fs(cxt->children[i].fs);
+		if (cxt->children[i].pidfd >= 0)
+			close(cxt->children[i].pidfd);
+	}
 	free(cxt->children);
 
 	DBG(CXT, ul_debugobj(cxt, "<---- free"));
@@ -916,6 +926,10 @@ int mnt_context_set_fs(struct libmnt_context *cxt, struct libmnt_fs *fs)
 	if (!cxt)
 		return -EINVAL;
 
+	/* the context modifies the fs strings directly */
+	if (mnt_fs_unshare(fs))
+		return -ENOMEM;
+
 	DBG(CXT, ul_debugobj(cxt, "setting new FS"));
 	mnt_ref_fs(fs);			/* new */
 	mnt_unref_fs(cxt->fs);		/* old */
@@ -1233,6 +1247,7 @@ int mnt_context_get_fstab(struct libmnt_context *cxt, struct libmnt_table **tb)
 	if (!cxt)
 		return -EINVAL;
 	if (!cxt->fstab) {
+		uint64_t start;
 		int rc;
 
 		cxt->fstab = mnt_new_table();
@@ -1246,7 +1261,9 @@ int mnt_context_get_fstab(struct libmnt_context *cxt, struct libmnt_table **tb)
 			return -MNT_ERR_NAMESPACE;
 
 		mnt_table_set_cache(cxt->fstab, mnt_context_get_cache(cxt));
+		start = mnt_stat_start();
 		rc = mnt_table_parse_fstab(cxt->fstab, NULL);
+		mnt_context_add_stat(cxt, MNT_STAT_TABPARSE, start);
 
 		if (!mnt_context_switch_ns(cxt, ns_old))
 			return -MNT_ERR_NAMESPACE;
@@ -1272,6 +1289,7 @@ int mnt_context_get_fstab(struct libmnt_context *cxt, struct libmnt_table **tb)
  */
 int mnt_context_get_mtab(struct libmnt_context *cxt, struct libmnt_table **tb)
 {
+	uint64_t start;
 	int rc = 0;
 	struct libmnt_ns *ns_old = NULL;
 
@@ -1302,12 +1320,14 @@ int mnt_context_get_mtab(struct libmnt_context *cxt, struct libmnt_table **tb)
 		/*
 		 * Note that mtab_path is NULL if mtab is useless or unsupported
 		 */
+		start = mnt_stat_start();
 		if (cxt->utab)
 			/* utab already parsed, don't parse it again */
 			rc = __mnt_table_parse_mtab(cxt->mtab,
 						    cxt->mtab_path, cxt->utab);
 		else
 			rc = mnt_table_parse_mtab(cxt->mtab, cxt->mtab_path);
+		mnt_context_add_stat(cxt, MNT_STAT_TABPARSE, start);
 		if (rc)
 			goto end;
 	}
@@ -1340,6 +1360,60 @@ static int mtab_filter(struct libmnt_fs *fs, void *data)
 	return 1;
 }
 
+/*
+ * Filter for mnt_context_get_mtab_for_mntid(), entries without ID are from
+ * utab and they are required for the merge.
+ */
+static int mtab_id_filter(struct libmnt_fs *fs, void *data)
+{
+	if (!fs || !data)
+		return 0;
+	if (!fs->id || fs->id == *((int *) data))
+		return 0;
+	return 1;
+}
+
+/*
+ * The same like mnt_context_get_mtab(), but reads only the entry for the mount
+ * ID of the @tgt mountpoint (see statx(2) STATX_MNT_ID). The path does not have
+ * to be canonicalized, the kernel resolves it.
+ *
+ * The filter is usable only for mount table from kernel (non-writable mtab).
+ *
+ * Returns: 0 on success (the ID is returned in @id), 1 if @tgt is not
+ * a mountpoint or mount IDs are unsupported, <0 on error.
+ */
+int mnt_context_get_mtab_for_mntid(struct libmnt_context *cxt,
+				   struct libmnt_table **mtab,
+				   const char *tgt, int *id)
+{
+	struct libmnt_ns *ns_old;
+	int rc, mntid = 0, root = 0;
+
+	if (mnt_context_mtab_writable(cxt))
+		return 1;
+
+	ns_old = mnt_context_switch_target_ns(cxt);
+	if (!ns_old)
+		return -MNT_ERR_NAMESPACE;
+
+	rc = mnt_get_mount_id(tgt, &mntid, &root);
+	if (rc == 0 && root == 1) {
+		DBG(CXT, ul_debugobj(cxt, "%s: mount ID %d", tgt, mntid));
+		mnt_context_set_tabfilter(cxt, mtab_id_filter, &mntid);
+		rc = mnt_context_get_mtab(cxt, mtab);
+		mnt_context_set_tabfilter(cxt, NULL, NULL);
+		if (rc == 0)
+			*id = mntid;
+	} else
+		rc = 1;
+
+	if (!mnt_context_switch_ns(cxt, ns_old))
+		return -MNT_ERR_NAMESPACE;
+
+	return rc;
+}
+
 /*
  * The same like mnt_context_get_mtab(), but does not read all mountinfo/mtab
  * file, but only entries relevant for @tgt.
@@ -1351,9 +1425,15 @@ int mnt_context_get_mtab_for_target(struct libmnt_context *cxt,
 	struct stat st;
 	struct libmnt_cache *cache = NULL;
 	char *cn_tgt = NULL;
-	int rc;
+	int rc, id = 0;
 	struct libmnt_ns *ns_old;
 
+	if (!mnt_context_is_nocanonicalize(cxt)) {
+		rc = mnt_context_get_mtab_for_mntid(cxt, mtab, tgt, &id);
+		if (rc <= 0)
+			return rc;
+	}
+
 	ns_old = mnt_context_switch_target_ns(cxt);
 	if (!ns_old)
 		return -MNT_ERR_NAMESPACE;
@@ -1425,6 +1505,7 @@ int mnt_context_set_tabfilter(struct libmnt_context *cxt,
 int mnt_context_get_table(struct libmnt_context *cxt,
 			  const char *filename, struct libmnt_table **tb)
 {
+	uint64_t start;
 	int rc;
 	struct libmnt_ns *ns_old;
 
@@ -1442,7 +1523,9 @@ int mnt_context_get_table(struct libmnt_context *cxt,
 	if (!ns_old)
 		return -MNT_ERR_NAMESPACE;
 
+	start = mnt_stat_start();
 	rc = mnt_table_parse_file(*tb, filename);
+	mnt_context_add_stat(cxt, MNT_STAT_TABPARSE, start);
 
 	if (rc) {
 		mnt_unref_table(*tb);
@@ -1636,14 +1719,17 @@ int mnt_context_set_mflags(struct libmnt_context *cxt, unsigned long flags)
 
 	cxt->mountflags = flags;
 
-	if ((cxt->flags & MNT_FL_MOUNTOPTS_FIXED) && cxt->fs)
+	if ((cxt->flags & MNT_FL_MOUNTOPTS_FIXED) && cxt->fs) {
 		/*
 		 * the final mount options are already generated, refresh...
 		 */
-		return mnt_optstr_apply_flags(
+		int rc = mnt_optstr_apply_flags(
 				&cxt->fs->vfs_optstr,
 				cxt->mountflags,
 				mnt_get_builtin_optmap(MNT_LINUX_MAP));
+		mnt_fs_reset_optlist(cxt->fs);
+		return rc;
+	}
 
 	return 0;
 }
@@ -1668,9 +1754,7 @@ int mnt_context_get_mflags(struct libmnt_context *cxt, unsigned long *flags)
 
 	*flags = 0;
 	if (!(cxt->flags & MNT_FL_MOUNTFLAGS_MERGED) && cxt->fs) {
-		const char *o = mnt_fs_get_options(cxt->fs);
-		if (o)
-			rc = mnt_optstr_get_flags(o, flags,
+		rc = mnt_fs_get_optflags(cxt->fs, MNT_OPTLIST_ALL, flags,
 				    mnt_get_builtin_optmap(MNT_LINUX_MAP));
 	}
 
@@ -1724,9 +1808,7 @@ int mnt_context_get_user_mflags(struct libmnt_context *cxt, unsigned long *flags
 
 	*flags = 0;
 	if (!(cxt->flags & MNT_FL_MOUNTFLAGS_MERGED) && cxt->fs) {
-		const char *o = mnt_fs_get_user_options(cxt->fs);
-		if (o)
-			rc = mnt_optstr_get_flags(o, flags,
+		rc = mnt_fs_get_optflags(cxt->fs, MNT_OPTLIST_USER, flags,
 				mnt_get_builtin_optmap(MNT_USERSPACE_MAP));
 	}
 	if (!rc)
@@ -1837,11 +1919,17 @@ int mnt_context_prepare_srcpath(struct libmnt_context *cxt)
 	if (rc == -ENOTSUP) {
 			goto end;
 	} else if (rc) {
+		uint64_t start = mnt_stat_start();
+
 		rc = mnt_context_setup_veritydev(cxt);
+		mnt_context_add_stat(cxt, MNT_STAT_VERITYDEV, start);
 		if (rc)
 			goto end;
 	} else if (mnt_context_is_loopdev(cxt)) {
+		uint64_t start = mnt_stat_start();
+
 		rc = mnt_context_setup_loopdev(cxt);
+		mnt_context_add_stat(cxt, MNT_STAT_LOOPDEV, start);
 		if (rc)
 			goto end;
 	}
@@ -2004,7 +2092,10 @@ int mnt_context_guess_srcpath_fstype(struct libmnt_context *cxt, char **type)
 		struct libmnt_cache *cache = mnt_context_get_cache(cxt);
 		int ambi = 0;
 
+		uint64_t start = mnt_stat_start();
+
 		*type = mnt_get_fstype(dev, &ambi, cache);
+		mnt_context_add_stat(cxt, MNT_STAT_PROBE, start);
 		if (ambi)
 			rc = -MNT_ERR_AMBIFS;
 
@@ -2090,6 +2181,7 @@ int mnt_context_prepare_helper(struct libmnt_context *cxt, const char *name,
 	char search_path[] = FS_SEARCH_PATH;		/* from config.h */
 	char *p = NULL, *path;
 	struct libmnt_ns *ns_old;
+	uint64_t start;
 	int rc = 0;
 
 	assert(cxt);
@@ -2113,6 +2205,8 @@ int mnt_context_prepare_helper(struct libmnt_context *cxt, const char *name,
 	if (!ns_old)
 		return -MNT_ERR_NAMESPACE;
 
+	start = mnt_stat_start();
+
 	/* Ignore errors when search in $PATH and do not modify
 	 * @rc due to stat() etc.
 	 */
@@ -2147,6 +2241,7 @@ int mnt_context_prepare_helper(struct libmnt_context *cxt, const char *name,
 		rc = strdup_to_struct_member(cxt, helper, helper);
 		break;
 	}
+	mnt_context_add_stat(cxt, MNT_STAT_HELPER, start);
 
 	if (!mnt_context_switch_ns(cxt, ns_old))
 		rc = -MNT_ERR_NAMESPACE;
@@ -2243,6 +2338,7 @@ int mnt_context_prepare_update(struct libmnt_context *cxt)
 
 		mnt_update_set_filename(cxt->update, name,
 				!mnt_context_mtab_writable(cxt));
+		mnt_update_set_lock_stat(cxt->update, &cxt->stats[MNT_STAT_LOCK]);
 	}
 
 	if (cxt->action == MNT_ACT_UMOUNT)
@@ -2257,6 +2353,7 @@ int mnt_context_prepare_update(struct libmnt_context *cxt)
 
 int mnt_context_update_tabs(struct libmnt_context *cxt)
 {
+	uint64_t start;
 	unsigned long fl;
 	int rc = 0;
 	struct libmnt_ns *ns_old;
@@ -2306,7 +2403,9 @@ int mnt_context_update_tabs(struct libmnt_context *cxt)
 		mnt_update_force_rdonly(cxt->update,
 				cxt->mountflags & MS_RDONLY);
 
+	start = mnt_stat_start();
 	rc = mnt_update_table(cxt->update, cxt->lock);
+	mnt_context_add_stat(cxt, MNT_STAT_UPDATE, start);
 
 end:
 	if (!mnt_context_switch_ns(cxt, ns_old))
@@ -2531,6 +2630,7 @@ int mnt_context_apply_fstab(struct libmnt_context *cxt)
 
 		/* remove "bind" from fstab (or no-op if not present) */
 		mnt_optstr_remove_option(&cxt->fs->optstr, "bind");
+		mnt_fs_reset_optlist(cxt->fs);
 	}
 	return rc;
 }
@@ -2877,26 +2977,198 @@ int mnt_context_is_fs_mounted(struct libmnt_context *cxt,
 	return 0;
 }
 
-static int mnt_context_add_child(struct libmnt_context *cxt, pid_t pid)
+static int mnt_context_add_child(struct libmnt_context *cxt, pid_t pid,
+				 struct libmnt_fs *fs, struct timeval *start)
 {
-	pid_t *pids;
+	struct libmnt_child *children, *ch;
 
 	if (!cxt)
 		return -EINVAL;
 
-	pids = realloc(cxt->children, sizeof(pid_t) * cxt->nchildren + 1);
-	if (!pids)
+	children = realloc(cxt->children,
+			sizeof(struct libmnt_child) * (cxt->nchildren + 1));
+	if (!children)
 		return -ENOMEM;
 
 	DBG(CXT, ul_debugobj(cxt, "add new child %d", pid));
-	cxt->children = pids;
-	cxt->children[cxt->nchildren++] = pid;
+	cxt->children = children;
+
+	ch = &cxt->children[cxt->nchildren++];
+	memset(ch, 0, sizeof(*ch));
+	ch->pid = pid;
+	ch->start = *start;
+	ch->fs = fs;
+	mnt_ref_fs(fs);
+#ifdef UL_HAVE_PIDFD
+	ch->pidfd = pidfd_open(pid, 0);
+#else
+	ch->pidfd = -1;
+#endif
 
 	return 0;
 }
 
-int mnt_fork_context(struct libmnt_context *cxt)
+/* Returns 1 if @path is @prefix or if it's below @prefix */
+static int is_subpath(const char *path, const char *prefix)
+{
+	size_t sz;
+
+	if (!path || !prefix)
+		return 0;
+
+	sz = strlen(prefix);
+	if (!sz)
+		return 0;
+	while (sz > 1 && prefix[sz - 1] == '/')
+		sz--;
+	if (strncmp(path, prefix, sz) != 0)
+		return 0;
+
+	return path[sz] == '\0' || path[sz] == '/' || prefix[sz - 1] == '/';
+}
+
+/*
+ * Returns 1 if @fs has to wait for the running child @ch; the mountpoint of
+ * one of them is below the mountpoint of the other one, or the source path
+ * (bind mount, loop device image, ...) is below the child's mountpoint.
+ */
+static int fs_depends_on_child(struct libmnt_fs *fs, struct libmnt_child *ch)
+{
+	const char *tgt = mnt_fs_get_target(fs),
+		   *chtgt = mnt_fs_get_target(ch->fs),
+		   *src = mnt_fs_get_srcpath(fs);
+
+	if (is_subpath(tgt, chtgt) || is_subpath(chtgt, tgt))
+		return 1;
+
+	return src && *src == '/' && is_subpath(src, chtgt);
+}
+
+static void child_done(struct libmnt_context *cxt, struct libmnt_child *ch,
+		       int status)
+{
+	struct timeval now, diff;
+
+	gettime_monotonic(&now);
+	timersub(&now, &ch->start, &diff);
+
+	ch->status = status;
+	ch->done = 1;
+
+	DBG(CXT, ul_debugobj(cxt, "child %d done [status=%d, %ld.%06ld s]",
+				ch->pid, status,
+				(long) diff.tv_sec, (long) diff.tv_usec));
+
+	if (cxt->child_cb)
+		cxt->child_cb(cxt, ch->fs,
+			WIFEXITED(status) ? WEXITSTATUS(status) : -1,
+			diff.tv_sec * 1000 + diff.tv_usec / 1000);
+
+	mnt_unref_fs(ch->fs);
+	ch->fs = NULL;
+	if (ch->pidfd >= 0)
+		close(ch->pidfd);
+	ch->pidfd = -1;
+}
+
+/*
+ * Waits for any running child. Only the context children are waited for, so
+ * other children of the process are never blocked on nor reaped.
+ *
+ * The children are reaped in the order they finish, so the callback gets
+ * accurate times. The finished child is detected by poll() on the children
+ * pidfds. If pidfd is not available, the oldest running child is waited for.
+ *
+ * Returns: 0 on success, 1 if there is no running child.
+ */
+static int wait_for_any_child(struct libmnt_context *cxt)
+{
+	struct pollfd *pfds;
+	int i, rc, status = 0;
+
+	pfds = calloc(cxt->nchildren, sizeof(struct pollfd));
+
+	for (;;) {
+		struct libmnt_child *oldest = NULL;
+		int nrunning = 0, npfds = 0;
+
+		for (i = 0; i < cxt->nchildren; i++) {
+			struct libmnt_child *x = &cxt->children[i];
+
+			if (x->done)
+				continue;
+			nrunning++;
+
+			rc = waitpid(x->pid, &status, WNOHANG);
+			if (rc == x->pid || (rc == -1 && errno != EINTR)) {
+				child_done(cxt, x, rc == -1 ? -1 : status);
+				goto done;
+			}
+			if (!oldest)
+				oldest = x;
+			if (x->pidfd >= 0 && pfds) {
+				pfds[npfds].fd = x->pidfd;
+				pfds[npfds].events = POLLIN;
+				npfds++;
+			}
+		}
+		if (!nrunning) {
+			free(pfds);
+			return 1;
+		}
+
+		if (npfds < nrunning) {
+			/* no pidfd, wait for the oldest child */
+			DBG(CXT, ul_debugobj(cxt, "waiting for child %d", oldest->pid));
+			do {
+				errno = 0;
+				rc = waitpid(oldest->pid, &status, 0);
+			} while (rc == -1 && errno == EINTR);
+
+			child_done(cxt, oldest, rc == -1 ? -1 : status);
+			goto done;
+		}
+
+		DBG(CXT, ul_debugobj(cxt, "waiting for %d children", npfds));
+		if (poll(pfds, npfds, -1) < 0 && errno != EINTR) {
+			free(pfds);
+			pfds = NULL;	/* use the fallback */
+		}
+	}
+done:
+	free(pfds);
+	return 0;
+}
+
+/*
+ * Waits until the number of the running children is below the jobs limit
+ * and until all children @fs depends on are finished.
+ */
+static void wait_for_slot(struct libmnt_context *cxt, struct libmnt_fs *fs)
+{
+	do {
+		int i, nrunning = 0, blocked = 0;
+
+		for (i = 0; i < cxt->nchildren; i++) {
+			struct libmnt_child *ch = &cxt->children[i];
+
+			if (ch->done)
+				continue;
+			nrunning++;
+			if (!blocked && fs_depends_on_child(fs, ch)) {
+				DBG(CXT, ul_debugobj(cxt, "%s depends on child %d",
+						mnt_fs_get_target(fs), ch->pid));
+				blocked = 1;
+			}
+		}
+		if (!blocked && (!cxt->maxjobs || nrunning < cxt->maxjobs))
+			break;
+	} while (wait_for_any_child(cxt) == 0);
+}
+
+int mnt_fork_context(struct libmnt_context *cxt, struct libmnt_fs *fs)
 {
+	struct timeval start;
 	int rc = 0;
 	pid_t pid;
 
@@ -2904,10 +3176,14 @@ int mnt_fork_context(struct libmnt_context *cxt)
 	if (!mnt_context_is_parent(cxt))
 		return -EINVAL;
 
+	if (fs)
+		wait_for_slot(cxt, fs);
+
 	DBG(CXT, ul_debugobj(cxt, "forking context"));
 
 	DBG_FLUSH;
 
+	gettime_monotonic(&start);
 	pid = fork();
 
 	switch (pid) {
@@ -2922,13 +3198,25 @@ int mnt_fork_context(struct libmnt_context *cxt)
 		break;
 
 	default:
-		rc = mnt_context_add_child(cxt, pid);
+		rc = mnt_context_add_child(cxt, pid, fs, &start);
 		break;
 	}
 
 	return rc;
 }
 
+/**
+ * mnt_context_wait_for_children:
+ * @cxt: mount context
+ * @nchildren: returns number of children
+ * @nerrs: returns number of children which failed
+ *
+ * Waits for all children forked by mnt_context_next_mount(). The function
+ * adds to the @nchildren and @nerrs counters, so they have to be initialized
+ * by caller.
+ *
+ * Returns: 0 on success, negative number in case of error.
+ */
 int mnt_context_wait_for_children(struct libmnt_context *cxt,
 				  int *nchildren, int *nerrs)
 {
@@ -2939,31 +3227,21 @@ int mnt_context_wait_for_children(struct libmnt_context *cxt,
 
 	assert(mnt_context_is_parent(cxt));
 
-	for (i = 0; i < cxt->nchildren; i++) {
-		pid_t pid = cxt->children[i];
-		int rc = 0, ret = 0;
-
-		if (!pid)
-			continue;
-		do {
-			DBG(CXT, ul_debugobj(cxt,
-					"waiting for child (%d/%d): %d",
-					i + 1, cxt->nchildren, pid));
-			errno = 0;
-			rc = waitpid(pid, &ret, 0);
+	while (wait_for_any_child(cxt) == 0)
+		;
 
-		} while (rc == -1 && errno == EINTR);
+	for (i = 0; i < cxt->nchildren; i++) {
+		int ret = cxt->children[i].status;
 
 		if (nchildren)
 			(*nchildren)++;
 
-		if (rc != -1 && nerrs) {
+		if (ret != -1 && nerrs) {
 			if (WIFEXITED(ret))
 				(*nerrs) += WEXITSTATUS(ret) == 0 ? 0 : 1;
 			else
 				(*nerrs)++;
 		}
-		cxt->children[i] = 0;
 	}
 
 	cxt->nchildren = 0;
@@ -2972,6 +3250,151 @@ int mnt_context_wait_for_children(struct libmnt_context *cxt,
 	return 0;
 }
 
+/**
+ * mnt_context_set_fork_jobs:
+ * @cxt: mount context
+ * @njobs: maximal number of children, 0 means unlimited
+ *
+ * Sets the maximal number of children running at the same time in the fork
+ * mode (see mnt_context_enable_fork()). mnt_context_next_mount() waits for a
+ * free slot before it forks a new child.
+ *
+ * Note that independently on the limit a new child is not forked until
+ * children with mountpoints above or below the new mountpoint (or with the
+ * mountpoint above the source path) are finished, so the fstab order is
+ * preserved for dependent filesystems.
+ *
+ * Returns: 0 on success, negative number in case of error.
+ *
+ * Since: 2.37
+ */
+int mnt_context_set_fork_jobs(struct libmnt_context *cxt, int njobs)
+{
+	if (!cxt || njobs < 0)
+		return -EINVAL;
+	cxt->maxjobs = njobs;
+	return 0;
+}
+
+/**
+ * mnt_context_get_fork_jobs:
+ * @cxt: mount context
+ *
+ * Returns: maximal number of children running at the same time or 0 if
+ *          unlimited.
+ *
+ * Since: 2.37
+ */
+int mnt_context_get_fork_jobs(struct libmnt_context *cxt)
+{
+	return cxt ? cxt->maxjobs : 0;
+}
+
+/**
+ * mnt_context_set_children_cb:
+ * @cxt: mount context
+ * @cb: function called for finished children
+ *
+ * The callback is called in the parent process when a child forked by
+ * mnt_context_next_mount() has been finished. The arguments are the fstab
+ * entry, the child exit status (0 on success, -1 if the child has been
+ * terminated abnormally) and the number of milliseconds since fork.
+ *
+ * The callback is called from mnt_context_next_mount() and
+ * mnt_context_wait_for_children().
+ *
+ * Returns: 0 on success, negative number in case of error.
+ *
+ * Since: 2.37
+ */
+int mnt_context_set_children_cb(struct libmnt_context *cxt,
+		void (*cb)(struct libmnt_context *, struct libmnt_fs *, int, unsigned long))
+{
+	if (!cxt)
+		return -EINVAL;
+	cxt->child_cb = cb;
+	return 0;
+}
+
+static const char *stat_names[] = {
+	[MNT_STAT_TOTAL]	= "total",
+	[MNT_STAT_TABPARSE]	= "tabparse",
+	[MNT_STAT_HELPER]	= "helper",
+	[MNT_STAT_EXEC]		= "exec",
+	[MNT_STAT_PROBE]	= "probe",
+	[MNT_STAT_LOOPDEV]	= "loopdev",
+	[MNT_STAT_VERITYDEV]	= "veritydev",
+	[MNT_STAT_SYSCALL]	= "syscall",
+	[MNT_STAT_LOCK]		= "lock",
+	[MNT_STAT_UPDATE]	= "update"
+};
+
+/**
+ * mnt_context_get_stat:
+ * @cxt: mount context
+ * @id: MNT_STAT_* counter
+ * @count: returns number of calls or NULL
+ * @usec: returns total time in microseconds or NULL
+ *
+ * Returns statistics about the mount and umount phases, for example
+ * MNT_STAT_PROBE is the number of filesystem type detections and the time
+ * spent in libblkid. The statistics are collected for the whole life of the
+ * context, mnt_reset_context() does not reset them (so they are usable to
+ * summarize mnt_context_next_mount() loop), see mnt_context_reset_stats().
+ *
+ * Note that the statistics are not available for the children in
+ * mnt_context_enable_fork() mode.
+ *
+ * Returns: 0 on success, negative number in case of error.
+ *
+ * Since: 2.37
+ */
+int mnt_context_get_stat(struct libmnt_context *cxt, int id,
+			 unsigned long *count, uint64_t *usec)
+{
+	if (!cxt || id < 0 || id >= MNT_NSTATS)
+		return -EINVAL;
+	if (count)
+		*count = cxt->stats[id].count;
+	if (usec)
+		*usec = cxt->stats[id].usec;
+	return 0;
+}
+
+/**
+ * mnt_context_reset_stats:
+ * @cxt: mount context
+ *
+ * Zeroize all statistics counters, see mnt_context_get_stat().
+ *
+ * Returns: 0 on success, negative number in case of error.
+ *
+ * Since: 2.37
+ */
+int mnt_context_reset_stats(struct libmnt_context *cxt)
+{
+	if (!cxt)
+		return -EINVAL;
+	memset(cxt->stats, 0, sizeof(cxt->stats));
+	return 0;
+}
+
+/**
+ * mnt_stat_get_name:
+ * @id: MNT_STAT_* counter
+ *
+ * Returns: name of the statistics counter (e.g. "probe" for MNT_STAT_PROBE)
+ * or NULL.
+ *
+ * Since: 2.37
+ */
+const char *mnt_stat_get_name(int id)
+{
+	if (id < 0 || (size_t) id >= ARRAY_SIZE(stat_names))
+		return NULL;
+	return stat_names[id];
+}
+
 static void close_ns(struct libmnt_ns *ns)
 {
 	if (ns->fd == -1)
@@ -272,6 +272,8 @@ static int fix_optstr(struct libmnt_context *cxt)
 		free(fs->user_optstr);
 		fs->user_optstr = NULL;
 	}
+	mnt_fs_reset_optlist(fs);
+
 	if (cxt->mountflags & MS_PROPAGATION) {
 		rc = init_propagation(cxt);
 		if (rc)
@@ -370,6 +372,7 @@ static int fix_optstr(struct libmnt_context *cxt)
 	fs->optstr = NULL;
 	fs->optstr = mnt_fs_strdup_options(fs);
 done:
+	mnt_fs_reset_optlist(fs);
 	cxt->flags |= MNT_FL_MOUNTOPTS_FIXED;
 
 	DBG(CXT, ul_debugobj(cxt, "fixed options [rc=%d]: "
@@ -615,6 +618,7 @@ static int exec_helper(struct libmnt_context *cxt)
 {
 	char *o = NULL, *namespace = NULL;
 	struct libmnt_ns *ns_tgt = mnt_context_get_target_ns(cxt);
+	uint64_t start;
 	int rc;
 	pid_t pid;
 
@@ -638,6 +642,7 @@ static int exec_helper(struct libmnt_context *cxt)
 
 	DBG_FLUSH;
 
+	start = mnt_stat_start();
 	pid = fork();
 	switch (pid) {
 	case 0:
@@ -714,6 +719,7 @@ static int exec_helper(struct libmnt_context *cxt)
 		break;
 	}
 
+	mnt_context_add_stat(cxt, MNT_STAT_EXEC, start);
 	free(o);
 	return rc;
 }
@@ -733,6 +739,7 @@ static int do_mount_additional(struct libmnt_context *cxt,
 
 	list_for_each(p, &cxt->addmounts) {
 		int rc;
+		uint64_t start;
 		struct libmnt_addmount *ad =
 				list_entry(p, struct libmnt_addmount, mounts);
 
@@ -740,8 +747,10 @@ static int do_mount_additional(struct libmnt_context *cxt,
 				ad->mountflags,
 				ad->mountflags & MS_REC ? " (recursive)" : ""));
 
+		start = mnt_stat_start();
 		rc = mount("none", target, NULL,
 				ad->mountflags | (flags & MS_SILENT), NULL);
+		mnt_context_add_stat(cxt, MNT_STAT_SYSCALL, start);
 		if (rc) {
 			if (syserr)
 				*syserr = -errno;
@@ -831,7 +840,11 @@ static int do_mount(struct libmnt_context *cxt, const char *try_type)
 		/*
 		 * regular mount
 		 */
-		if (mount(src, target, type, flags, cxt->mountdata)) {
+		uint64_t start = mnt_stat_start();
+		int res = mount(src, target, type, flags, cxt->mountdata);
+
+		mnt_context_add_stat(cxt, MNT_STAT_SYSCALL, start);
+		if (res) {
 			cxt->syscall_status = -errno;
 			DBG(CXT, ul_debugobj(cxt, "mount(2) failed [errno=%d %m]",
 							-cxt->syscall_status));
@@ -1244,6 +1257,7 @@ int mnt_context_mount(struct libmnt_context *cxt)
 {
 	int rc;
 	struct libmnt_ns *ns_old;
+	uint64_t start = mnt_stat_start();
 
 	assert(cxt);
 	assert(cxt->fs);
@@ -1291,6 +1305,8 @@ again:
 			goto again;
 		}
 	}
+	mnt_context_add_stat(cxt, MNT_STAT_TOTAL, start);
+
 	if (!mnt_context_switch_ns(cxt, ns_old))
 		return -MNT_ERR_NAMESPACE;
 	return rc;
@@ -1413,7 +1429,7 @@ int mnt_context_next_mount(struct libmnt_context *cxt,
 	cxt->mtab = mtab;
 
 	if (mnt_context_is_fork(cxt)) {
-		rc = mnt_fork_context(cxt);
+		rc = mnt_fork_context(cxt, *fs);
 		if (rc)
 			return rc;		/* fork error */
 
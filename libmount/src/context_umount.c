@@ -51,8 +51,9 @@ static int __mtab_find_umount_fs(struct libmnt_context *cxt,
 	int rc;
 	struct libmnt_ns *ns_old;
 	struct libmnt_table *mtab = NULL;
-	struct libmnt_fs *fs;
+	struct libmnt_fs *fs = NULL;
 	char *loopdev = NULL;
+	int id = 0;
 
 	assert(cxt);
 	assert(tgt);
@@ -74,15 +75,23 @@ static int __mtab_find_umount_fs(struct libmnt_context *cxt,
 	 * is expected already canonical.
 	 *
 	 * Anyway it's better to read huge mount table than canonicalize target
-	 * paths. It means we use the filter only if --no-canonicalize enabled.
+	 * paths. It means we use the path filter only if --no-canonicalize
+	 * enabled. If the target is a mountpoint then the kernel resolves the
+	 * path for us -- statx() returns the mount ID and the table is filtered
+	 * by the ID, so only one mountinfo entry is parsed (not for --lazy or
+	 * --force, the target is probably unreachable NFS).
 	 *
 	 * It also means that we have to read mount table from kernel
 	 * (non-writable mtab).
 	 */
-	if (mnt_context_is_nocanonicalize(cxt) &&
-	    !mnt_context_mtab_writable(cxt) && *tgt == '/')
-		rc = mnt_context_get_mtab_for_target(cxt, &mtab, tgt);
-	else
+	rc = 1;
+	if (!mnt_context_mtab_writable(cxt) && *tgt == '/') {
+		if (mnt_context_is_nocanonicalize(cxt))
+			rc = mnt_context_get_mtab_for_target(cxt, &mtab, tgt);
+		else if (!mnt_context_is_force(cxt) && !mnt_context_is_lazy(cxt))
+			rc = mnt_context_get_mtab_for_mntid(cxt, &mtab, tgt, &id);
+	}
+	if (rc == 1)
 		rc = mnt_context_get_mtab(cxt, &mtab);
 
 	if (rc) {
@@ -99,6 +108,10 @@ static int __mtab_find_umount_fs(struct libmnt_context *cxt,
 	if (!ns_old)
 		return -MNT_ERR_NAMESPACE;
 
+	if (id)
+		fs = __mnt_table_find_id(mtab, id);
+	if (fs)
+		goto done;
 try_loopdev:
 	fs = mnt_table_find_target(mtab, tgt, MNT_ITER_BACKWARD);
 	if (!fs && mnt_context_is_swapmatch(cxt)) {
@@ -155,6 +168,7 @@ try_loopdev:
 		}
 	}
 
+done:
 	*pfs = fs;
 	free(loopdev);
 	if (!mnt_context_switch_ns(cxt, ns_old))
@@ -193,9 +207,9 @@ int mnt_context_find_umount_fs(struct libmnt_context *cxt,
 	if (!*tgt)
 		return 1; /* empty string is not an error */
 
-	/* In future this function should be extended to support for example
-	 * fsinfo() (or another cheap way kernel will support), for now the
-	 * default is expensive mountinfo/mtab.
+	/* The mountinfo/mtab is expensive, but for mountpoints the lookup is
+	 * reduced to statx(STATX_MNT_ID) and one mountinfo entry, see
+	 * __mtab_find_umount_fs().
 	 */
 	return __mtab_find_umount_fs(cxt, tgt, pfs);
 }
@@ -660,6 +674,7 @@ static int exec_helper(struct libmnt_context *cxt)
 {
 	char *namespace = NULL;
 	struct libmnt_ns *ns_tgt = mnt_context_get_target_ns(cxt);
+	uint64_t start;
 	int rc;
 	pid_t pid;
 
@@ -683,6 +698,7 @@ static int exec_helper(struct libmnt_context *cxt)
 
 	DBG_FLUSH;
 
+	start = mnt_stat_start();
 	pid = fork();
 	switch (pid) {
 	case 0:
@@ -757,6 +773,7 @@ static int exec_helper(struct libmnt_context *cxt)
 		break;
 	}
 
+	mnt_context_add_stat(cxt, MNT_STAT_EXEC, start);
 	return rc;
 }
 
@@ -823,6 +840,7 @@ static int umount_nofollow_support(void)
 
 static int do_umount(struct libmnt_context *cxt)
 {
+	uint64_t start;
 	int rc = 0, flags = 0;
 	const char *src, *target;
 	char *tgtbuf = NULL;
@@ -871,7 +889,9 @@ static int do_umount(struct libmnt_context *cxt)
 	if (mnt_context_is_fake(cxt))
 		rc = 0;
 	else {
+		start = mnt_stat_start();
 		rc = flags ? umount2(target, flags) : umount(target);
+		mnt_context_add_stat(cxt, MNT_STAT_SYSCALL, start);
 		if (rc < 0)
 			cxt->syscall_status = -errno;
 		free(tgtbuf);
@@ -893,8 +913,10 @@ static int do_umount(struct libmnt_context *cxt)
 			"umount(2) failed [errno=%d] -- trying to remount read-only",
 			-cxt->syscall_status));
 
+		start = mnt_stat_start();
 		rc = mount(src, mnt_fs_get_target(cxt->fs), NULL,
 			    MS_REMOUNT | MS_RDONLY, NULL);
+		mnt_context_add_stat(cxt, MNT_STAT_SYSCALL, start);
 		if (rc < 0) {
 			cxt->syscall_status = -errno;
 			DBG(CXT, ul_debugobj(cxt,
@@ -1111,6 +1133,7 @@ int mnt_context_umount(struct libmnt_context *cxt)
 {
 	int rc;
 	struct libmnt_ns *ns_old;
+	uint64_t start = mnt_stat_start();
 
 	assert(cxt);
 	assert(cxt->fs);
@@ -1131,6 +1154,8 @@ int mnt_context_umount(struct libmnt_context *cxt)
 	if (!rc)
 		rc = mnt_context_update_tabs(cxt);
 
+	mnt_context_add_stat(cxt, MNT_STAT_TOTAL, start);
+
 	if (!mnt_context_switch_ns(cxt, ns_old))
 		return -MNT_ERR_NAMESPACE;
 
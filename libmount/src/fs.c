@@ -63,6 +63,138 @@ void mnt_free_fs(struct libmnt_fs *fs)
 	free(fs);
 }
 
+/*
+ * The strings of the entries parsed from mountinfo point to the buffer shared
+ * by all the entries (see mnt_table_enable_zerocopy()). The shared string is
+ * never deallocated or modified in place; it's copied before modification
+ * (copy-on-write) and the buffer is kept until the entry is deallocated.
+ */
+static inline int is_shared_str(const struct libmnt_fs *fs, const char *str)
+{
+	return fs->strbuf && str
+		&& str >= fs->strbuf->data
+		&& str < fs->strbuf->data + fs->strbuf->size;
+}
+
+static inline void free_str(struct libmnt_fs *fs, char *str)
+{
+	if (!is_shared_str(fs, str))
+		free(str);
+}
+
+/* forget the shared string, the caller is going to replace it */
+static inline void release_str(struct libmnt_fs *fs, char **str)
+{
+	if (is_shared_str(fs, *str))
+		*str = NULL;
+}
+
+/* replace the shared string with a private copy */
+static int unshare_str(struct libmnt_fs *fs, char **str)
+{
+	char *x;
+
+	if (!is_shared_str(fs, *str))
+		return 0;
+	x = strdup(*str);
+	if (!x)
+		return -ENOMEM;
+	*str = x;
+	return 0;
+}
+
+/*
+ * Makes private copies of all shared strings; used by code which modifies
+ * the strings directly rather than by mnt_fs_set_* functions.
+ */
+int mnt_fs_unshare(struct libmnt_fs *fs)
+{
+	if (!fs || !fs->strbuf)
+		return 0;
+
+	if (unshare_str(fs, &fs->source) ||
+	    unshare_str(fs, &fs->bindsrc) ||
+	    unshare_str(fs, &fs->root) ||
+	    unshare_str(fs, &fs->swaptype) ||
+	    unshare_str(fs, &fs->target) ||
+	    unshare_str(fs, &fs->fstype) ||
+	    unshare_str(fs, &fs->optstr) ||
+	    unshare_str(fs, &fs->vfs_optstr) ||
+	    unshare_str(fs, &fs->fs_optstr) ||
+	    unshare_str(fs, &fs->user_optstr) ||
+	    unshare_str(fs, &fs->attrs) ||
+	    unshare_str(fs, &fs->opt_fields) ||
+	    unshare_str(fs, &fs->comment))
+		return -ENOMEM;
+	return 0;
+}
+
+static char *get_optlist_str(struct libmnt_fs *fs, int type)
+{
+	switch (type) {
+	case MNT_OPTLIST_ALL:
+		return fs->optstr;
+	case MNT_OPTLIST_VFS:
+		return fs->vfs_optstr;
+	case MNT_OPTLIST_FS:
+		return fs->fs_optstr;
+	case MNT_OPTLIST_USER:
+		return fs->user_optstr;
+	}
+	return NULL;
+}
+
+/*
+ * Returns the parsed options string (see optlist.c) or NULL if the string is
+ * not set or cannot be parsed.
+ *
+ * The list is cached and it's parsed again if the string pointer has been
+ * changed. The code which modifies the string in place has to call
+ * mnt_fs_reset_optlist().
+ */
+struct libmnt_optlist *mnt_fs_get_optlist(struct libmnt_fs *fs, int type)
+{
+	struct libmnt_optlist *ol = fs->optlist[type];
+	const char *str = get_optlist_str(fs, type);
+
+	if (ol && mnt_optlist_get_source(ol) == str)
+		return ol;
+
+	mnt_free_optlist(ol);
+	fs->optlist[type] = str ? mnt_new_optlist(str) : NULL;
+	return fs->optlist[type];
+}
+
+/*
+ * Drops the parsed options cache.
+ */
+void mnt_fs_reset_optlist(struct libmnt_fs *fs)
+{
+	size_t i;
+
+	for (i = 0; i < __MNT_OPTLIST_NR; i++) {
+		mnt_free_optlist(fs->optlist[i]);
+		fs->optlist[i] = NULL;
+	}
+}
+
+/*
+ * The same as mnt_optstr_get_flags() for the options string @type, but the
+ * parsed options cache is used for the builtin maps.
+ */
+int mnt_fs_get_optflags(struct libmnt_fs *fs, int type,
+			unsigned long *flags, const struct libmnt_optmap *map)
+{
+	struct libmnt_optlist *ol = mnt_fs_get_optlist(fs, type);
+	const char *str;
+
+	if (ol && mnt_optlist_get_flags(ol, flags, map) == 0)
+		return 0;
+
+	str = get_optlist_str(fs, type);
+	return str ? mnt_optstr_get_flags(str, flags, map) : 0;
+}
+
 /**
  * mnt_reset_fs:
  * @fs: fs pointer
@@ -78,22 +210,26 @@ void mnt_reset_fs(struct libmnt_fs *fs)
 
 	ref = fs->refcount;
 
+	if (fs->tab)
+		mnt_table_reset_index(fs->tab);
 	list_del(&fs->ents);
-	free(fs->source);
-	free(fs->bindsrc);
-	free(fs->tagname);
-	free(fs->tagval);
-	free(fs->root);
-	free(fs->swaptype);
-	free(fs->target);
-	free(fs->fstype);
-	free(fs->optstr);
-	free(fs->vfs_optstr);
-	free(fs->fs_optstr);
-	free(fs->user_optstr);
-	free(fs->attrs);
-	free(fs->opt_fields);
-	free(fs->comment);
+	free_str(fs, fs->source);
+	free_str(fs, fs->bindsrc);
+	free_str(fs, fs->tagname);
+	free_str(fs, fs->tagval);
+	free_str(fs, fs->root);
+	free_str(fs, fs->swaptype);
+	free_str(fs, fs->target);
+	free_str(fs, fs->fstype);
+	free_str(fs, fs->optstr);
+	free_str(fs, fs->vfs_optstr);
+	free_str(fs, fs->fs_optstr);
+	free_str(fs, fs->user_optstr);
+	free_str(fs, fs->attrs);
+	free_str(fs, fs->opt_fields);
+	free_str(fs, fs->comment);
+	mnt_unref_strbuf(fs->strbuf);
+	mnt_fs_reset_optlist(fs);
 
 	memset(fs, 0, sizeof(*fs));
 	INIT_LIST_HEAD(&fs->ents);
@@ -194,7 +330,10 @@ struct libmnt_fs *mnt_copy_fs(struct libmnt_fs *dest,
 		dest->tab	 = NULL;
 	}
 
-	dest->id         = src->id;
+	if (dest->tab)
+		mnt_table_reset_index(dest->tab);	/* IDs, source and target are indexed */
+
+	dest->id        = src->id;
 	dest->parent     = src->parent;
 	dest->devno      = src->devno;
 	dest->tid        = src->tid;
@@ -380,7 +519,9 @@ int __mnt_fs_set_source_ptr(struct libmnt_fs *fs, char *source)
 	}
 
 	if (fs->source != source)
-		free(fs->source);
+		free_str(fs, fs->source);
+	if (fs->tab)
+		mnt_table_reset_index(fs->tab);	/* source is indexed */
 
 	free(fs->tagname);
 	free(fs->tagval);
@@ -549,6 +690,11 @@ const char *mnt_fs_get_target(struct libmnt_fs *fs)
  */
 int mnt_fs_set_target(struct libmnt_fs *fs, const char *tgt)
 {
+	if (!fs)
+		return -EINVAL;
+	if (fs->tab)
+		mnt_table_reset_index(fs->tab);	/* target is indexed */
+	release_str(fs, &fs->target);
 	return strdup_to_struct_member(fs, target, tgt);
 }
 
@@ -653,7 +799,7 @@ int __mnt_fs_set_fstype_ptr(struct libmnt_fs *fs, char *fstype)
 	assert(fs);
 
 	if (fstype != fs->fstype)
-		free(fs->fstype);
+		free_str(fs, fs->fstype);
 
 	fs->fstype = fstype;
 	fs->flags &= ~MNT_FS_PSEUDO;
@@ -832,10 +978,11 @@ int mnt_fs_set_options(struct libmnt_fs *fs, const char *optstr)
 		}
 	}
 
-	free(fs->fs_optstr);
-	free(fs->vfs_optstr);
-	free(fs->user_optstr);
-	free(fs->optstr);
+	free_str(fs, fs->fs_optstr);
+	free_str(fs, fs->vfs_optstr);
+	free_str(fs, fs->user_optstr);
+	free_str(fs, fs->optstr);
+	mnt_fs_reset_optlist(fs);
 
 	fs->fs_optstr = f;
 	fs->vfs_optstr = v;
@@ -871,6 +1018,16 @@ int mnt_fs_append_options(struct libmnt_fs *fs, const char *optstr)
 	if (rc)
 		return rc;
 
+	mnt_fs_reset_optlist(fs);
+	if (v)
+		rc = unshare_str(fs, &fs->vfs_optstr);
+	if (!rc && f)
+		rc = unshare_str(fs, &fs->fs_optstr);
+	if (!rc && u)
+		rc = unshare_str(fs, &fs->user_optstr);
+	if (!rc)
+		rc = unshare_str(fs, &fs->optstr);
+
 	if (!rc && v)
 		rc = mnt_optstr_append_option(&fs->vfs_optstr, v, NULL);
 	if (!rc && f)
@@ -913,6 +1070,16 @@ int mnt_fs_prepend_options(struct libmnt_fs *fs, const char *optstr)
 	if (rc)
 		return rc;
 
+	mnt_fs_reset_optlist(fs);
+	if (v)
+		rc = unshare_str(fs, &fs->vfs_optstr);
+	if (!rc && f)
+		rc = unshare_str(fs, &fs->fs_optstr);
+	if (!rc && u)
+		rc = unshare_str(fs, &fs->user_optstr);
+	if (!rc)
+		rc = unshare_str(fs, &fs->optstr);
+
 	if (!rc && v)
 		rc = mnt_optstr_prepend_option(&fs->vfs_optstr, v, NULL);
 	if (!rc && f)
@@ -990,6 +1157,9 @@ const char *mnt_fs_get_attributes(struct libmnt_fs *fs)
  */
 int mnt_fs_set_attributes(struct libmnt_fs *fs, const char *optstr)
 {
+	if (!fs)
+		return -EINVAL;
+	release_str(fs, &fs->attrs);
 	return strdup_to_struct_member(fs, attrs, optstr);
 }
 
@@ -1008,6 +1178,8 @@ int mnt_fs_append_attributes(struct libmnt_fs *fs, const char *optstr)
 		return -EINVAL;
 	if (!optstr)
 		return 0;
+	if (unshare_str(fs, &fs->attrs))
+		return -ENOMEM;
 	return mnt_optstr_append_option(&fs->attrs, optstr, NULL);
 }
 
@@ -1026,6 +1198,8 @@ int mnt_fs_prepend_attributes(struct libmnt_fs *fs, const char *optstr)
 		return -EINVAL;
 	if (!optstr)
 		return 0;
+	if (unshare_str(fs, &fs->attrs))
+		return -ENOMEM;
 	return mnt_optstr_prepend_option(&fs->attrs, optstr, NULL);
 }
 
@@ -1102,6 +1276,9 @@ const char *mnt_fs_get_root(struct libmnt_fs *fs)
  */
 int mnt_fs_set_root(struct libmnt_fs *fs, const char *path)
 {
+	if (!fs)
+		return -EINVAL;
+	release_str(fs, &fs->root);
 	return strdup_to_struct_member(fs, root, path);
 }
 
@@ -1186,6 +1363,9 @@ const char *mnt_fs_get_bindsrc(struct libmnt_fs *fs)
  */
 int mnt_fs_set_bindsrc(struct libmnt_fs *fs, const char *src)
 {
+	if (!fs)
+		return -EINVAL;
+	release_str(fs, &fs->bindsrc);
 	return strdup_to_struct_member(fs, bindsrc, src);
 }
 
@@ -1247,14 +1427,24 @@ int mnt_fs_get_option(struct libmnt_fs *fs, const char *name,
 {
 	char rc = 1;
 
+	static const int types[] = { MNT_OPTLIST_FS, MNT_OPTLIST_VFS, MNT_OPTLIST_USER };
+	size_t i;
+
 	if (!fs)
 		return -EINVAL;
-	if (fs->fs_optstr)
-		rc = mnt_optstr_get_option(fs->fs_optstr, name, value, valsz);
-	if (rc == 1 && fs->vfs_optstr)
-		rc = mnt_optstr_get_option(fs->vfs_optstr, name, value, valsz);
-	if (rc == 1 && fs->user_optstr)
-		rc = mnt_optstr_get_option(fs->user_optstr, name, value, valsz);
+
+	for (i = 0; rc == 1 && i < ARRAY_SIZE(types); i++) {
+		struct libmnt_optlist *ol;
+		const char *str = get_optlist_str(fs, types[i]);
+
+		if (!str)
+			continue;
+		ol = mnt_fs_get_optlist(fs, types[i]);
+		if (ol)
+			rc = mnt_optlist_get_option(ol, name, value, valsz);
+		else
+			rc = mnt_optstr_get_option(str, name, value, valsz);
+	}
 	return rc;
 }
 
@@ -1305,6 +1495,9 @@ const char *mnt_fs_get_comment(struct libmnt_fs *fs)
  */
 int mnt_fs_set_comment(struct libmnt_fs *fs, const char *comm)
 {
+	if (!fs)
+		return -EINVAL;
+	release_str(fs, &fs->comment);
 	return strdup_to_struct_member(fs, comment, comm);
 }
 
@@ -1321,6 +1514,8 @@ int mnt_fs_append_comment(struct libmnt_fs *fs, const char *comm)
 {
 	if (!fs)
 		return -EINVAL;
+	if (unshare_str(fs, &fs->comment))
+		return -ENOMEM;
 
 	return append_string(&fs->comment, comm);
 }
@@ -1484,6 +1679,11 @@ int mnt_fs_match_fstype(struct libmnt_fs *fs, const char *types)
  */
 int mnt_fs_match_options(struct libmnt_fs *fs, const char *options)
 {
+	struct libmnt_optlist *ol = fs && fs->optstr ?
+			mnt_fs_get_optlist(fs, MNT_OPTLIST_ALL) : NULL;
+
+	if (ol)
+		return mnt_optlist_match(ol, options);
 	return mnt_match_options(mnt_fs_get_options(fs), options);
 }
 
@@ -0,0 +1,300 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * This file is part of libmount from util-linux project.
+ *
+ * libmount is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ */
+
+/**
+ * SECTION: livetab
+ * @title: Live mount table
+ * @short_description: kernel mount table kept up to date by the monitor
+ *
+ * The live table owns parsed /proc/self/mountinfo and the kernel monitor. The
+ * table is parsed again only if the monitor reports a change, and the changes
+ * are available as a tabdiff (see mnt_diff_tables_by_id(), the entries are
+ * compared by mount IDs, so the diff is linear).
+ *
+ * <informalexample>
+ *   <programlisting>
+ * struct libmnt_livetab *lt = mnt_new_livetab();
+ * struct libmnt_iter *itr = mnt_new_iter(MNT_ITER_FORWARD);
+ * struct pollfd fds = { .fd = mnt_livetab_get_fd(lt), .events = POLLIN };
+ *
+ * while (poll(&fds, 1, -1) > 0) {
+ *    struct libmnt_tabdiff *df;
+ *    struct libmnt_fs *old, *new;
+ *    int oper;
+ *
+ *    if (mnt_livetab_update(lt, &df) <= 0)
+ *       continue;
+ *    mnt_reset_iter(itr, MNT_ITER_FORWARD);
+ *    while (mnt_tabdiff_next_change(df, itr, &old, &new, &oper) == 0)
+ *       ...
+ * }
+ * mnt_unref_livetab(lt);
+ *   </programlisting>
+ * </informalexample>
+ */
+#include "mountP.h"
+#include "pathnames.h"
+
+struct libmnt_livetab {
+	int			refcount;
+
+	struct libmnt_monitor	*mn;		/* kernel monitor */
+	struct libmnt_table	*tb;		/* current mountinfo */
+	struct libmnt_tabdiff	*diff;		/* changes from the previous update */
+
+	unsigned int		nupdates;	/* number of reparses */
+};
+
+/**
+ * mnt_new_livetab:
+ *
+ * The initial refcount is 1, and needs to be decremented to release the
+ * resources. The mountinfo is not parsed before the first
+ * mnt_livetab_update() call.
+ *
+ * Returns: newly allocated struct libmnt_livetab or NULL.
+ *
+ * Since: 2.37
+ */
+struct libmnt_livetab *mnt_new_livetab(void)
+{
+	struct libmnt_livetab *lt = calloc(1, sizeof(*lt));
+
+	if (!lt)
+		return NULL;
+
+	lt->refcount = 1;
+	lt->mn = mnt_new_monitor();
+	lt->diff = mnt_new_tabdiff();
+	if (!lt->mn || !lt->diff || mnt_monitor_enable_kernel(lt->mn, TRUE) != 0) {
+		mnt_unref_livetab(lt);
+		return NULL;
+	}
+
+	DBG(MONITOR, ul_debugobj(lt, "alloc livetab"));
+	return lt;
+}
+
+/**
+ * mnt_ref_livetab:
+ * @lt: live table
+ *
+ * Increments reference counter.
+ *
+ * Since: 2.37
+ */
+void mnt_ref_livetab(struct libmnt_livetab *lt)
+{
+	if (lt)
+		lt->refcount++;
+}
+
+/**
+ * mnt_unref_livetab:
+ * @lt: live table
+ *
+ * Decrements the reference counter, on zero the @lt is automatically
+ * deallocated.
+ *
+ * Since: 2.37
+ */
+void mnt_unref_livetab(struct libmnt_livetab *lt)
+{
+	if (!lt)
+		return;
+
+	lt->refcount--;
+	if (lt->refcount <= 0) {
+		DBG(MONITOR, ul_debugobj(lt, "free livetab [updates=%u]", lt->nupdates));
+		mnt_unref_monitor(lt->mn);
+		mnt_unref_table(lt->tb);
+		mnt_free_tabdiff(lt->diff);
+		free(lt);
+	}
+}
+
+/**
+ * mnt_livetab_get_fd:
+ * @lt: live table
+ *
+ * The file descriptor is usable for example for poll() or epoll; it's
+ * readable if the mount table has been changed. Call mnt_livetab_update()
+ * after each event.
+ *
+ * Returns: >=0 (fd) on success, <0 on error
+ *
+ * Since: 2.37
+ */
+int mnt_livetab_get_fd(struct libmnt_livetab *lt)
+{
+	if (!lt)
+		return -EINVAL;
+	return mnt_monitor_get_fd(lt->mn);
+}
+
+/**
+ * mnt_livetab_update:
+ * @lt: live table
+ * @diff: returns changes since the previous update (optional)
+ *
+ * Drains monitor events and if the mount table has been changed (or on the
+ * first call) parses /proc/self/mountinfo and compares it with the previous
+ * table. All filesystems are reported as MNT_TABDIFF_MOUNT on the first call.
+ *
+ * The @diff is owned by @lt and it's valid until the next
+ * mnt_livetab_update() call.
+ *
+ * Returns: number of changes, 0 if nothing changed or negative number in case
+ * of error.
+ *
+ * Since: 2.37
+ */
+int mnt_livetab_update(struct libmnt_livetab *lt, struct libmnt_tabdiff **diff)
+{
+	struct libmnt_table *tb, *old;
+	int rc, changed = 0;
+
+	if (!lt)
+		return -EINVAL;
+	if (diff)
+		*diff = lt->diff;
+
+	if (mnt_monitor_get_fd(lt->mn) < 0)
+		return -errno;
+
+	/* drain events before parsing, the next update catches later changes */
+	while ((rc = mnt_monitor_next_change(lt->mn, NULL, NULL)) == 0)
+		changed = 1;
+	if (rc < 0)
+		return rc;
+
+	if (lt->tb && !changed) {
+		mnt_tabdiff_reset(lt->diff);
+		return 0;
+	}
+
+	tb = mnt_new_table();
+	if (!tb)
+		return -ENOMEM;
+	rc = mnt_table_parse_file(tb, _PATH_PROC_MOUNTINFO);
+	if (rc) {
+		mnt_unref_table(tb);
+		return rc;
+	}
+	lt->nupdates++;
+
+	old = lt->tb ? lt->tb : mnt_new_table();
+	if (!old) {
+		mnt_unref_table(tb);
+		return -ENOMEM;
+	}
+
+	rc = mnt_diff_tables_by_id(lt->diff, old, tb);
+
+	DBG(MONITOR, ul_debugobj(lt, "livetab update: %d entries, %d changes",
+				mnt_table_get_nents(tb), rc));
+
+	/* the diff keeps references to the old entries */
+	mnt_unref_table(old);
+	lt->tb = tb;
+	return rc;
+}
+
+/**
+ * mnt_livetab_get_table:
+ * @lt: live table
+ * @tb: returns the current mount table
+ *
+ * The table is owned by @lt and it's valid until the next
+ * mnt_livetab_update() call; use mnt_ref_table() to keep it longer.
+ *
+ * Returns: 0 on success, 1 if the table has not been parsed yet, negative
+ * number in case of error.
+ *
+ * Since: 2.37
+ */
+int mnt_livetab_get_table(struct libmnt_livetab *lt, struct libmnt_table **tb)
+{
+	if (!lt || !tb)
+		return -EINVAL;
+
+	*tb = lt->tb;
+	return lt->tb ? 0 : 1;
+}
+
+#ifdef TEST_PROGRAM
+#include <poll.h>
+
+static int test_update(struct libmnt_test *ts, int argc, char *argv[])
+{
+	struct libmnt_livetab *lt = mnt_new_livetab();
+	struct libmnt_iter *itr = mnt_new_iter(MNT_ITER_FORWARD);
+	struct pollfd fds = { .events = POLLIN };
+	int rc = -1;
+
+	if (!lt || !itr) {
+		warn("failed to allocate live table");
+		goto done;
+	}
+
+	fds.fd = mnt_livetab_get_fd(lt);
+	if (fds.fd < 0) {
+		warn("failed to initialize monitor fd");
+		goto done;
+	}
+
+	rc = mnt_livetab_update(lt, NULL);
+	if (rc < 0) {
+		warn("failed to parse mountinfo");
+		goto done;
+	}
+	printf("%d filesystems, waiting for changes...\n", rc);
+
+	while (poll(&fds, 1, -1) > 0) {
+		struct libmnt_tabdiff *df;
+		struct libmnt_fs *old, *new;
+		int oper;
+
+		rc = mnt_livetab_update(lt, &df);
+		if (rc < 0)
+			break;
+
+		mnt_reset_iter(itr, MNT_ITER_FORWARD);
+		while (mnt_tabdiff_next_change(df, itr, &old, &new, &oper) == 0) {
+			struct libmnt_fs *fs = new ? new : old;
+
+			printf(" [%d] %s on %s: %s\n",
+				mnt_fs_get_id(fs),
+				mnt_fs_get_source(fs),
+				mnt_fs_get_target(fs),
+				oper == MNT_TABDIFF_MOUNT ? "MOUNTED" :
+				oper == MNT_TABDIFF_UMOUNT ? "UMOUNTED" :
+				oper == MNT_TABDIFF_MOVE ? "MOVED" :
+				oper == MNT_TABDIFF_REMOUNT ? "REMOUNTED" : "unknown");
+		}
+	}
+	rc = rc < 0 ? rc : 0;
+done:
+	mnt_free_iter(itr);
+	mnt_unref_livetab(lt);
+	return rc;
+}
+
+int main(int argc, char *argv[])
+{
+	struct libmnt_test tss[] = {
+		{ "--update", test_update, "print changes in the mount table" },
+		{ NULL }
+	};
+
+	return mnt_run_test(tss, argc, argv);
+}
+
+#endif /* TEST_PROGRAM */
@@ -45,6 +45,8 @@ struct libmnt_lock {
 			simplelock :1;	/* use flock rather than normal mtab lock */
 
 	sigset_t oldsigmask;
+
+	struct libmnt_stat *stat;	/* wait time statistics or NULL */
 };
 
 
@@ -166,6 +168,15 @@ int mnt_lock_use_simplelock(struct libmnt_lock *ml, int enable)
 	return 0;
 }
 
+/*
+ * Private API: the time spent in mnt_lock_file() is accounted to @st.
+ */
+void mnt_lock_set_stat(struct libmnt_lock *ml, struct libmnt_stat *st)
+{
+	if (ml)
+		ml->stat = st;
+}
+
 /*
  * Returns path to lockfile.
  */
@@ -541,13 +552,22 @@ failed:
  */
 int mnt_lock_file(struct libmnt_lock *ml)
 {
+	uint64_t start;
+	int rc;
+
 	if (!ml)
 		return -EINVAL;
 
+	start = ml->stat ? mnt_stat_start() : 0;
+
 	if (ml->simplelock)
-		return lock_simplelock(ml);
+		rc = lock_simplelock(ml);
+	else
+		rc = lock_mtab(ml);
 
-	return lock_mtab(ml);
+	if (ml->stat)
+		mnt_stat_add(ml->stat, start);
+	return rc;
 }
 
 /**
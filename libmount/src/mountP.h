@@ -18,6 +18,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/types.h>
 #include <sys/vfs.h>
 #include <unistd.h>
@@ -123,9 +124,24 @@ extern void mnt_free_filesystems(char **filesystems);
 extern char *mnt_get_kernel_cmdline_option(const char *name);
 extern int mnt_stat_mountpoint(const char *target, struct stat *st);
 extern int mnt_lstat_mountpoint(const char *target, struct stat *st);
+extern int mnt_get_mount_id(const char *target, int *id, int *root);
+
+/*
+ * Context statistics counter, see mnt_context_get_stat()
+ */
+struct libmnt_stat {
+	unsigned long	count;		/* number of calls */
+	uint64_t	usec;		/* total time */
+};
+
+#define MNT_NSTATS	(MNT_STAT_UPDATE + 1)
+
+extern uint64_t mnt_stat_start(void);
+extern void mnt_stat_add(struct libmnt_stat *st, uint64_t start);
 
 /* tab.c */
 extern int is_mountinfo(struct libmnt_table *tb);
+extern struct libmnt_fs *__mnt_table_find_id(struct libmnt_table *tb, int id);
 extern int mnt_table_set_parser_fltrcb(	struct libmnt_table *tb,
 					int (*cb)(struct libmnt_fs *, void *),
 					void *data);
@@ -170,6 +186,42 @@ struct libmnt_iter {
 	} while(0)
 
 
+/*
+ * Buffer with the whole parsed mountinfo file. The parsed entries point to the
+ * strings in the buffer rather than to private copies (see tab_parse.c).
+ */
+struct libmnt_strbuf {
+	int		refcount;	/* reference counter */
+	size_t		size;		/* size of the data */
+	char		data[];
+};
+
+/*
+ * Table index types (see tab_idx.c)
+ */
+enum {
+	MNT_TABIDX_TARGET,
+	MNT_TABIDX_SRCPATH,
+	MNT_TABIDX_DEVNO,
+	MNT_TABIDX_ID,
+
+	__MNT_TABIDX_NR
+};
+
+/*
+ * Parsed options strings of struct libmnt_fs (see optlist.c)
+ */
+enum {
+	MNT_OPTLIST_ALL,	/* optstr */
+	MNT_OPTLIST_VFS,	/* vfs_optstr */
+	MNT_OPTLIST_FS,		/* fs_optstr */
+	MNT_OPTLIST_USER,	/* user_optstr */
+
+	__MNT_OPTLIST_NR
+};
+
+struct libmnt_optlist;
+
 /*
  * This struct represents one entry in a mtab/fstab/mountinfo file.
  * (note that fstab[1] means the first column from fstab, and so on...)
@@ -177,6 +229,8 @@ struct libmnt_iter {
 struct libmnt_fs {
 	struct list_head ents;
 	struct libmnt_table *tab;
+	struct list_head idxents[__MNT_TABIDX_NR];	/* table index chains */
+	size_t		treepos;	/* position in the table tree */
 
 	int		refcount;	/* reference counter */
 	int		id;		/* mountinfo[1]: ID */
@@ -201,6 +255,8 @@ struct libmnt_fs {
 	char		*user_optstr;	/* userspace mount options */
 	char		*attrs;		/* mount attributes */
 
+	struct libmnt_optlist *optlist[__MNT_OPTLIST_NR]; /* parsed options cache */
+
 	int		freq;		/* fstab[5]: dump frequency in days */
 	int		passno;		/* fstab[6]: pass number on parallel fsck */
 
@@ -215,6 +271,8 @@ struct libmnt_fs {
 
 	char		*comment;	/* fstab comment */
 
+	struct libmnt_strbuf *strbuf;	/* shared strings or NULL */
+
 	void		*userdata;	/* library independent data */
 };
 
@@ -239,6 +297,7 @@ struct libmnt_table {
 	int		nents;		/* number of entries */
 	int		refcount;	/* reference counter */
 	int		comms;		/* enable/disable comment parsing */
+	int		nozerocopy;	/* don't share strings between entries */
 	char		*comm_intro;	/* First comment in file */
 	char		*comm_tail;	/* Last comment in file */
 
@@ -253,10 +312,33 @@ struct libmnt_table {
 
 	struct list_head	ents;	/* list of entries (libmnt_fs) */
 	void		*userdata;
+
+	struct libmnt_tabidx	*idx;	/* lookup index or NULL */
+	struct libmnt_fs **tree;	/* entries sorted by parent and ID or NULL */
+	size_t		ntree;		/* number of entries in the tree */
+	int		noindex;	/* don't use index (tests) */
 };
 
 extern struct libmnt_table *__mnt_new_table_from_file(const char *filename, int fmt, int empty_for_enoent);
 
+/* tab_diff.c */
+extern int mnt_tabdiff_reset(struct libmnt_tabdiff *df);
+
+/* tab_idx.c */
+extern unsigned int mnt_tabidx_hash_path(const char *path);
+extern unsigned int mnt_tabidx_hash_num(uint64_t num);
+extern void mnt_table_reset_index(struct libmnt_table *tb);
+extern int mnt_table_use_index(struct libmnt_table *tb);
+extern void mnt_table_index_add_fs(struct libmnt_table *tb, struct libmnt_fs *fs);
+extern void mnt_table_index_remove_fs(struct libmnt_table *tb, struct libmnt_fs *fs);
+extern int mnt_table_index_get_ntags(struct libmnt_table *tb);
+extern struct libmnt_fs *mnt_table_index_next(struct libmnt_table *tb, int type,
+				unsigned int hash, struct libmnt_fs *prev,
+				int direction);
+extern int mnt_table_use_tree(struct libmnt_table *tb);
+extern struct libmnt_fs *mnt_table_tree_first_child(struct libmnt_table *tb, int parent_id);
+extern struct libmnt_fs *mnt_table_tree_next_child(struct libmnt_table *tb, struct libmnt_fs *fs);
+
 /*
  * Tab file format
  */
@@ -278,6 +360,19 @@ struct libmnt_addmount {
 	struct list_head	mounts;
 };
 
+/*
+ * "mount -a --fork" child
+ */
+struct libmnt_child {
+	pid_t		pid;
+	int		pidfd;		/* pidfd_open() or -1 */
+	int		status;		/* waitpid() status */
+	unsigned int	done : 1;	/* already waited for */
+
+	struct libmnt_fs *fs;		/* mounted fstab entry */
+	struct timeval	start;		/* fork time */
+};
+
 struct libmnt_ns {
 	int fd;				/* file descriptor of namespace, -1 when inactive */
 	struct libmnt_cache *cache;	/* paths cache associated with NS */
@@ -340,10 +435,15 @@ struct libmnt_context
 
 	char	*orig_user;	/* original (non-fixed) user= option */
 
-	pid_t	*children;	/* "mount -a --fork" PIDs */
+	struct libmnt_child *children;	/* "mount -a --fork" children */
 	int	nchildren;	/* number of children */
+	int	maxjobs;	/* max. running children, 0=unlimited */
 	pid_t	pid;		/* 0=parent; PID=child */
 
+	void	(*child_cb)(struct libmnt_context *, struct libmnt_fs *, int, unsigned long);
+
+	struct libmnt_stat stats[MNT_NSTATS];	/* see mnt_context_get_stat() */
+
 
 	int	syscall_status;	/* 1: not called yet, 0: success, <0: -errno */
 
@@ -354,6 +454,9 @@ struct libmnt_context
 	unsigned int	enabled_textdomain : 1;		/* bindtextdomain() called */
 };
 
+#define mnt_context_add_stat(_cxt, _id, _start) \
+		mnt_stat_add(&(_cxt)->stats[_id], _start)
+
 /* flags */
 #define MNT_FL_NOMTAB		(1 << 1)
 #define MNT_FL_FAKE		(1 << 2)
@@ -389,6 +492,7 @@ struct libmnt_context
 
 /* lock.c */
 extern int mnt_lock_use_simplelock(struct libmnt_lock *ml, int enable);
+extern void mnt_lock_set_stat(struct libmnt_lock *ml, struct libmnt_stat *st);
 
 /* optmap.c */
 extern const struct libmnt_optmap *mnt_optmap_get_entry(
@@ -405,6 +509,16 @@ extern int mnt_optstr_fix_uid(char **optstr, char *value, size_t valsz, char **n
 extern int mnt_optstr_fix_secontext(char **optstr, char *value, size_t valsz, char **next);
 extern int mnt_optstr_fix_user(char **optstr);
 
+/* optlist.c */
+extern struct libmnt_optlist *mnt_new_optlist(const char *optstr);
+extern void mnt_free_optlist(struct libmnt_optlist *ol);
+extern const char *mnt_optlist_get_source(struct libmnt_optlist *ol);
+extern int mnt_optlist_get_flags(struct libmnt_optlist *ol, unsigned long *flags,
+				 const struct libmnt_optmap *map);
+extern int mnt_optlist_get_option(struct libmnt_optlist *ol, const char *name,
+				  char **value, size_t *valsz);
+extern int mnt_optlist_match(struct libmnt_optlist *ol, const char *pattern);
+
 /* fs.c */
 extern struct libmnt_fs *mnt_copy_mtab_fs(const struct libmnt_fs *fs)
 			__attribute__((nonnull));
@@ -412,6 +526,15 @@ extern int __mnt_fs_set_source_ptr(struct libmnt_fs *fs, char *source)
 			__attribute__((nonnull(1)));
 extern int __mnt_fs_set_fstype_ptr(struct libmnt_fs *fs, char *fstype)
 			__attribute__((nonnull(1)));
+extern int mnt_fs_unshare(struct libmnt_fs *fs);
+extern struct libmnt_optlist *mnt_fs_get_optlist(struct libmnt_fs *fs, int type);
+extern void mnt_fs_reset_optlist(struct libmnt_fs *fs);
+extern int mnt_fs_get_optflags(struct libmnt_fs *fs, int type,
+			unsigned long *flags, const struct libmnt_optmap *map);
+
+/* tab_parse.c */
+extern void mnt_ref_strbuf(struct libmnt_strbuf *sb);
+extern void mnt_unref_strbuf(struct libmnt_strbuf *sb);
 
 /* context.c */
 extern struct libmnt_context *mnt_copy_context(struct libmnt_context *o);
@@ -421,6 +544,8 @@ extern const char *mnt_context_get_writable_tabpath(struct libmnt_context *cxt);
 
 extern int mnt_context_get_mtab_for_target(struct libmnt_context *cxt,
 				    struct libmnt_table **mtab, const char *tgt);
+extern int mnt_context_get_mtab_for_mntid(struct libmnt_context *cxt,
+				    struct libmnt_table **mtab, const char *tgt, int *id);
 
 extern int mnt_context_prepare_srcpath(struct libmnt_context *cxt);
 extern int mnt_context_prepare_target(struct libmnt_context *cxt);
@@ -448,7 +573,7 @@ extern int mnt_context_setup_loopdev(struct libmnt_context *cxt);
 extern int mnt_context_delete_loopdev(struct libmnt_context *cxt);
 extern int mnt_context_clear_loopdev(struct libmnt_context *cxt);
 
-extern int mnt_fork_context(struct libmnt_context *cxt);
+extern int mnt_fork_context(struct libmnt_context *cxt, struct libmnt_fs *fs);
 
 extern int mnt_context_set_tabfilter(struct libmnt_context *cxt,
 				     int (*fltr)(struct libmnt_fs *, void *),
@@ -474,6 +599,8 @@ extern int mnt_update_set_filename(struct libmnt_update *upd,
 				   const char *filename, int userspace_only);
 extern int mnt_update_already_done(struct libmnt_update *upd,
 				   struct libmnt_lock *lc);
+extern void mnt_update_set_lock_stat(struct libmnt_update *upd,
+				     struct libmnt_stat *st);
 
 #if __linux__
 /* btrfs.c */
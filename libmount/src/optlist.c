@@ -0,0 +1,270 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * This file is part of libmount from util-linux project.
+ *
+ * libmount is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Parsed options string.
+ *
+ * The options list is an array of name and value spans. It's cached in struct
+ * libmnt_fs for every options string (see mnt_fs_get_optlist()), so repeated
+ * lookups do not tokenize the string again. The options are resolved in the
+ * builtin MNT_LINUX_MAP and MNT_USERSPACE_MAP maps on the first flags
+ * request, and the flags are kept as a set/clear masks pair, so
+ * mnt_optlist_get_flags() is O(1) for the next calls.
+ *
+ * The strings in struct libmnt_fs are still the primary representation (the
+ * public API returns them), the list is only a cache. The list owns a copy of
+ * the string and all the spans point to the copy. The cache has to be dropped
+ * by mnt_fs_reset_optlist() when the string is modified.
+ */
+#include "strutils.h"
+#include "mountP.h"
+
+struct libmnt_opt {
+	char		*name;
+	size_t		namesz;
+	char		*value;		/* NULL if there is no '=' */
+	size_t		valsz;
+};
+
+struct libmnt_optlist {
+	const char	*src;		/* parsed string */
+	char		*optstr;	/* private copy, the spans point here */
+
+	unsigned int	resolved : 1;	/* flags are already evaluated */
+
+	unsigned long	mflags_set;	/* MNT_LINUX_MAP flags */
+	unsigned long	mflags_clr;
+	unsigned long	uflags_set;	/* MNT_USERSPACE_MAP flags */
+	unsigned long	uflags_clr;
+
+	size_t		nopts;
+	struct libmnt_opt opts[];
+};
+
+#define mnt_optmap_entry_novalue(e) \
+		(e && (e)->name && !strchr((e)->name, '=') && !((e)->mask & MNT_PREFIX))
+
+/*
+ * Returns: new list or NULL in case of error (errno is set to EINVAL on parse
+ * error).
+ */
+struct libmnt_optlist *mnt_new_optlist(const char *optstr)
+{
+	struct libmnt_optlist *ol;
+	const char *p;
+	char *str, *name, *val;
+	size_t namesz, valsz, n = 1;
+	int rc;
+
+	if (!optstr) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	for (p = optstr; *p; p++) {
+		if (*p == ',')
+			n++;
+	}
+
+	ol = calloc(1, sizeof(*ol) + n * sizeof(struct libmnt_opt));
+	if (!ol)
+		return NULL;
+	ol->optstr = strdup(optstr);
+	if (!ol->optstr) {
+		free(ol);
+		return NULL;
+	}
+	ol->src = optstr;
+
+	str = ol->optstr;
+	while ((rc = mnt_optstr_next_option(&str, &name, &namesz, &val, &valsz)) == 0) {
+		struct libmnt_opt *o = &ol->opts[ol->nopts++];
+
+		o->name = name;
+		o->namesz = namesz;
+		o->value = val;
+		o->valsz = valsz;
+	}
+	if (rc < 0) {
+		mnt_free_optlist(ol);
+		errno = EINVAL;
+		return NULL;
+	}
+	return ol;
+}
+
+void mnt_free_optlist(struct libmnt_optlist *ol)
+{
+	if (!ol)
+		return;
+	free(ol->optstr);
+	free(ol);
+}
+
+/*
+ * Returns the string the list has been parsed from.
+ */
+const char *mnt_optlist_get_source(struct libmnt_optlist *ol)
+{
+	return ol ? ol->src : NULL;
+}
+
+static inline void set_bits(unsigned long *set, unsigned long *clr, unsigned long bits)
+{
+	*set |= bits;
+	*clr &= ~bits;
+}
+
+static inline void clear_bits(unsigned long *set, unsigned long *clr, unsigned long bits)
+{
+	*clr |= bits;
+	*set &= ~bits;
+}
+
+/*
+ * Evaluates all options in the same way as mnt_optstr_get_flags() for
+ * MNT_LINUX_MAP and MNT_USERSPACE_MAP. The later option overwrites the
+ * previous one (e.g. "ro,rw"), so the result is stored as set and clear masks.
+ */
+static void optlist_resolve(struct libmnt_optlist *ol)
+{
+	const struct libmnt_optmap *maps[2];
+	size_t i;
+
+	maps[0] = mnt_get_builtin_optmap(MNT_LINUX_MAP);
+	maps[1] = mnt_get_builtin_optmap(MNT_USERSPACE_MAP);
+
+	for (i = 0; i < ol->nopts; i++) {
+		struct libmnt_opt *o = &ol->opts[i];
+		const struct libmnt_optmap *ent, *uent, *m;
+
+		/* MNT_LINUX_MAP flags (maps[1] for "user") */
+		m = mnt_optmap_get_entry(maps, 2, o->name, o->namesz, &ent);
+		if (m && ent && ent->id
+		    && !(o->valsz && mnt_optmap_entry_novalue(ent))) {
+			if (m == maps[0]) {
+				if (ent->mask & MNT_INVERT)
+					clear_bits(&ol->mflags_set, &ol->mflags_clr, ent->id);
+				else
+					set_bits(&ol->mflags_set, &ol->mflags_clr, ent->id);
+
+			} else if (o->valsz == 0 && !(ent->mask & MNT_INVERT)) {
+				/* "user" is interpreted as MS_NO{EXEC,SUID,DEV} */
+				if (ent->id & (MNT_MS_OWNER | MNT_MS_GROUP))
+					set_bits(&ol->mflags_set, &ol->mflags_clr, MS_OWNERSECURE);
+				else if (ent->id & (MNT_MS_USER | MNT_MS_USERS))
+					set_bits(&ol->mflags_set, &ol->mflags_clr, MS_SECURE);
+			}
+		}
+
+		/* MNT_USERSPACE_MAP flags */
+		if (m == maps[0])
+			mnt_optmap_get_entry(&maps[1], 1, o->name, o->namesz, &uent);
+		else
+			uent = ent;
+		if (!uent || !uent->id
+		    || (o->valsz && mnt_optmap_entry_novalue(uent)))
+			continue;
+		if (uent->mask & MNT_INVERT)
+			clear_bits(&ol->uflags_set, &ol->uflags_clr, uent->id);
+		else
+			set_bits(&ol->uflags_set, &ol->uflags_clr, uent->id);
+	}
+
+	ol->resolved = 1;
+}
+
+/*
+ * The same as mnt_optstr_get_flags(), but only for the builtin maps.
+ *
+ * Returns: 0 on success, 1 if @map is not supported.
+ */
+int mnt_optlist_get_flags(struct libmnt_optlist *ol, unsigned long *flags,
+			  const struct libmnt_optmap *map)
+{
+	if (!ol->resolved)
+		optlist_resolve(ol);
+
+	if (map == mnt_get_builtin_optmap(MNT_LINUX_MAP))
+		*flags = (*flags & ~ol->mflags_clr) | ol->mflags_set;
+	else if (map == mnt_get_builtin_optmap(MNT_USERSPACE_MAP))
+		*flags = (*flags & ~ol->uflags_clr) | ol->uflags_set;
+	else
+		return 1;
+	return 0;
+}
+
+static struct libmnt_opt *optlist_find(struct libmnt_optlist *ol,
+				       const char *name, size_t namesz)
+{
+	size_t i;
+
+	for (i = 0; i < ol->nopts; i++) {
+		struct libmnt_opt *o = &ol->opts[i];
+
+		if (o->namesz == namesz && memcmp(o->name, name, namesz) == 0)
+			return o;
+	}
+	return NULL;
+}
+
+/*
+ * The same as mnt_optstr_get_option(), the @value points to the private copy
+ * of the string.
+ *
+ * Returns: 0 on success, 1 when not found.
+ */
+int mnt_optlist_get_option(struct libmnt_optlist *ol, const char *name,
+			   char **value, size_t *valsz)
+{
+	struct libmnt_opt *o = optlist_find(ol, name, strlen(name));
+
+	if (!o)
+		return 1;
+	if (value)
+		*value = o->value;
+	if (valsz)
+		*valsz = o->valsz;
+	return 0;
+}
+
+/*
+ * The same as mnt_match_options().
+ */
+int mnt_optlist_match(struct libmnt_optlist *ol, const char *pattern)
+{
+	char *name, *pat = (char *) pattern;
+	char *patval;
+	size_t namesz = 0, patvalsz = 0;
+	int match = 1;
+
+	if (!pattern)
+		return 0;
+
+	while (match && !mnt_optstr_next_option(&pat, &name, &namesz,
+						&patval, &patvalsz)) {
+		struct libmnt_opt *o;
+		int no = 0;
+
+		if (*name == '+')
+			name++, namesz--;
+		else if ((no = (startswith(name, "no") != NULL)))
+			name += 2, namesz -= 2;
+
+		o = optlist_find(ol, name, namesz);
+
+		/* check also value (if the pattern is "foo=value") */
+		if (o && patvalsz > 0 &&
+		    (patvalsz != o->valsz || strncmp(patval, o->value, o->valsz) != 0))
+			o = NULL;
+
+		match = o ? !no : no;
+	}
+
+	return match;
+}
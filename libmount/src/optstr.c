@@ -1165,6 +1165,7 @@ int mnt_match_options(const char *optstr, const char *pattern)
 }
 
 #ifdef TEST_PROGRAM
+#include <time.h>
 
 static int test_append(struct libmnt_test *ts, int argc, char *argv[])
 {
@@ -1232,6 +1233,31 @@ static int test_split(struct libmnt_test *ts, int argc, char *argv[])
 	return rc;
 }
 
+/* compares the parsed options with the string functions */
+static int check_optlist(const char *optstr)
+{
+	struct libmnt_optlist *ol = mnt_new_optlist(optstr);
+	int i, rc = 0;
+
+	if (!ol)
+		return 0;
+
+	for (i = 0; i < 2; i++) {
+		const struct libmnt_optmap *map = mnt_get_builtin_optmap(
+				i == 0 ? MNT_LINUX_MAP : MNT_USERSPACE_MAP);
+		unsigned long fl = 0xf0f0, lfl = 0xf0f0;
+
+		mnt_optstr_get_flags(optstr, &fl, map);
+		mnt_optlist_get_flags(ol, &lfl, map);
+		if (fl != lfl) {
+			warnx("optlist flags mismatch: 0x%08lx != 0x%08lx", lfl, fl);
+			rc = -1;
+		}
+	}
+	mnt_free_optlist(ol);
+	return rc;
+}
+
 static int test_flags(struct libmnt_test *ts, int argc, char *argv[])
 {
 	char *optstr;
@@ -1254,6 +1280,7 @@ static int test_flags(struct libmnt_test *ts, int argc, char *argv[])
 		return rc;
 	printf("userspace-mountflags: 0x%08lx\n", fl);
 
+	rc = check_optlist(optstr);
 	free(optstr);
 	return rc;
 }
@@ -1323,6 +1350,16 @@ static int test_get(struct libmnt_test *ts, int argc, char *argv[])
 	name = argv[2];
 
 	rc = mnt_optstr_get_option(optstr, name, &val, &sz);
+	if (rc >= 0) {
+		struct libmnt_optlist *ol = mnt_new_optlist(optstr);
+		char *lval = NULL;
+		size_t lsz = 0;
+
+		if (ol && (mnt_optlist_get_option(ol, name, &lval, &lsz) != rc
+			   || lsz != sz || (!lval) != (!val)))
+			warnx("optlist lookup mismatch");
+		mnt_free_optlist(ol);
+	}
 	if (rc == 0) {
 		printf("found; name: %s", name);
 		if (sz) {
@@ -1409,6 +1446,84 @@ static int test_fix(struct libmnt_test *ts, int argc, char *argv[])
 
 }
 
+static double bench_msecs(struct timespec *start)
+{
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) * 1e3 +
+	       (end.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/*
+ * The context asks for flags and options many times for the same fs; compare
+ * the string functions with the cached parsed options.
+ */
+static int test_bench(struct libmnt_test *ts, int argc, char *argv[])
+{
+	const struct libmnt_optmap *lmap = mnt_get_builtin_optmap(MNT_LINUX_MAP),
+				   *umap = mnt_get_builtin_optmap(MNT_USERSPACE_MAP);
+	struct libmnt_fs *fs;
+	char *optstr, *name, *str, **names = NULL;
+	size_t namesz, nnames = 0, i;
+	int loops = 100000, mode, n;
+
+	if (argc < 2)
+		return -EINVAL;
+	if (argc == 3)
+		loops = strtos32_or_err(argv[2], "failed to parse loops");
+
+	optstr = argv[1];
+	fs = mnt_new_fs();
+	if (!fs || mnt_fs_set_options(fs, optstr) != 0)
+		return -ENOMEM;
+
+	/* option names to search for */
+	str = optstr;
+	while (!mnt_optstr_next_option(&str, &name, &namesz, NULL, NULL)) {
+		char **x = realloc(names, (nnames + 1) * sizeof(char *));
+
+		if (!x || !(x[nnames] = strndup(name, namesz)))
+			err(EXIT_FAILURE, "cannot allocate names");
+		names = x;
+		nnames++;
+	}
+
+	for (mode = 0; mode < 2; mode++) {
+		struct timespec start;
+		unsigned long fl = 0;
+		size_t found = 0;
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (n = 0; n < loops; n++) {
+			if (mode == 0) {
+				mnt_optstr_get_flags(fs->optstr, &fl, lmap);
+				mnt_optstr_get_flags(fs->user_optstr ? : "", &fl, umap);
+				for (i = 0; i < nnames; i++)
+					found += !mnt_optstr_get_option(fs->optstr,
+							names[i], NULL, NULL);
+				found += mnt_match_options(fs->optstr, "noauto,nouser");
+			} else {
+				mnt_fs_get_optflags(fs, MNT_OPTLIST_ALL, &fl, lmap);
+				mnt_fs_get_optflags(fs, MNT_OPTLIST_USER, &fl, umap);
+				for (i = 0; i < nnames; i++)
+					found += !mnt_fs_get_option(fs, names[i], NULL, NULL);
+				found += mnt_fs_match_options(fs, "noauto,nouser");
+			}
+		}
+		printf("%-10s options: %zu, flags: 0x%08lx, found: %zu, "
+		       "time: %.3f us/loop\n",
+			mode ? "optlist" : "optstr", nnames, fl,
+			found / loops, bench_msecs(&start) * 1e3 / loops);
+	}
+
+	for (i = 0; i < nnames; i++)
+		free(names[i]);
+	free(names);
+	mnt_unref_fs(fs);
+	return 0;
+}
+
 int main(int argc, char *argv[])
 {
 	struct libmnt_test tss[] = {
@@ -1422,6 +1537,7 @@ int main(int argc, char *argv[])
 		{ "--flags",  test_flags,  "<optstr>                   convert options to MS_* flags" },
 		{ "--apply",  test_apply,  "--{linux,user} <optstr> <mask>    apply mask to optstr" },
 		{ "--fix",    test_fix,    "<optstr>                   fix uid=, gid=, user, and context=" },
+		{ "--bench",  test_bench,  "<optstr> [<loops>]         benchmark options lookups and flags" },
 
 		{ NULL }
 	};
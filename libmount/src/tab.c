@@ -115,6 +115,7 @@ int mnt_reset_table(struct libmnt_table *tb)
 		mnt_table_remove_fs(tb, fs);
 	}
 
+	mnt_table_reset_index(tb);
 	tb->nents = 0;
 	return 0;
 }
@@ -259,6 +260,25 @@ void mnt_table_enable_comments(struct libmnt_table *tb, int enable)
 		tb->comms = enable;
 }
 
+/**
+ * mnt_table_enable_zerocopy:
+ * @tb: pointer to tab
+ * @enable: TRUE or FALSE
+ *
+ * Enables or disables zero-copy parsing of mountinfo files. The whole file is
+ * read into one buffer and the strings of the parsed filesystems point into the
+ * buffer rather than to private copies. The string is copied when modified by
+ * mnt_fs_set_* functions. The buffer is deallocated together with the last
+ * filesystem parsed from the file. This mode is enabled by default.
+ *
+ * Since: 2.37
+ */
+void mnt_table_enable_zerocopy(struct libmnt_table *tb, int enable)
+{
+	if (tb)
+		tb->nozerocopy = enable ? 0 : 1;
+}
+
 /**
  * mnt_table_with_comments:
  * @tb: pointer to table
@@ -452,6 +472,7 @@ int mnt_table_add_fs(struct libmnt_table *tb, struct libmnt_fs *fs)
 	list_add_tail(&fs->ents, &tb->ents);
 	fs->tab = tb;
 	tb->nents++;
+	mnt_table_index_add_fs(tb, fs);
 
 	DBG(TAB, ul_debugobj(tb, "add entry: %s %s",
 			mnt_fs_get_source(fs), mnt_fs_get_target(fs)));
@@ -472,6 +493,11 @@ static int __table_insert_fs(
 	fs->tab = tb;
 	tb->nents++;
 
+	if (!pos && !before)
+		mnt_table_index_add_fs(tb, fs);	/* appended */
+	else
+		mnt_table_reset_index(tb);
+
 	DBG(TAB, ul_debugobj(tb, "insert entry: %s %s",
 			mnt_fs_get_source(fs), mnt_fs_get_target(fs)));
 	return 0;
@@ -540,6 +566,7 @@ int mnt_table_move_fs(struct libmnt_table *src, struct libmnt_table *dst,
 		return -ENOENT;
 
 	/* remove from source */
+	mnt_table_index_remove_fs(src, fs);
 	list_del_init(&fs->ents);
 	src->nents--;
 
@@ -564,6 +591,7 @@ int mnt_table_remove_fs(struct libmnt_table *tb, struct libmnt_fs *fs)
 	if (!tb || !fs || fs->tab != tb)
 		return -EINVAL;
 
+	mnt_table_index_remove_fs(tb, fs);
 	fs->tab = NULL;
 	list_del_init(&fs->ents);
 
@@ -572,21 +600,39 @@ int mnt_table_remove_fs(struct libmnt_table *tb, struct libmnt_fs *fs)
 	return 0;
 }
 
-static inline struct libmnt_fs *get_parent_fs(struct libmnt_table *tb, struct libmnt_fs *fs)
+/*
+ * Returns the first entry with mount @id (mountinfo only).
+ */
+struct libmnt_fs *__mnt_table_find_id(struct libmnt_table *tb, int id)
 {
 	struct libmnt_iter itr;
-	struct libmnt_fs *x;
-	int parent_id = mnt_fs_get_parent_id(fs);
+	struct libmnt_fs *x = NULL;
+
+	if (mnt_table_use_index(tb)) {
+		unsigned int hash = mnt_tabidx_hash_num(id);
+
+		while ((x = mnt_table_index_next(tb, MNT_TABIDX_ID, hash,
+						x, MNT_ITER_FORWARD))) {
+			if (mnt_fs_get_id(x) == id)
+				return x;
+		}
+		return NULL;
+	}
 
 	mnt_reset_iter(&itr, MNT_ITER_FORWARD);
 	while (mnt_table_next_fs(tb, &itr, &x) == 0) {
-		if (mnt_fs_get_id(x) == parent_id)
+		if (mnt_fs_get_id(x) == id)
 			return x;
 	}
 
 	return NULL;
 }
 
+static inline struct libmnt_fs *get_parent_fs(struct libmnt_table *tb, struct libmnt_fs *fs)
+{
+	return __mnt_table_find_id(tb, mnt_fs_get_parent_id(fs));
+}
+
 /**
  * mnt_table_get_root_fs:
  * @tb: mountinfo file (/proc/self/mountinfo)
@@ -657,7 +703,7 @@ int mnt_table_get_root_fs(struct libmnt_table *tb, struct libmnt_fs **root)
 int mnt_table_next_child_fs(struct libmnt_table *tb, struct libmnt_iter *itr,
 			struct libmnt_fs *parent, struct libmnt_fs **chld)
 {
-	struct libmnt_fs *fs;
+	struct libmnt_fs *fs, *lastchld = NULL;
 	int parent_id, lastchld_id = 0, chld_id = 0;
 
 	if (!tb || !itr || !parent || !is_mountinfo(tb))
@@ -672,10 +718,29 @@ int mnt_table_next_child_fs(struct libmnt_table *tb, struct libmnt_iter *itr,
 	if (itr->head && itr->p != itr->head) {
 		MNT_ITER_ITERATE(itr, fs, struct libmnt_fs, ents);
 		lastchld_id = mnt_fs_get_id(fs);
+		lastchld = fs;
 	}
 
 	*chld = NULL;
 
+	if (mnt_table_use_tree(tb)) {
+		/* children are sorted by ID in the tree */
+		if (lastchld && mnt_fs_get_parent_id(lastchld) == parent_id)
+			fs = mnt_table_tree_next_child(tb, lastchld);
+		else
+			fs = mnt_table_tree_first_child(tb, parent_id);
+
+		for (; fs; fs = mnt_table_tree_next_child(tb, fs)) {
+			int id = mnt_fs_get_id(fs);
+
+			if (id != parent_id && (!lastchld_id || id > lastchld_id)) {
+				*chld = fs;
+				break;
+			}
+		}
+		goto done;
+	}
+
 	mnt_reset_iter(itr, MNT_ITER_FORWARD);
 	while(mnt_table_next_fs(tb, itr, &fs) == 0) {
 		int id;
@@ -696,7 +761,7 @@ int mnt_table_next_child_fs(struct libmnt_table *tb, struct libmnt_iter *itr,
 			chld_id = id;
 		}
 	}
-
+done:
 	if (!*chld)
 		return 1;	/* end of iterator */
 
@@ -827,6 +892,7 @@ static int mnt_table_move_parent(struct libmnt_table *tb, int oldid, int newid)
 		return 0;
 
 	DBG(TAB, ul_debugobj(tb, "moving parent ID from %d -> %d", oldid, newid));
+	mnt_table_reset_index(tb);
 	mnt_reset_iter(&itr, MNT_ITER_FORWARD);
 
 	while (mnt_table_next_fs(tb, &itr, &fs) == 0) {
@@ -978,6 +1044,47 @@ struct libmnt_fs *mnt_table_find_mountpoint(struct libmnt_table *tb,
 	return mnt_table_find_target(tb, "/", direction);
 }
 
+static inline int fs_streq_path(struct libmnt_fs *fs, int type, const char *path)
+{
+	return type == MNT_TABIDX_TARGET ?
+			mnt_fs_streq_target(fs, path) :
+			mnt_fs_streq_srcpath(fs, path);
+}
+
+/*
+ * Returns the next entry after @fs (or the first entry if @fs is NULL) with
+ * target or source path (according to @type) equal to @path. The index is
+ * used if available.
+ */
+static struct libmnt_fs *next_fs_by_path(struct libmnt_table *tb, int type,
+					 const char *path, struct libmnt_fs *fs,
+					 int direction)
+{
+	struct libmnt_iter itr;
+
+	if (mnt_table_use_index(tb)) {
+		unsigned int hash = mnt_tabidx_hash_path(path);
+
+		while ((fs = mnt_table_index_next(tb, type, hash, fs, direction))) {
+			if (fs_streq_path(fs, type, path))
+				return fs;
+		}
+		return NULL;
+	}
+
+	mnt_reset_iter(&itr, direction);
+	if (fs) {
+		/* skip the previous entry */
+		mnt_table_set_iter(tb, &itr, fs);
+		mnt_table_next_fs(tb, &itr, &fs);
+	}
+	while (mnt_table_next_fs(tb, &itr, &fs) == 0) {
+		if (fs_streq_path(fs, type, path))
+			return fs;
+	}
+	return NULL;
+}
+
 /**
  * mnt_table_find_target:
  * @tb: tab pointer
@@ -1007,23 +1114,17 @@ struct libmnt_fs *mnt_table_find_target(struct libmnt_table *tb, const char *pat
 	DBG(TAB, ul_debugobj(tb, "lookup TARGET: '%s'", path));
 
 	/* native @target */
-	mnt_reset_iter(&itr, direction);
-	while(mnt_table_next_fs(tb, &itr, &fs) == 0) {
-		if (mnt_fs_streq_target(fs, path))
-			return fs;
-	}
+	fs = next_fs_by_path(tb, MNT_TABIDX_TARGET, path, NULL, direction);
+	if (fs)
+		return fs;
 
 	/* try absolute path */
 	if (is_relative_path(path) && (cn = absolute_path(path))) {
 		DBG(TAB, ul_debugobj(tb, "lookup absolute TARGET: '%s'", cn));
-		mnt_reset_iter(&itr, direction);
-		while (mnt_table_next_fs(tb, &itr, &fs) == 0) {
-			if (mnt_fs_streq_target(fs, cn)) {
-				free(cn);
-				return fs;
-			}
-		}
+		fs = next_fs_by_path(tb, MNT_TABIDX_TARGET, cn, NULL, direction);
 		free(cn);
+		if (fs)
+			return fs;
 	}
 
 	if (!tb->cache || !(cn = mnt_resolve_path(path, tb->cache)))
@@ -1032,11 +1133,9 @@ struct libmnt_fs *mnt_table_find_target(struct libmnt_table *tb, const char *pat
 	DBG(TAB, ul_debugobj(tb, "lookup canonical TARGET: '%s'", cn));
 
 	/* canonicalized paths in struct libmnt_table */
-	mnt_reset_iter(&itr, direction);
-	while(mnt_table_next_fs(tb, &itr, &fs) == 0) {
-		if (mnt_fs_streq_target(fs, cn))
-			return fs;
-	}
+	fs = next_fs_by_path(tb, MNT_TABIDX_TARGET, cn, NULL, direction);
+	if (fs)
+		return fs;
 
 	/* non-canonical path in struct libmnt_table
 	 * -- note that mountpoint in /proc/self/mountinfo is already
@@ -1096,36 +1195,29 @@ struct libmnt_fs *mnt_table_find_srcpath(struct libmnt_table *tb, const char *pa
 	DBG(TAB, ul_debugobj(tb, "lookup SRCPATH: '%s'", path));
 
 	/* native paths */
-	mnt_reset_iter(&itr, direction);
-
-	while(mnt_table_next_fs(tb, &itr, &fs) == 0) {
-
-		if (mnt_fs_streq_srcpath(fs, path)) {
+	while ((fs = next_fs_by_path(tb, MNT_TABIDX_SRCPATH, path, fs, direction))) {
 #ifdef HAVE_BTRFS_SUPPORT
-			if (fs->fstype && !strcmp(fs->fstype, "btrfs")) {
-				uint64_t default_id = btrfs_get_default_subvol_id(mnt_fs_get_target(fs));
-				char *val;
-				size_t len;
+		if (fs->fstype && !strcmp(fs->fstype, "btrfs")) {
+			uint64_t default_id = btrfs_get_default_subvol_id(mnt_fs_get_target(fs));
+			char *val;
+			size_t len;
 
-				if (default_id == UINT64_MAX)
-					DBG(TAB, ul_debug("not found btrfs volume setting"));
+			if (default_id == UINT64_MAX)
+				DBG(TAB, ul_debug("not found btrfs volume setting"));
 
-				else if (mnt_fs_get_option(fs, "subvolid", &val, &len) == 0) {
-					uint64_t subvol_id;
+			else if (mnt_fs_get_option(fs, "subvolid", &val, &len) == 0) {
+				uint64_t subvol_id;
 
-					if (mnt_parse_offset(val, len, &subvol_id)) {
-						DBG(TAB, ul_debugobj(tb, "failed to parse subvolid="));
-						continue;
-					}
-					if (subvol_id != default_id)
-						continue;
+				if (mnt_parse_offset(val, len, &subvol_id)) {
+					DBG(TAB, ul_debugobj(tb, "failed to parse subvolid="));
+					continue;
 				}
+				if (subvol_id != default_id)
+					continue;
 			}
-#endif /* HAVE_BTRFS_SUPPORT */
-			return fs;
 		}
-		if (mnt_fs_get_tag(fs, NULL, NULL) == 0)
-			ntags++;
+#endif /* HAVE_BTRFS_SUPPORT */
+		return fs;
 	}
 
 	if (!path || !tb->cache || !(cn = mnt_resolve_path(path, tb->cache)))
@@ -1133,15 +1225,24 @@ struct libmnt_fs *mnt_table_find_srcpath(struct libmnt_table *tb, const char *pa
 
 	DBG(TAB, ul_debugobj(tb, "lookup canonical SRCPATH: '%s'", cn));
 
+	ntags = mnt_table_index_get_ntags(tb);
+	if (ntags < 0) {
+		/* no index, count tags by the linear walk */
+		ntags = 0;
+		mnt_reset_iter(&itr, direction);
+		while (mnt_table_next_fs(tb, &itr, &fs) == 0) {
+			if (mnt_fs_get_tag(fs, NULL, NULL) == 0)
+				ntags++;
+		}
+	}
+
 	nents = mnt_table_get_nents(tb);
 
 	/* canonicalized paths in struct libmnt_table */
 	if (ntags < nents) {
-		mnt_reset_iter(&itr, direction);
-		while(mnt_table_next_fs(tb, &itr, &fs) == 0) {
-			if (mnt_fs_streq_srcpath(fs, cn))
-				return fs;
-		}
+		fs = next_fs_by_path(tb, MNT_TABIDX_SRCPATH, cn, NULL, direction);
+		if (fs)
+			return fs;
 	}
 
 	/* evaluated tag */
@@ -1384,6 +1485,17 @@ struct libmnt_fs *mnt_table_find_devno(struct libmnt_table *tb,
 
 	DBG(TAB, ul_debugobj(tb, "lookup DEVNO: %d", (int) devno));
 
+	if (mnt_table_use_index(tb)) {
+		unsigned int hash = mnt_tabidx_hash_num(devno);
+
+		while ((fs = mnt_table_index_next(tb, MNT_TABIDX_DEVNO, hash,
+						fs, direction))) {
+			if (mnt_fs_get_devno(fs) == devno)
+				return fs;
+		}
+		return NULL;
+	}
+
 	mnt_reset_iter(&itr, direction);
 
 	while(mnt_table_next_fs(tb, &itr, &fs) == 0) {
@@ -1845,6 +1957,7 @@ int mnt_table_is_fs_mounted(struct libmnt_table *tb, struct libmnt_fs *fstab_fs)
 
 
 #ifdef TEST_PROGRAM
+#include <time.h>
 #include "pathnames.h"
 
 static int parser_errcb(struct libmnt_table *tb, const char *filename, int line)
@@ -2185,6 +2298,230 @@ done:
 }
 
 
+/* number of allocations used for the table entries */
+static size_t count_allocs(struct libmnt_table *tb)
+{
+	struct libmnt_strbuf *last = NULL;
+	struct libmnt_iter itr;
+	struct libmnt_fs *fs;
+	size_t n = 0;
+
+	mnt_reset_iter(&itr, MNT_ITER_FORWARD);
+	while (mnt_table_next_fs(tb, &itr, &fs) == 0) {
+		const char *strs[] = {
+			fs->source, fs->bindsrc, fs->tagname, fs->tagval,
+			fs->root, fs->swaptype, fs->target, fs->fstype,
+			fs->optstr, fs->vfs_optstr, fs->fs_optstr,
+			fs->user_optstr, fs->attrs, fs->opt_fields, fs->comment
+		};
+		size_t i;
+
+		n++;		/* struct libmnt_fs */
+		for (i = 0; i < ARRAY_SIZE(strs); i++) {
+			if (!strs[i])
+				continue;
+			if (fs->strbuf && strs[i] >= fs->strbuf->data
+			    && strs[i] < fs->strbuf->data + fs->strbuf->size)
+				continue;
+			n++;
+		}
+		if (fs->strbuf && fs->strbuf != last) {
+			n++;	/* shared buffer */
+			last = fs->strbuf;
+		}
+	}
+	return n;
+}
+
+/* generates synthetic mountinfo with @n entries to @tmpname */
+static const char *bench_mountinfo(char *tmpname, const char *nents)
+{
+	int i, n = strtos32_or_err(nents, "failed to parse number of entries");
+	int fd = mkstemp(tmpname);
+	FILE *f = fd >= 0 ? fdopen(fd, "w") : NULL;
+
+	if (!f)
+		err(EXIT_FAILURE, "cannot create temporary file");
+	fprintf(f, "1 0 8:1 / / rw,relatime shared:1 - ext4 /dev/sda1 rw\n");
+	for (i = 2; i <= n; i++)
+		fprintf(f, "%d %d 0:%d / /run/containers/%d/rootfs\\040dir "
+			   "rw,nosuid,nodev,relatime shared:%d master:1 - "
+			   "overlay overlay rw,lowerdir=/var/lib/l/%d,"
+			   "upperdir=/var/lib/u/%d,workdir=/var/lib/w/%d\n",
+			   i, i > 100 ? i % 100 + 1 : 1, 100 + i, i, i, i, i, i);
+	if (fclose(f) != 0)
+		err(EXIT_FAILURE, "write failed");
+	return tmpname;
+}
+
+static double bench_msecs(struct timespec *start)
+{
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) * 1e3 +
+	       (end.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+static int test_bench_parse(struct libmnt_test *ts, int argc, char *argv[])
+{
+	char tmpname[] = "/tmp/libmount-mountinfoXXXXXX";
+	const char *filename = argv[1];
+	int loops = 10, mode, rc = -1;
+
+	if (argc < 2) {
+		fprintf(stderr, "try --help\n");
+		return -EINVAL;
+	}
+	if (argc == 3)
+		loops = strtos32_or_err(argv[2], "failed to parse loops");
+
+	if (isdigit_string(filename))
+		filename = bench_mountinfo(tmpname, filename);
+
+	for (mode = 0; mode < 2; mode++) {
+		struct timespec start;
+		size_t nallocs = 0;
+		int nents = 0, i;
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (i = 0; i < loops; i++) {
+			struct libmnt_table *tb = mnt_new_table();
+
+			if (!tb)
+				goto done;
+			tb->fmt = MNT_FMT_MOUNTINFO;
+			mnt_table_enable_zerocopy(tb, mode);
+			if (mnt_table_parse_file(tb, filename) != 0) {
+				warnx("%s: parsing failed", filename);
+				mnt_unref_table(tb);
+				goto done;
+			}
+			if (i == 0) {
+				nents = mnt_table_get_nents(tb);
+				nallocs = count_allocs(tb);
+			}
+			mnt_unref_table(tb);
+		}
+
+		printf("%-10s entries: %d, allocations: %zu, time: %.3f ms\n",
+			mode ? "zero-copy" : "strdup",
+			nents, nallocs, bench_msecs(&start) / loops);
+	}
+	rc = 0;
+done:
+	if (filename == tmpname)
+		unlink(tmpname);
+	return rc;
+}
+
+static size_t bench_walk_children(struct libmnt_table *tb, struct libmnt_fs *parent)
+{
+	struct libmnt_iter itr;
+	struct libmnt_fs *chld;
+	size_t n = 0;
+
+	mnt_reset_iter(&itr, MNT_ITER_FORWARD);
+	while (mnt_table_next_child_fs(tb, &itr, parent, &chld) == 0) {
+		n++;
+		/* the generated table is only two levels deep */
+		if (mnt_fs_get_id(parent) == 1)
+			n += bench_walk_children(tb, chld);
+	}
+	return n;
+}
+
+static int test_bench_find(struct libmnt_test *ts, int argc, char *argv[])
+{
+	char tmpname[] = "/tmp/libmount-mountinfoXXXXXX";
+	const char *filename = argv[1];
+	struct libmnt_table *tb = NULL;
+	struct libmnt_fs **ents = NULL, *fs;
+	struct libmnt_iter itr;
+	int nlookups = 1000, nents, i, mode, rc = -1;
+
+	if (argc < 2) {
+		fprintf(stderr, "try --help\n");
+		return -EINVAL;
+	}
+	if (argc == 3)
+		nlookups = strtos32_or_err(argv[2], "failed to parse lookups");
+
+	if (isdigit_string(filename))
+		filename = bench_mountinfo(tmpname, filename);
+
+	tb = mnt_new_table_from_file(filename);
+	if (!tb) {
+		warnx("%s: parsing failed", filename);
+		goto done;
+	}
+	nents = mnt_table_get_nents(tb);
+	if (!nents)
+		goto done;
+
+	ents = calloc(nents, sizeof(struct libmnt_fs *));
+	if (!ents)
+		goto done;
+	mnt_reset_iter(&itr, MNT_ITER_FORWARD);
+	for (i = 0; mnt_table_next_fs(tb, &itr, &fs) == 0; i++)
+		ents[i] = fs;
+
+	for (mode = 0; mode < 2; mode++) {
+		struct timespec start;
+		struct libmnt_fs *root;
+		double tgt, dev, tree;
+		size_t nchld;
+
+		tb->noindex = mode == 0;
+		mnt_table_reset_index(tb);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (i = 0; i < nlookups; i++) {
+			struct libmnt_fs *x = ents[(size_t) i * 7919 % nents];
+
+			if (mnt_table_find_target(tb, mnt_fs_get_target(x),
+						MNT_ITER_BACKWARD) != x) {
+				warnx("%s: target lookup failed", mnt_fs_get_target(x));
+				goto done;
+			}
+		}
+		tgt = bench_msecs(&start);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (i = 0; i < nlookups; i++) {
+			struct libmnt_fs *x = ents[(size_t) i * 7919 % nents];
+
+			if (mnt_table_find_devno(tb, mnt_fs_get_devno(x),
+						MNT_ITER_FORWARD) != x) {
+				warnx("%s: devno lookup failed", mnt_fs_get_target(x));
+				goto done;
+			}
+		}
+		dev = bench_msecs(&start);
+
+		printf("%-8s entries: %d, lookups: %d, target: %.3f ms, devno: %.3f ms",
+			mode ? "indexed" : "linear", nents, nlookups, tgt, dev);
+
+		/* the linear tree walk is quadratic */
+		if (mode || nents <= 10000) {
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			nchld = 0;
+			if (mnt_table_get_root_fs(tb, &root) == 0)
+				nchld = bench_walk_children(tb, root);
+			tree = bench_msecs(&start);
+			printf(", tree (%zu): %.3f ms", nchld, tree);
+		}
+		putchar('\n');
+	}
+	rc = 0;
+done:
+	free(ents);
+	mnt_unref_table(tb);
+	if (filename == tmpname)
+		unlink(tmpname);
+	return rc;
+}
+
 int main(int argc, char *argv[])
 {
 	struct libmnt_test tss[] = {
@@ -2192,6 +2529,8 @@ int main(int argc, char *argv[])
 	{ "--find-forward",  test_find_fw, "<file> <source|target> <string>" },
 	{ "--find-backward", test_find_bw, "<file> <source|target> <string>" },
 	{ "--uniq-target",   test_uniq,    "<file>" },
+	{ "--bench-parse",   test_bench_parse, "<file>|<nentries> [<loops>]  compare parsing modes" },
+	{ "--bench-find",    test_bench_find, "<file>|<nentries> [<lookups>]  compare linear and indexed lookups" },
 	{ "--find-pair",     test_find_pair, "<file> <source> <target>" },
 	{ "--find-fs",       test_find_idx, "<file> <target>" },
 	{ "--find-mountpoint", test_find_mountpoint, "<path>" },
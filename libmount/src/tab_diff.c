@@ -124,7 +124,7 @@ int mnt_tabdiff_next_change(struct libmnt_tabdiff *df, struct libmnt_iter *itr,
 	return rc;
 }
 
-static int tabdiff_reset(struct libmnt_tabdiff *df)
+int mnt_tabdiff_reset(struct libmnt_tabdiff *df)
 {
 	assert(df);
 
@@ -213,19 +213,59 @@ static struct tabdiff_entry *tabdiff_get_mount(struct libmnt_tabdiff *df,
 	return NULL;
 }
 
-/**
- * mnt_diff_tables:
- * @df: diff handler
- * @old_tab: old table
- * @new_tab: new table
- *
- * Compares @old_tab and @new_tab, the result is stored in @df and accessible by
- * mnt_tabdiff_next_change().
- *
- * Returns: number of changes, negative number in case of error.
+static int is_remounted(struct libmnt_fs *o_fs, struct libmnt_fs *fs)
+{
+	const char *v1 = mnt_fs_get_vfs_options(o_fs),
+		   *v2 = mnt_fs_get_vfs_options(fs),
+		   *f1 = mnt_fs_get_fs_options(o_fs),
+		   *f2 = mnt_fs_get_fs_options(fs);
+
+	return (v1 && v2 && strcmp(v1, v2) != 0) || (f1 && f2 && strcmp(f1, f2) != 0);
+}
+
+/* returns entry from @tb with the same mount ID and source as @fs */
+static struct libmnt_fs *find_same_mount(struct libmnt_table *tb, struct libmnt_fs *fs)
+{
+	struct libmnt_fs *x = __mnt_table_find_id(tb, mnt_fs_get_id(fs));
+
+	if (x && strcmp(mnt_fs_get_source(x) ? : "", mnt_fs_get_source(fs) ? : "") == 0)
+		return x;
+	return NULL;
+}
+
+/*
+ * Compares mountinfo tables by mount IDs, the IDs are hashed in the tables, so
+ * the diff is linear. The moved filesystem keeps the ID, the same ID with
+ * another source is a new mount.
  */
-int mnt_diff_tables(struct libmnt_tabdiff *df, struct libmnt_table *old_tab,
-		    struct libmnt_table *new_tab)
+static void diff_mountinfo(struct libmnt_tabdiff *df, struct libmnt_table *old_tab,
+			   struct libmnt_table *new_tab)
+{
+	struct libmnt_fs *fs, *x;
+	struct libmnt_iter itr;
+
+	/* search newly mounted, moved or modified */
+	mnt_reset_iter(&itr, MNT_ITER_FORWARD);
+	while (mnt_table_next_fs(new_tab, &itr, &fs) == 0) {
+		x = find_same_mount(old_tab, fs);
+		if (!x)
+			tabdiff_add_entry(df, NULL, fs, MNT_TABDIFF_MOUNT);
+		else if (!mnt_fs_streq_target(x, mnt_fs_get_target(fs)))
+			tabdiff_add_entry(df, x, fs, MNT_TABDIFF_MOVE);
+		else if (is_remounted(x, fs))
+			tabdiff_add_entry(df, x, fs, MNT_TABDIFF_REMOUNT);
+	}
+
+	/* search umounted */
+	mnt_reset_iter(&itr, MNT_ITER_FORWARD);
+	while (mnt_table_next_fs(old_tab, &itr, &fs) == 0) {
+		if (!find_same_mount(new_tab, fs))
+			tabdiff_add_entry(df, fs, NULL, MNT_TABDIFF_UMOUNT);
+	}
+}
+
+static int diff_tables(struct libmnt_tabdiff *df, struct libmnt_table *old_tab,
+		       struct libmnt_table *new_tab, int by_id)
 {
 	struct libmnt_fs *fs;
 	struct libmnt_iter itr;
@@ -234,7 +274,7 @@ int mnt_diff_tables(struct libmnt_tabdiff *df, struct libmnt_table *old_tab,
 	if (!df || !old_tab || !new_tab)
 		return -EINVAL;
 
-	tabdiff_reset(df);
+	mnt_tabdiff_reset(df);
 
 	no = mnt_table_get_nents(old_tab);
 	nn = mnt_table_get_nents(new_tab);
@@ -260,6 +300,11 @@ int mnt_diff_tables(struct libmnt_tabdiff *df, struct libmnt_table *old_tab,
 		goto done;
 	}
 
+	if (by_id && is_mountinfo(old_tab) && is_mountinfo(new_tab)) {
+		diff_mountinfo(df, old_tab, new_tab);
+		goto done;
+	}
+
 	/* search newly mounted or modified */
 	while(mnt_table_next_fs(new_tab, &itr, &fs) == 0) {
 		struct libmnt_fs *o_fs;
@@ -270,16 +315,8 @@ int mnt_diff_tables(struct libmnt_tabdiff *df, struct libmnt_table *old_tab,
 		if (!o_fs)
 			/* 'fs' is not in the old table -- so newly mounted */
 			tabdiff_add_entry(df, NULL, fs, MNT_TABDIFF_MOUNT);
-		else {
-			/* is modified? */
-			const char *v1 = mnt_fs_get_vfs_options(o_fs),
-				   *v2 = mnt_fs_get_vfs_options(fs),
-				   *f1 = mnt_fs_get_fs_options(o_fs),
-				   *f2 = mnt_fs_get_fs_options(fs);
-
-			if ((v1 && v2 && strcmp(v1, v2) != 0) || (f1 && f2 && strcmp(f1, f2) != 0))
-				tabdiff_add_entry(df, o_fs, fs, MNT_TABDIFF_REMOUNT);
-		}
+		else if (is_remounted(o_fs, fs))
+			tabdiff_add_entry(df, o_fs, fs, MNT_TABDIFF_REMOUNT);
 	}
 
 	/* search umounted or moved */
@@ -306,6 +343,47 @@ done:
 	return df->nchanges;
 }
 
+/**
+ * mnt_diff_tables:
+ * @df: diff handler
+ * @old_tab: old table
+ * @new_tab: new table
+ *
+ * Compares @old_tab and @new_tab, the result is stored in @df and accessible by
+ * mnt_tabdiff_next_change(). The entries are compared by source and target.
+ *
+ * Returns: number of changes, negative number in case of error.
+ */
+int mnt_diff_tables(struct libmnt_tabdiff *df, struct libmnt_table *old_tab,
+		    struct libmnt_table *new_tab)
+{
+	return diff_tables(df, old_tab, new_tab, 0);
+}
+
+/**
+ * mnt_diff_tables_by_id:
+ * @df: diff handler
+ * @old_tab: old table
+ * @new_tab: new table
+ *
+ * The same as mnt_diff_tables(), but if both tables are mountinfo then the
+ * entries are compared by mount ID and source. The mount IDs are indexed, so
+ * the diff is linear rather than quadratic to the number of entries.
+ *
+ * The results are different from mnt_diff_tables() for filesystems mounted
+ * again on the same place: the same source and target with a new mount ID
+ * is reported as umount and mount rather than no change.
+ *
+ * Returns: number of changes, negative number in case of error.
+ *
+ * Since: 2.37
+ */
+int mnt_diff_tables_by_id(struct libmnt_tabdiff *df, struct libmnt_table *old_tab,
+			  struct libmnt_table *new_tab)
+{
+	return diff_tables(df, old_tab, new_tab, 1);
+}
+
 #ifdef TEST_PROGRAM
 
 static int test_diff(struct libmnt_test *ts, int argc, char *argv[])
@@ -326,7 +404,10 @@ static int test_diff(struct libmnt_test *ts, int argc, char *argv[])
 		goto done;
 	}
 
-	rc = mnt_diff_tables(diff, tb_old, tb_new);
+	if (strcmp(ts->name, "--diff-id") == 0)
+		rc = mnt_diff_tables_by_id(diff, tb_old, tb_new);
+	else
+		rc = mnt_diff_tables(diff, tb_old, tb_new);
 	if (rc < 0)
 		goto done;
 
@@ -368,6 +449,7 @@ int main(int argc, char *argv[])
 {
 	struct libmnt_test tss[] = {
 		{ "--diff", test_diff, "<old> <new> prints change" },
+		{ "--diff-id", test_diff, "<old> <new> prints change, compare by mount IDs" },
 		{ NULL }
 	};
 
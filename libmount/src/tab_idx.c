@@ -0,0 +1,328 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * This file is part of libmount from util-linux project.
+ *
+ * libmount is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Hash indexes for mnt_table_find_*() lookups and mount tree.
+ *
+ * The index is built on the first lookup in a table with more than
+ * MNT_TABIDX_MINENTS entries. Every index type (target, source path, devno
+ * and mount ID) is a hash table of doubly linked chains. The chains
+ * are kept in the table order, so the lookups are able to follow the
+ * MNT_ITER_{FORWARD,BACKWARD} semantic of the linear table walk.
+ *
+ * mnt_table_add_fs() appends the new entry to the index, mnt_table_remove_fs()
+ * removes the entry from the chains. All the other changes (insert to an
+ * arbitrary position, move between tables, modified source or target, ...)
+ * drop the index and it's built again on the next lookup.
+ *
+ * The path hashes are calculated from the path with collapsed '/' and without
+ * the trailing '/', so all paths equal for streq_paths() are in the same
+ * chain.
+ *
+ * The mount tree is an array of all entries sorted by parent ID and ID, so
+ * children of the same parent are in a continuous block ordered by mount
+ * IDs. It's built on the first mnt_table_next_child_fs() call and dropped by
+ * any table change.
+ */
+#include "mountP.h"
+
+#define MNT_TABIDX_MINENTS	32
+#define MNT_TABIDX_MINBUCKETS	64
+
+struct libmnt_tabidx {
+	size_t		nbuckets;	/* number of buckets per index type (power of 2) */
+	int		ntags;		/* number of entries with source TAG */
+
+	struct list_head buckets[];	/* __MNT_TABIDX_NR * nbuckets */
+};
+
+/* FNV-1a */
+static inline unsigned int hash_step(unsigned int h, unsigned char c)
+{
+	return (h ^ c) * 16777619U;
+}
+
+unsigned int mnt_tabidx_hash_path(const char *path)
+{
+	unsigned int h = 2166136261U;
+	const char *p;
+
+	if (!path)
+		return h;
+
+	for (p = path; *p; p++) {
+		if (*p == '/') {
+			/* ignore repeated slashes and the trailing slash */
+			while (*(p + 1) == '/')
+				p++;
+			if (!*(p + 1))
+				break;
+		}
+		h = hash_step(h, *p);
+	}
+	return h;
+}
+
+unsigned int mnt_tabidx_hash_num(uint64_t num)
+{
+	num ^= num >> 33;
+	num *= 0xff51afd7ed558ccdULL;
+	num ^= num >> 33;
+	return (unsigned int) num;
+}
+
+static unsigned int fs_hash(struct libmnt_fs *fs, int type)
+{
+	switch (type) {
+	case MNT_TABIDX_TARGET:
+		return mnt_tabidx_hash_path(fs->target);
+	case MNT_TABIDX_SRCPATH:
+		return mnt_tabidx_hash_path(mnt_fs_get_srcpath(fs));
+	case MNT_TABIDX_DEVNO:
+		return mnt_tabidx_hash_num(fs->devno);
+	case MNT_TABIDX_ID:
+		return mnt_tabidx_hash_num(fs->id);
+	}
+	return 0;
+}
+
+static inline struct list_head *idx_bucket(struct libmnt_tabidx *idx,
+					   int type, unsigned int hash)
+{
+	return &idx->buckets[type * idx->nbuckets + (hash & (idx->nbuckets - 1))];
+}
+
+static void idx_add_fs(struct libmnt_tabidx *idx, struct libmnt_fs *fs)
+{
+	int i;
+
+	for (i = 0; i < __MNT_TABIDX_NR; i++)
+		list_add_tail(&fs->idxents[i], idx_bucket(idx, i, fs_hash(fs, i)));
+
+	if (fs->tagname)
+		idx->ntags++;
+}
+
+static void reset_tree(struct libmnt_table *tb)
+{
+	if (!tb->tree)
+		return;
+
+	DBG(TAB, ul_debugobj(tb, "drop tree"));
+	free(tb->tree);
+	tb->tree = NULL;
+	tb->ntree = 0;
+}
+
+/*
+ * Drops the index and the tree; it's built again on the next lookup.
+ */
+void mnt_table_reset_index(struct libmnt_table *tb)
+{
+	if (!tb)
+		return;
+
+	reset_tree(tb);
+	if (!tb->idx)
+		return;
+
+	DBG(TAB, ul_debugobj(tb, "drop index"));
+	free(tb->idx);
+	tb->idx = NULL;
+}
+
+/*
+ * Builds the index if necessary.
+ *
+ * Returns: 1 if the index is usable, 0 if the table has to be searched
+ * linearly (small table, disabled index or no memory).
+ */
+int mnt_table_use_index(struct libmnt_table *tb)
+{
+	struct libmnt_tabidx *idx;
+	struct list_head *p;
+	size_t i, nbuckets = MNT_TABIDX_MINBUCKETS;
+
+	if (tb->idx)
+		return 1;
+	if (tb->noindex || tb->nents < MNT_TABIDX_MINENTS)
+		return 0;
+
+	while (nbuckets < (size_t) tb->nents)
+		nbuckets <<= 1;
+
+	idx = malloc(sizeof(*idx) + __MNT_TABIDX_NR * nbuckets * sizeof(struct list_head));
+	if (!idx)
+		return 0;
+
+	idx->nbuckets = nbuckets;
+	idx->ntags = 0;
+	for (i = 0; i < __MNT_TABIDX_NR * nbuckets; i++)
+		INIT_LIST_HEAD(&idx->buckets[i]);
+
+	list_for_each(p, &tb->ents)
+		idx_add_fs(idx, list_entry(p, struct libmnt_fs, ents));
+
+	DBG(TAB, ul_debugobj(tb, "new index [entries=%d, buckets=%zu]",
+				tb->nents, nbuckets));
+	tb->idx = idx;
+	return 1;
+}
+
+/*
+ * Called after @fs has been appended to the end of @tb.
+ */
+void mnt_table_index_add_fs(struct libmnt_table *tb, struct libmnt_fs *fs)
+{
+	reset_tree(tb);
+	if (!tb->idx)
+		return;
+	if ((size_t) tb->nents > 2 * tb->idx->nbuckets)
+		mnt_table_reset_index(tb);	/* too small, rebuild later */
+	else
+		idx_add_fs(tb->idx, fs);
+}
+
+/*
+ * Called before @fs is removed from @tb.
+ */
+void mnt_table_index_remove_fs(struct libmnt_table *tb, struct libmnt_fs *fs)
+{
+	int i;
+
+	reset_tree(tb);
+	if (!tb->idx)
+		return;
+
+	for (i = 0; i < __MNT_TABIDX_NR; i++)
+		list_del(&fs->idxents[i]);
+	if (fs->tagname)
+		tb->idx->ntags--;
+}
+
+/*
+ * Returns the number of entries with a source TAG or -1 if the index is not
+ * available.
+ */
+int mnt_table_index_get_ntags(struct libmnt_table *tb)
+{
+	return mnt_table_use_index(tb) ? tb->idx->ntags : -1;
+}
+
+/*
+ * Returns the next entry (in the table order according to @direction) after
+ * @prev from the index chain for @hash. Note that the chains are shared by
+ * all keys with the same bucket, so the caller has to compare the key.
+ *
+ * The index has to be already built by mnt_table_use_index().
+ */
+struct libmnt_fs *mnt_table_index_next(struct libmnt_table *tb, int type,
+				unsigned int hash, struct libmnt_fs *prev,
+				int direction)
+{
+	struct list_head *head = idx_bucket(tb->idx, type, hash);
+	struct list_head *p;
+
+	if (prev)
+		p = direction == MNT_ITER_FORWARD ?
+			prev->idxents[type].next : prev->idxents[type].prev;
+	else
+		p = direction == MNT_ITER_FORWARD ? head->next : head->prev;
+
+	if (p == head)
+		return NULL;
+
+	return list_entry(p - type, struct libmnt_fs, idxents[0]);
+}
+
+static int cmp_tree_fs(const void *a, const void *b)
+{
+	const struct libmnt_fs *x = *(const struct libmnt_fs * const *) a;
+	const struct libmnt_fs *y = *(const struct libmnt_fs * const *) b;
+
+	if (x->parent != y->parent)
+		return x->parent < y->parent ? -1 : 1;
+	if (x->id != y->id)
+		return x->id < y->id ? -1 : 1;
+
+	/* keep the table order for duplicate IDs */
+	return x->treepos < y->treepos ? -1 : x->treepos > y->treepos;
+}
+
+/*
+ * Builds the mount tree if necessary.
+ *
+ * Returns: 1 if the tree is usable, 0 if the table has to be searched
+ * linearly.
+ */
+int mnt_table_use_tree(struct libmnt_table *tb)
+{
+	struct libmnt_fs **tree;
+	struct list_head *p;
+	size_t i = 0;
+
+	if (tb->tree)
+		return 1;
+	if (tb->noindex || tb->nents < MNT_TABIDX_MINENTS)
+		return 0;
+
+	tree = malloc(tb->nents * sizeof(struct libmnt_fs *));
+	if (!tree)
+		return 0;
+
+	list_for_each(p, &tb->ents) {
+		struct libmnt_fs *fs = list_entry(p, struct libmnt_fs, ents);
+
+		fs->treepos = i;
+		tree[i++] = fs;
+	}
+	qsort(tree, i, sizeof(struct libmnt_fs *), cmp_tree_fs);
+
+	for (i = 0; i < (size_t) tb->nents; i++)
+		tree[i]->treepos = i;
+
+	DBG(TAB, ul_debugobj(tb, "new tree [entries=%d]", tb->nents));
+	tb->tree = tree;
+	tb->ntree = tb->nents;
+	return 1;
+}
+
+/*
+ * Returns the child of @parent_id with the smallest ID or NULL. The tree has
+ * to be already built by mnt_table_use_tree().
+ */
+struct libmnt_fs *mnt_table_tree_first_child(struct libmnt_table *tb, int parent_id)
+{
+	size_t lo = 0, hi = tb->ntree;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (tb->tree[mid]->parent < parent_id)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo < tb->ntree && tb->tree[lo]->parent == parent_id)
+		return tb->tree[lo];
+	return NULL;
+}
+
+/*
+ * Returns the next sibling (the next bigger ID with the same parent) of @fs
+ * or NULL.
+ */
+struct libmnt_fs *mnt_table_tree_next_child(struct libmnt_table *tb, struct libmnt_fs *fs)
+{
+	size_t i = fs->treepos + 1;
+
+	if (i < tb->ntree && tb->tree[i]->parent == fs->parent)
+		return tb->tree[i];
+	return NULL;
+}
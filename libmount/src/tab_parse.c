@@ -33,16 +33,110 @@ struct libmnt_parser {
 	char	*buf;		/* buffer (the current line content) */
 	size_t	bufsiz;		/* size of the buffer */
 	size_t	line;		/* current line */
+
+	struct libmnt_strbuf *strbuf;	/* the whole file (zero-copy mode) */
+	char	*next;		/* next line in the strbuf */
 };
 
 static void parser_cleanup(struct libmnt_parser *pa)
 {
 	if (!pa)
 		return;
-	free(pa->buf);
+	if (pa->strbuf)
+		mnt_unref_strbuf(pa->strbuf);
+	else
+		free(pa->buf);
 	memset(pa, 0, sizeof(*pa));
 }
 
+void mnt_ref_strbuf(struct libmnt_strbuf *sb)
+{
+	if (sb)
+		sb->refcount++;
+}
+
+void mnt_unref_strbuf(struct libmnt_strbuf *sb)
+{
+	if (sb && --sb->refcount <= 0)
+		free(sb);
+}
+
+/*
+ * Reads the whole file to the buffer. The lines are terminated and unmangled
+ * in place, and the parsed entries point to the buffer.
+ */
+static int parser_read_strbuf(struct libmnt_parser *pa)
+{
+	struct libmnt_strbuf *sb = NULL, *x;
+	size_t sz = 0, bufsz = 0;
+
+	do {
+		if (sz + 1 >= bufsz) {
+			bufsz = bufsz ? bufsz * 2 : 64 * 1024;
+			x = realloc(sb, sizeof(*sb) + bufsz);
+			if (!x)
+				goto nomem;
+			sb = x;
+		}
+		sz += fread(sb->data + sz, 1, bufsz - sz - 1, pa->f);
+	} while (!feof(pa->f) && !ferror(pa->f));
+
+	if (ferror(pa->f)) {
+		int rc = errno ? -errno : -EIO;
+
+		free(sb);
+		return rc;
+	}
+
+	/* return unused memory */
+	x = realloc(sb, sizeof(*sb) + sz + 1);
+	if (x)
+		sb = x;
+
+	sb->data[sz] = '\0';
+	sb->size = sz + 1;
+	sb->refcount = 1;
+
+	pa->strbuf = sb;
+	pa->next = sb->data;
+
+	DBG(TAB, ul_debug("%s: read %zu bytes to the shared buffer", pa->filename, sz));
+	return 0;
+nomem:
+	free(sb);
+	return -ENOMEM;
+}
+
+static int parser_eof(struct libmnt_parser *pa)
+{
+	if (pa->strbuf)
+		return pa->next >= pa->strbuf->data + pa->strbuf->size - 1;
+	return feof(pa->f);
+}
+
+/*
+ * Reads the next line to pa->buf; in zero-copy mode it's the next line in the
+ * shared buffer.
+ */
+static int parser_getline(struct libmnt_parser *pa)
+{
+	if (pa->strbuf) {
+		char *end = pa->strbuf->data + pa->strbuf->size - 1;
+		char *nl;
+
+		if (pa->next >= end)
+			return -1;
+		pa->buf = pa->next;
+		pa->bufsiz = end - pa->buf + 1;
+
+		nl = memchr(pa->buf, '\n', end - pa->buf);
+		pa->next = nl ? nl + 1 : end;
+		return 0;
+	}
+
+	return getline(&pa->buf, &pa->bufsiz, pa->f) < 0 ? -1 : 0;
+}
+
 static const char *next_s32(const char *s, int *num, int *rc)
 {
 	char *end = NULL;
@@ -172,33 +266,58 @@ fail:
 
 
 /*
- * Parses one line from a mountinfo file
+ * Terminates and unmangles the next field in place. Returns the field, or its
+ * private copy if @fs does not use the shared buffer, or NULL if the field is
+ * empty.
  */
-static int mnt_parse_mountinfo_line(struct libmnt_fs *fs, const char *s)
+static char *next_field(struct libmnt_fs *fs, char **s)
+{
+	char *p = *s, *end = (char *) skip_nonspearator(p);
+
+	if (end == p)
+		return NULL;
+	if (*end)
+		*end++ = '\0';
+	*s = end;
+
+	unmangle_string(p);
+	return fs->strbuf ? p : strdup(p);
+}
+
+static inline void free_field(struct libmnt_fs *fs, char *p)
+{
+	if (!fs->strbuf)
+		free(p);
+}
+
+/*
+ * Parses one line from a mountinfo file; the line is modified.
+ */
+static int mnt_parse_mountinfo_line(struct libmnt_fs *fs, char *s)
 {
 	int rc = 0;
 	unsigned int maj, min;
-	char *p;
+	char *p, *sep;
 
 	fs->flags |= MNT_FS_KERNEL;
 
 	/* (1) id */
-	s = next_s32(s, &fs->id, &rc);
+	s = (char *) next_s32(s, &fs->id, &rc);
 	if (!s || !*s || rc) {
 		DBG(TAB, ul_debug("tab parse error: [id]"));
 		goto fail;
 	}
 
-	s = skip_separator(s);
+	s = (char *) skip_separator(s);
 
 	/* (2) parent */
-	s = next_s32(s, &fs->parent, &rc);
+	s = (char *) next_s32(s, &fs->parent, &rc);
 	if (!s || !*s || rc) {
 		DBG(TAB, ul_debug("tab parse error: [parent]"));
 		goto fail;
 	}
 
-	s = skip_separator(s);
+	s = (char *) skip_separator(s);
 
 	/* (3) maj:min */
 	if (sscanf(s, "%u:%u", &maj, &min) != 2) {
@@ -206,20 +325,20 @@ static int mnt_parse_mountinfo_line(struct libmnt_fs *fs, const char *s)
 		goto fail;
 	}
 	fs->devno = makedev(maj, min);
-	s = skip_nonspearator(s);
-	s = skip_separator(s);
+	s = (char *) skip_nonspearator(s);
+	s = (char *) skip_separator(s);
 
 	/* (4) mountroot */
-	fs->root = unmangle(s, &s);
+	fs->root = next_field(fs, &s);
 	if (!fs->root) {
 		DBG(TAB, ul_debug("tab parse error: [mountroot]"));
 		goto fail;
 	}
 
-	s = skip_separator(s);
+	s = (char *) skip_separator(s);
 
 	/* (5) target */
-	fs->target = unmangle(s, &s);
+	fs->target = next_field(fs, &s);
 	if (!fs->target) {
 		DBG(TAB, ul_debug("tab parse error: [target]"));
 		goto fail;
@@ -230,57 +349,61 @@ static int mnt_parse_mountinfo_line(struct libmnt_fs *fs, const char *s)
 	if (p && *p)
 		*p = '\0';
 
-	s = skip_separator(s);
+	s = (char *) skip_separator(s);
+
+	/* the optional fields are terminated by " - " */
+	sep = strstr(s, " - ");
+	if (!sep) {
+		DBG(TAB, ul_debug("mountinfo parse error: separator not found"));
+		return -EINVAL;
+	}
 
 	/* (6) vfs options (fs-independent) */
-	fs->vfs_optstr = unmangle(s, &s);
+	fs->vfs_optstr = next_field(fs, &s);
 	if (!fs->vfs_optstr) {
 		DBG(TAB, ul_debug("tab parse error: [VFS options]"));
 		goto fail;
 	}
 
-	/* (7) optional fields, terminated by " - " */
-	p = strstr(s, " - ");
-	if (!p) {
-		DBG(TAB, ul_debug("mountinfo parse error: separator not found"));
-		return -EINVAL;
+	/* (7) optional fields */
+	if (sep > s) {
+		*sep = '\0';
+		fs->opt_fields = fs->strbuf ? s : strdup(s);
 	}
-	if (p > s + 1)
-		fs->opt_fields = strndup(s + 1, p - s - 1);
 
-	s = skip_separator(p + 3);
+	s = (char *) skip_separator(sep + 3);
 
 	/* (8) FS type */
-	p = unmangle(s, &s);
+	p = next_field(fs, &s);
 	if (!p || (rc = __mnt_fs_set_fstype_ptr(fs, p))) {
 		DBG(TAB, ul_debug("tab parse error: [fstype]"));
-		free(p);
+		free_field(fs, p);
 		goto fail;
 	}
 
 	/* (9) source -- maybe empty string */
-	if (!s || !*s) {
+	if (!*s) {
 		DBG(TAB, ul_debug("tab parse error: [source]"));
 		goto fail;
-	} else if (*s == ' ' && *(s+1) == ' ') {
+	} else if (*s == ' ') {
 		if ((rc = mnt_fs_set_source(fs, ""))) {
 			DBG(TAB, ul_debug("tab parse error: [empty source]"));
 			goto fail;
 		}
 	} else {
-		s = skip_separator(s);
-		p = unmangle(s, &s);
+		s = (char *) skip_separator(s);
+		p = next_field(fs, &s);
 		if (!p || (rc = __mnt_fs_set_source_ptr(fs, p))) {
 			DBG(TAB, ul_debug("tab parse error: [regular source]"));
-			free(p);
+			free_field(fs, p);
 			goto fail;
 		}
 	}
 
-	s = skip_separator(s);
+	s = (char *) skip_separator(s);
 
 	/* (10) fs options (fs specific) */
-	fs->fs_optstr = unmangle(s, &s);
+	fs->fs_optstr = next_field(fs, &s);
 	if (!fs->fs_optstr) {
 		DBG(TAB, ul_debug("tab parse error: [FS options]"));
 		goto fail;
@@ -495,8 +618,8 @@ static int is_terminated_by_blank(const char *str)
  */
 static int next_comment_line(struct libmnt_parser *pa, char **last)
 {
-	if (getline(&pa->buf, &pa->bufsiz, pa->f) < 0)
-		return feof(pa->f) ? 1 : -errno;
+	if (parser_getline(pa) < 0)
+		return parser_eof(pa) ? 1 : -errno;
 
 	pa->line++;
 	*last = strchr(pa->buf, '\n');
@@ -548,7 +671,7 @@ static int mnt_table_parse_next(struct libmnt_parser *pa,
 	/* read the next non-blank non-comment line */
 next_line:
 	do {
-		if (getline(&pa->buf, &pa->bufsiz, pa->f) < 0)
+		if (parser_getline(pa) < 0)
 			return -EINVAL;
 		pa->line++;
 		s = strchr(pa->buf, '\n');
@@ -558,7 +681,7 @@ next_line:
 
 			/* Missing final newline?  Otherwise an extremely */
 			/* long line - assume file was corrupted */
-			if (feof(pa->f))
+			if (parser_eof(pa))
 				s = memchr(pa->buf, '\0', pa->bufsiz);
 
 		/* comments parser */
@@ -566,12 +689,12 @@ next_line:
 		    && (tb->fmt == MNT_FMT_GUESS || tb->fmt == MNT_FMT_FSTAB)
 		    && is_comment_line(pa->buf)) {
 			do {
-				rc = append_comment(tb, fs, pa->buf, feof(pa->f));
+				rc = append_comment(tb, fs, pa->buf, parser_eof(pa));
 				if (!rc)
 					rc = next_comment_line(pa, &s);
 			} while (rc == 0);
 
-			if (rc == 1 && feof(pa->f))
+			if (rc == 1 && parser_eof(pa))
 				rc = append_comment(tb, fs, NULL, 1);
 			if (rc < 0)
 				return rc;
@@ -694,6 +817,19 @@ static int kernel_fs_postparse(struct libmnt_table *tb,
 	return rc;
 }
 
+/*
+ * Zero-copy mode is used for mountinfo files only; the other formats
+ * allocate the strings anyway.
+ */
+static int use_zerocopy(struct libmnt_table *tb, const char *filename)
+{
+	if (tb->nozerocopy || tb->comms)
+		return 0;
+	if (tb->fmt == MNT_FMT_MOUNTINFO)
+		return 1;
+	return tb->fmt == MNT_FMT_GUESS && filename && endswith(filename, "/mountinfo");
+}
+
 /**
  * mnt_table_parse_stream:
  * @tb: tab pointer
@@ -720,6 +856,12 @@ int mnt_table_parse_stream(struct libmnt_table *tb, FILE *f, const char *filenam
 	pa.filename = filename;
 	pa.f = f;
 
+	if (use_zerocopy(tb, filename)) {
+		rc = parser_read_strbuf(&pa);
+		if (rc)
+			goto err;
+	}
+
 	/* necessary for /proc/mounts only, the /proc/self/mountinfo
 	 * parser sets the flag properly
 	 */
@@ -729,17 +871,27 @@ int mnt_table_parse_stream(struct libmnt_table *tb, FILE *f, const char *filenam
 	do {
 		struct libmnt_fs *fs;
 
-		if (feof(f)) {
+		if (parser_eof(&pa)) {
 			DBG(TAB, ul_debugobj(tb, "end-of-file"));
 			break;
 		}
 		fs = mnt_new_fs();
 		if (!fs)
 			goto err;
+		if (pa.strbuf) {
+			fs->strbuf = pa.strbuf;
+			mnt_ref_strbuf(fs->strbuf);
+		}
 
 		/* parse */
 		rc = mnt_table_parse_next(&pa, tb, fs);
 
+		/* only mountinfo parser uses the shared buffer */
+		if (rc == 0 && fs->strbuf && tb->fmt != MNT_FMT_MOUNTINFO) {
+			mnt_unref_strbuf(fs->strbuf);
+			fs->strbuf = NULL;
+		}
+
 		if (rc == 0 && tb->fltrcb && tb->fltrcb(fs, tb->fltrcb_data))
 			rc = 1;	/* filtered out by callback... */
 
@@ -765,7 +917,7 @@ int mnt_table_parse_stream(struct libmnt_table *tb, FILE *f, const char *filenam
 		}
 
 		/* fatal errors */
-		if (rc < 0 && !feof(f)) {
+		if (rc < 0 && !parser_eof(&pa)) {
 			DBG(TAB, ul_debugobj(tb, "fatal error"));
 			goto err;
 		}
@@ -19,7 +19,8 @@
  * userspace independently of system configuration. This low-level API works on
  * systems both with and without /etc/mtab. On systems without the regular /etc/mtab
  * file, the userspace mount options (e.g. user=) are stored in the /run/mount/utab
- * file.
+ * file. A new utab entry is appended to the file, so mount does not rewrite
+ * the whole file.
  *
  * It's recommended to use high-level struct libmnt_context API.
  */
@@ -30,6 +31,8 @@
 #include "mountP.h"
 #include "mangle.h"
 #include "pathnames.h"
+#include "buffer.h"
+#include "all-io.h"
 
 struct libmnt_update {
 	char		*target;
@@ -40,6 +43,7 @@ struct libmnt_update {
 	int		ready;
 
 	struct libmnt_table *mountinfo;
+	struct libmnt_stat *lockstat;	/* lock wait statistics */
 };
 
 static int set_fs_root(struct libmnt_update *upd, struct libmnt_fs *fs, unsigned long mountflags);
@@ -82,6 +86,15 @@ void mnt_free_update(struct libmnt_update *upd)
 	free(upd);
 }
 
+/*
+ * Private API: the time spent waiting for the lock is accounted to @st.
+ */
+void mnt_update_set_lock_stat(struct libmnt_update *upd, struct libmnt_stat *st)
+{
+	if (upd)
+		upd->lockstat = st;
+}
+
 /*
  * Returns 0 on success, <0 in case of error.
  */
@@ -452,59 +465,61 @@ static int fprintf_mtab_fs(FILE *f, struct libmnt_fs *fs)
 	return rc;
 }
 
-static int fprintf_utab_fs(FILE *f, struct libmnt_fs *fs)
+static int append_utab_var(struct ul_buffer *buf, const char *name,
+			   const char *val, const char *sep)
 {
 	char *p;
-	int rc = 0;
+	int rc;
+
+	if (!val)
+		return 0;
+	p = mangle(val);
+	if (!p)
+		return -ENOMEM;
+
+	rc = ul_buffer_append_string(buf, name);
+	if (!rc)
+		rc = ul_buffer_append_string(buf, p);
+	if (!rc)
+		rc = ul_buffer_append_string(buf, sep);
+	free(p);
+	return rc;
+}
+
+/* composes utab line */
+static int utab_line_to_buffer(struct ul_buffer *buf, struct libmnt_fs *fs)
+{
+	int rc;
+
+	rc = append_utab_var(buf, "SRC=", mnt_fs_get_source(fs), " ");
+	if (!rc)
+		rc = append_utab_var(buf, "TARGET=", mnt_fs_get_target(fs), " ");
+	if (!rc)
+		rc = append_utab_var(buf, "ROOT=", mnt_fs_get_root(fs), " ");
+	if (!rc)
+		rc = append_utab_var(buf, "BINDSRC=", mnt_fs_get_bindsrc(fs), " ");
+	if (!rc)
+		rc = append_utab_var(buf, "ATTRS=", mnt_fs_get_attributes(fs), " ");
+	if (!rc)
+		rc = append_utab_var(buf, "OPTS=", mnt_fs_get_user_options(fs), "");
+	if (!rc)
+		rc = ul_buffer_append_string(buf, "\n");
+	return rc;
+}
+
+static int fprintf_utab_fs(FILE *f, struct libmnt_fs *fs)
+{
+	struct ul_buffer buf = UL_INIT_BUFFER;
+	int rc;
 
 	if (!fs || !f)
 		return -EINVAL;
 
-	p = mangle(mnt_fs_get_source(fs));
-	if (p) {
-		rc = fprintf(f, "SRC=%s ", p);
-		free(p);
-	}
-	if (rc >= 0) {
-		p = mangle(mnt_fs_get_target(fs));
-		if (p) {
-			rc = fprintf(f, "TARGET=%s ", p);
-			free(p);
-		}
-	}
-	if (rc >= 0) {
-		p = mangle(mnt_fs_get_root(fs));
-		if (p) {
-			rc = fprintf(f, "ROOT=%s ", p);
-			free(p);
-		}
-	}
-	if (rc >= 0) {
-		p = mangle(mnt_fs_get_bindsrc(fs));
-		if (p) {
-			rc = fprintf(f, "BINDSRC=%s ", p);
-			free(p);
-		}
-	}
-	if (rc >= 0) {
-		p = mangle(mnt_fs_get_attributes(fs));
-		if (p) {
-			rc = fprintf(f, "ATTRS=%s ", p);
-			free(p);
-		}
-	}
-	if (rc >= 0) {
-		p = mangle(mnt_fs_get_user_options(fs));
-		if (p) {
-			rc = fprintf(f, "OPTS=%s", p);
-			free(p);
-		}
-	}
-	if (rc >= 0)
-		rc = fprintf(f, "\n");
+	rc = utab_line_to_buffer(&buf, fs);
+	if (!rc && fputs(ul_buffer_get_data(&buf), f) == EOF)
+		rc = errno ? -errno : -EIO;
 
-	if (rc > 0)
-		rc = 0;	/* success */
+	ul_buffer_free_data(&buf);
 	return rc;
 }
 
@@ -820,6 +835,53 @@ static int update_modify_options(struct libmnt_update *upd, struct libmnt_lock *
 	return rc;
 }
 
+/*
+ * Appends the new entry to the utab file by one write(2). The line is in the
+ * same format as written by update_table(), so the file is still readable by
+ * all libmount versions. The lock is necessary to not lose the entry when
+ * another process rewrites the file (umount, move or remount).
+ */
+static int update_append_utab(struct libmnt_update *upd, struct libmnt_lock *lc)
+{
+	struct ul_buffer buf = UL_INIT_BUFFER;
+	const char *data;
+	int fd, rc;
+
+	assert(upd);
+	assert(upd->fs);
+
+	rc = utab_line_to_buffer(&buf, upd->fs);
+	if (rc)
+		goto done;
+	data = ul_buffer_get_data(&buf);
+
+	DBG(UPDATE, ul_debugobj(upd, "%s: append: %s", upd->filename, data));
+
+	if (lc)
+		rc = mnt_lock_file(lc);
+	if (rc) {
+		rc = -MNT_ERR_LOCK;
+		goto done;
+	}
+
+	fd = open(upd->filename, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC,
+			S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+	if (fd >= 0) {
+		/* the same mode as for the rewritten file, ignore umask */
+		rc = fchmod(fd, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH) ? -errno : 0;
+		if (!rc && write_all(fd, data, strlen(data)) != 0)
+			rc = -errno;
+		close(fd);
+	} else
+		rc = -errno;
+
+	if (lc)
+		mnt_unlock_file(lc);
+done:
+	ul_buffer_free_data(&buf);
+	return rc;
+}
+
 /**
  * mnt_update_table:
  * @upd: update
@@ -855,6 +917,8 @@ int mnt_update_table(struct libmnt_update *upd, struct libmnt_lock *lc)
 	}
 	if (lc && upd->userspace_only)
 		mnt_lock_use_simplelock(lc, TRUE);	/* use flock */
+	if (lc)
+		mnt_lock_set_stat(lc, upd->lockstat);
 
 	if (!upd->fs && upd->target)
 		rc = update_remove_entry(upd, lc);	/* umount */
@@ -862,6 +926,8 @@ int mnt_update_table(struct libmnt_update *upd, struct libmnt_lock *lc)
 		rc = update_modify_target(upd, lc);	/* move */
 	else if (upd->mountflags & MS_REMOUNT)
 		rc = update_modify_options(upd, lc);	/* remount */
+	else if (upd->fs && upd->userspace_only)
+		rc = update_append_utab(upd, lc);	/* mount, utab */
 	else if (upd->fs)
 		rc = update_add_entry(upd, lc);	/* mount */
 
@@ -891,6 +957,8 @@ int mnt_update_already_done(struct libmnt_update *upd, struct libmnt_lock *lc)
 	}
 	if (lc && upd->userspace_only)
 		mnt_lock_use_simplelock(lc, TRUE);	/* use flock */
+	if (lc)
+		mnt_lock_set_stat(lc, upd->lockstat);
 	if (lc) {
 		rc = mnt_lock_file(lc);
 		if (rc) {
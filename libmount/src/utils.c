@@ -31,6 +31,7 @@
 #include "fileutils.h"
 #include "statfs_magic.h"
 #include "sysfs.h"
+#include "monotonic.h"
 
 int append_string(char **a, const char *b)
 {
@@ -142,6 +143,43 @@ int mnt_lstat_mountpoint(const char *target, struct stat *st)
 #endif
 }
 
+/*
+ * Returns the ID of the mount @target belongs to (statx() STATX_MNT_ID). The
+ * @root is set to 1 if @target is the root of the mount, 0 if it is not, and
+ * -1 if the kernel does not provide STATX_ATTR_MOUNT_ROOT.
+ *
+ * Returns: 0 on success, -ENOSYS if mount IDs are not supported by libc or
+ * kernel, or negative errno.
+ */
+int mnt_get_mount_id(const char *target, int *id, int *root)
+{
+#if defined(HAVE_STATX) && defined(HAVE_STRUCT_STATX_STX_MNT_ID)
+	struct statx stx;
+	int flags = AT_STATX_DONT_SYNC;
+
+# ifdef AT_NO_AUTOMOUNT
+	flags |= AT_NO_AUTOMOUNT;
+# endif
+	if (statx(AT_FDCWD, target, flags, STATX_TYPE | STATX_MNT_ID, &stx) != 0)
+		return -errno;
+	if (!(stx.stx_mask & STATX_MNT_ID))
+		return -ENOSYS;
+
+	*id = (int) stx.stx_mnt_id;
+	if (root) {
+# ifdef STATX_ATTR_MOUNT_ROOT
+		if (stx.stx_attributes_mask & STATX_ATTR_MOUNT_ROOT)
+			*root = (stx.stx_attributes & STATX_ATTR_MOUNT_ROOT) ? 1 : 0;
+		else
+# endif
+			*root = -1;
+	}
+	return 0;
+#else
+	return -ENOSYS;
+#endif
+}
+
 
 /*
  * Note that the @target has to be an absolute path (so at least "/").  The
@@ -1166,6 +1204,36 @@ done:
 	return 1;
 }
 
+/*
+ * Returns the current monotonic time in microseconds, the @start argument
+ * for mnt_stat_add().
+ */
+uint64_t mnt_stat_start(void)
+{
+	struct timeval tv;
+
+	if (gettime_monotonic(&tv) != 0)
+		return 0;
+	return (uint64_t) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/*
+ * Accounts one call started at @start (see mnt_stat_start()) to @st.
+ */
+void mnt_stat_add(struct libmnt_stat *st, uint64_t start)
+{
+	uint64_t now;
+	int errsv = errno;	/* called after syscalls */
+
+	if (!st)
+		return;
+	now = mnt_stat_start();
+	errno = errsv;
+	st->count++;
+	if (start && now > start)
+		st->usec += now - start;
+}
+
 #ifdef TEST_PROGRAM
 static int test_match_fstype(struct libmnt_test *ts, int argc, char *argv[])
 {
@@ -1332,6 +1400,17 @@ static int test_statfs_type(struct libmnt_test *ts, int argc, char *argv[])
 	return rc;
 }
 
+static int test_mount_id(struct libmnt_test *ts, int argc, char *argv[])
+{
+	int rc, id = 0, root = 0;
+
+	rc = mnt_get_mount_id(argv[1], &id, &root);
+	if (rc)
+		printf("%s: mount ID unsupported or failed [rc=%d]\n", argv[1], rc);
+	else
+		printf("%s: mount ID %d, root %d\n", argv[1], id, root);
+	return rc;
+}
 
 int main(int argc, char *argv[])
 {
@@ -1348,6 +1427,7 @@ int main(int argc, char *argv[])
 	{ "--guess-root",    test_guess_root,      "[<maj:min>]" },
 	{ "--mkdir",         test_mkdir,           "<path>" },
 	{ "--statfs-type",   test_statfs_type,     "<path>" },
+	{ "--mount-id",      test_mount_id,        "<path>" },
 
 	{ NULL }
 	};
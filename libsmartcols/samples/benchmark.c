@@ -0,0 +1,170 @@
+/*
+ * This file may be redistributed under the terms of the
+ * GNU Lesser General Public License.
+ *
+ * Measures time to build, print and deallocate a large synthetic table.
+ * The output throughput is calculated from the size of the output file.
+ */
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+
+#include "c.h"
+#include "nls.h"
+#include "strutils.h"
+
+#include "libsmartcols.h"
+
+static double time_diff(struct timeval *a, struct timeval *b)
+{
+	return (a->tv_sec - b->tv_sec) + (a->tv_usec - b->tv_usec) / 1E6;
+}
+
+static void __attribute__((__noreturn__)) usage(void)
+{
+	FILE *out = stdout;
+	fprintf(out,
+		"\n %s [options]\n\n", program_invocation_short_name);
+
+	fputs(" -n, --nlines <num>     number of lines (default 100000)\n", out);
+	fputs(" -c, --ncols <num>      number of columns (default 10)\n", out);
+	fputs(" -a, --arena            allocate lines in arena\n", out);
+	fputs(" -e, --escape           use data with characters to escape\n", out);
+	fputs(" -J, --json             JSON output format\n", out);
+	fputs(" -r, --raw              RAW output format\n", out);
+	fputs(" -E, --export           use key=\"value\" output format\n", out);
+	fputs(" -o, --output <file>    print the table to the file (default /dev/null)\n", out);
+	fputs(" -h, --help             this help\n", out);
+	fputs("\n", out);
+
+	exit(EXIT_SUCCESS);
+}
+
+int main(int argc, char *argv[])
+{
+	struct libscols_table *tb;
+	struct timeval start, built, printed, freed;
+	const char *outname = "/dev/null";
+	size_t nlines = 100000, ncols = 10, i, j;
+	struct stat st;
+	FILE *out;
+	int c, escape = 0;
+
+	static const struct option longopts[] = {
+		{ "nlines", 1, NULL, 'n' },
+		{ "ncols",  1, NULL, 'c' },
+		{ "arena",  0, NULL, 'a' },
+		{ "escape", 0, NULL, 'e' },
+		{ "json",   0, NULL, 'J' },
+		{ "raw",    0, NULL, 'r' },
+		{ "export", 0, NULL, 'E' },
+		{ "output", 1, NULL, 'o' },
+		{ "help",   0, NULL, 'h' },
+		{ NULL, 0, NULL, 0 },
+	};
+
+	setlocale(LC_ALL, "");
+	scols_init_debug(0);
+
+	tb = scols_new_table();
+	if (!tb)
+		err(EXIT_FAILURE, "failed to create output table");
+
+	while((c = getopt_long(argc, argv, "ac:eEhJn:o:r", longopts, NULL)) != -1) {
+		switch(c) {
+		case 'n':
+			nlines = strtou32_or_err(optarg, "failed to parse number of lines");
+			break;
+		case 'c':
+			ncols = strtou32_or_err(optarg, "failed to parse number of columns");
+			break;
+		case 'a':
+			if (scols_table_enable_arena(tb, TRUE))
+				err(EXIT_FAILURE, "failed to enable arena");
+			break;
+		case 'e':
+			escape = 1;
+			break;
+		case 'J':
+			scols_table_enable_json(tb, TRUE);
+			scols_table_set_name(tb, "benchmark");
+			break;
+		case 'r':
+			scols_table_enable_raw(tb, TRUE);
+			break;
+		case 'E':
+			scols_table_enable_export(tb, TRUE);
+			break;
+		case 'o':
+			outname = optarg;
+			break;
+		case 'h':
+			usage();
+		default:
+			errtryhelp(EXIT_FAILURE);
+		}
+	}
+
+	out = fopen(outname, "w");
+	if (!out)
+		err(EXIT_FAILURE, "%s: open failed", outname);
+	scols_table_set_stream(tb, out);
+
+	gettimeofday(&start, NULL);
+
+	for (j = 0; j < ncols; j++) {
+		char name[32];
+
+		snprintf(name, sizeof(name), "COL%zu", j);
+		if (!scols_table_new_column(tb, name, 0, j ? SCOLS_FL_RIGHT : 0))
+			err(EXIT_FAILURE, "failed to create output column");
+	}
+
+	for (i = 0; i < nlines; i++) {
+		struct libscols_line *ln = scols_table_new_line(tb, NULL);
+
+		if (!ln)
+			err(EXIT_FAILURE, "failed to create output line");
+
+		for (j = 0; j < ncols; j++) {
+			char data[64];
+
+			if (j == 0)
+				snprintf(data, sizeof(data), "line-%zu", i);
+			else if (escape && j % 2)
+				snprintf(data, sizeof(data), "\"%zu\" $x\\y\tz", i);
+			else
+				snprintf(data, sizeof(data), "%zu", (i * 7919 + j * 104729) % 1000003);
+			if (scols_line_set_data(ln, j, data))
+				err(EXIT_FAILURE, "failed to set output data");
+		}
+	}
+	gettimeofday(&built, NULL);
+
+	if (scols_print_table(tb))
+		err(EXIT_FAILURE, "failed to print the table");
+	fflush(out);
+	gettimeofday(&printed, NULL);
+
+	scols_unref_table(tb);
+	gettimeofday(&freed, NULL);
+
+	if (fstat(fileno(out), &st) != 0)
+		err(EXIT_FAILURE, "%s: stat failed", outname);
+	fclose(out);
+
+	printf("cells: %zu\n", nlines * ncols);
+	printf("build: %.3f s\n", time_diff(&built, &start));
+	printf("print: %.3f s\n", time_diff(&printed, &built));
+	if (S_ISREG(st.st_mode) && time_diff(&printed, &built) > 0)
+		printf("output: %ju bytes, %.1f MB/s\n", (uintmax_t) st.st_size,
+			st.st_size / time_diff(&printed, &built) / 1E6);
+	printf("free:  %.3f s\n", time_diff(&freed, &printed));
+	printf("total: %.3f s\n", time_diff(&freed, &start));
+
+	return EXIT_SUCCESS;
+}
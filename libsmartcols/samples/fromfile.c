@@ -129,29 +129,48 @@ fail:
 	return NULL;
 }
 
-static int parse_column_data(FILE *f, struct libscols_table *tb, int col)
+static int read_data(FILE *f, char **str, size_t *len)
+{
+	char *p;
+	int i = getline(str, len, f);
+
+	if (i == -1)
+		return -1;
+
+	p = strrchr(*str, '\n');
+	if (p)
+		*p = '\0';
+
+	while ((p = strrchr(*str, '\\')) && *(p + 1) == 'n') {
+		*p = '\n';
+		memmove(p + 1, p + 2, i - (p + 2 - *str));
+	}
+	return 0;
+}
+
+/* numbers are stored as native values if @typed is set */
+static int parse_column_data(FILE *f, struct libscols_table *tb, int col, int typed)
 {
 	size_t len = 0, nlines = 0;
-	int i;
 	char *str = NULL;
 
-	while ((i = getline(&str, &len, f)) != -1) {
-
+	while (read_data(f, &str, &len) == 0) {
 		struct libscols_line *ln;
-		char *p = strrchr(str, '\n');
-		if (p)
-			*p = '\0';
-
-		while ((p = strrchr(str, '\\')) && *(p + 1) == 'n') {
-			*p = '\n';
-			memmove(p + 1, p + 2, i - (p + 2 - str));
-		}
+		char *end = NULL;
+		long long num;
 
 		ln = scols_table_get_line(tb, nlines++);
 		if (!ln)
 			break;
-
-		if (*str && scols_line_set_data(ln, col, str) != 0)
+		if (!*str)
+			continue;
+
+		errno = 0;
+		num = typed ? strtoll(str, &end, 10) : 0;
+		if (typed && !errno && end && !*end) {
+			if (scols_cell_set_s64(scols_line_get_cell(ln, col), num))
+				err(EXIT_FAILURE, "failed to add output data");
+		} else if (scols_line_set_data(ln, col, str) != 0)
 			err(EXIT_FAILURE, "failed to add output data");
 	}
 
@@ -160,6 +179,39 @@ static int parse_column_data(FILE *f, struct libscols_table *tb, int col)
 
 }
 
+/* read all the data files in parallel, the table prints the lines when added */
+static void stream_data(struct libscols_table *tb, int nlines, int argc, char *argv[])
+{
+	FILE **fs = xcalloc(argc, sizeof(FILE *));
+	size_t len = 0;
+	char *str = NULL;
+	int n, i;
+
+	for (i = 0; i < argc; i++) {
+		fs[i] = fopen(argv[i], "r");
+		if (!fs[i])
+			err(EXIT_FAILURE, "%s: open failed", argv[i]);
+	}
+
+	for (n = 0; n < nlines; n++) {
+		struct libscols_line *ln = scols_table_new_line(tb, NULL);
+
+		if (!ln)
+			err(EXIT_FAILURE, "failed to add a new line");
+
+		for (i = 0; i < argc; i++) {
+			if (read_data(fs[i], &str, &len) == 0 && *str
+			    && scols_line_set_data(ln, i, str) != 0)
+				err(EXIT_FAILURE, "failed to add output data");
+		}
+	}
+
+	for (i = 0; i < argc; i++)
+		fclose(fs[i]);
+	free(fs);
+	free(str);
+}
+
 static struct libscols_line *get_line_with_id(struct libscols_table *tb,
 						int col_id, const char *id)
 {
@@ -214,7 +266,9 @@ static void __attribute__((__noreturn__)) usage(void)
 	fputs(" -C, --colsep <str>             set columns separator\n", out);
 	fputs(" -w, --width <num>              hardcode terminal width\n", out);
 	fputs(" -p, --tree-parent-column <n>   parent column\n", out);
+	fputs(" -S, --stream <num>             streaming mode, number of lines to calculate widths\n", out);
 	fputs(" -i, --tree-id-column <n>       id column\n", out);
+	fputs(" -s, --sort <n>                 sort by column, numbers are sorted as native values\n", out);
 	fputs(" -h, --help                     this help\n", out);
 	fputs("\n", out);
 
@@ -225,7 +279,7 @@ int main(int argc, char *argv[])
 {
 	struct libscols_table *tb;
 	int c, n, nlines = 0;
-	int parent_col = -1, id_col = -1;
+	int parent_col = -1, id_col = -1, sort_col = -1;
 
 	static const struct option longopts[] = {
 		{ "maxout", 0, NULL, 'm' },
@@ -239,6 +293,8 @@ int main(int argc, char *argv[])
 		{ "raw",    0, NULL, 'r' },
 		{ "export", 0, NULL, 'E' },
 		{ "colsep",  1, NULL, 'C' },
+		{ "stream", 1, NULL, 'S' },
+		{ "sort",   1, NULL, 's' },
 		{ "help",   0, NULL, 'h' },
 		{ NULL, 0, NULL, 0 },
 	};
@@ -257,7 +313,7 @@ int main(int argc, char *argv[])
 	if (!tb)
 		err(EXIT_FAILURE, "failed to create output table");
 
-	while((c = getopt_long(argc, argv, "hCc:Ei:JMmn:p:rw:", longopts, NULL)) != -1) {
+	while((c = getopt_long(argc, argv, "hCc:Ei:JMmn:p:rS:s:w:", longopts, NULL)) != -1) {
 
 		err_exclusive_options(c, longopts, excl, excl_st);
 
@@ -304,6 +360,14 @@ int main(int argc, char *argv[])
 		case 'n':
 			nlines = strtou32_or_err(optarg, "failed to parse number of lines");
 			break;
+		case 'S':
+			scols_table_enable_streaming(tb, TRUE);
+			scols_table_set_stream_sample(tb,
+				strtou32_or_err(optarg, "failed to parse number of lines"));
+			break;
+		case 's':
+			sort_col = strtou32_or_err(optarg, "failed to parse sort column");
+			break;
 		case 'w':
 			scols_table_set_termforce(tb, SCOLS_TERMFORCE_ALWAYS);
 			scols_table_set_termwidth(tb, strtou32_or_err(optarg, "failed to parse terminal width"));
@@ -318,6 +382,13 @@ int main(int argc, char *argv[])
 	if (nlines <= 0)
 		errx(EXIT_FAILURE, "--nlines not set");
 
+	scols_table_enable_colors(tb, isatty(STDOUT_FILENO));
+
+	if (scols_table_is_streaming(tb)) {
+		stream_data(tb, nlines, argc - optind, argv + optind);
+		goto done;
+	}
+
 	for (n = 0; n < nlines; n++) {
 		struct libscols_line *ln = scols_new_line();
 
@@ -335,16 +406,18 @@ int main(int argc, char *argv[])
 		if (!f)
 			err(EXIT_FAILURE, "%s: open failed", argv[optind]);
 
-		parse_column_data(f, tb, n);
+		parse_column_data(f, tb, n, n == sort_col);
 		optind++;
 		n++;
 	}
 
 	if (scols_table_is_tree(tb) && parent_col >= 0 && id_col >= 0)
 		compose_tree(tb, parent_col, id_col);
+	if (sort_col >= 0
+	    && scols_sort_table(tb, scols_table_get_column(tb, sort_col)))
+		err(EXIT_FAILURE, "failed to sort the table");
 
-	scols_table_enable_colors(tb, isatty(STDOUT_FILENO));
-
+done:
 	scols_print_table(tb);
 	scols_unref_table(tb);
 	return EXIT_SUCCESS;
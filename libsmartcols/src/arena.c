@@ -0,0 +1,134 @@
+/*
+ * arena.c - memory for table lines, cells and data
+ *
+ * This file may be redistributed under the terms of the
+ * GNU Lesser General Public License.
+ *
+ * The memory is allocated from large chunks and it's never freed separately;
+ * all the chunks are deallocated at once when the last reference to
+ * the arena is dropped. The table and every line allocated in the arena keep
+ * the reference, so the lines are usable after the table is deallocated.
+ *
+ * See scols_table_enable_arena().
+ */
+#include "smartcolsP.h"
+
+#define ARENA_CHUNKSZ	(64 * 1024)
+#define ARENA_ALIGN	(2 * sizeof(void *))
+
+#define arena_align(_sz)	(((_sz) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+struct arena_chunk {
+	struct arena_chunk *next;
+	size_t	size;		/* usable size */
+	size_t	used;
+};
+
+struct libscols_arena {
+	int	refcount;
+	size_t	nchunks;
+	struct arena_chunk *chunks;	/* the first chunk is the current */
+};
+
+#define chunk_data(_ch)	((char *) (_ch) + arena_align(sizeof(struct arena_chunk)))
+
+struct libscols_arena *new_arena(void)
+{
+	struct libscols_arena *ar = calloc(1, sizeof(*ar));
+
+	if (!ar)
+		return NULL;
+
+	ar->refcount = 1;
+	DBG(TAB, ul_debugobj(ar, "alloc arena"));
+	return ar;
+}
+
+void ref_arena(struct libscols_arena *ar)
+{
+	if (ar)
+		ar->refcount++;
+}
+
+void unref_arena(struct libscols_arena *ar)
+{
+	if (ar && --ar->refcount <= 0) {
+		DBG(TAB, ul_debugobj(ar, "dealloc arena [chunks=%zu]", ar->nchunks));
+		while (ar->chunks) {
+			struct arena_chunk *ch = ar->chunks;
+
+			ar->chunks = ch->next;
+			free(ch);
+		}
+		free(ar);
+	}
+}
+
+static struct arena_chunk *new_chunk(struct libscols_arena *ar, size_t sz)
+{
+	struct arena_chunk *ch = malloc(arena_align(sizeof(struct arena_chunk)) + sz);
+
+	if (!ch)
+		return NULL;
+
+	ch->size = sz;
+	ch->used = 0;
+	ar->nchunks++;
+	return ch;
+}
+
+static void *arena_get(struct libscols_arena *ar, size_t sz)
+{
+	struct arena_chunk *ch = ar->chunks;
+	void *p;
+
+	sz = arena_align(sz ? sz : 1);
+
+	if (!ch || ch->size - ch->used < sz) {
+		if (sz > ARENA_CHUNKSZ / 4) {
+			/* large request, don't waste the current chunk */
+			ch = new_chunk(ar, sz);
+			if (!ch)
+				return NULL;
+			if (ar->chunks) {
+				ch->next = ar->chunks->next;
+				ar->chunks->next = ch;
+			} else {
+				ch->next = NULL;
+				ar->chunks = ch;
+			}
+		} else {
+			ch = new_chunk(ar, ARENA_CHUNKSZ);
+			if (!ch)
+				return NULL;
+			ch->next = ar->chunks;
+			ar->chunks = ch;
+		}
+	}
+
+	p = chunk_data(ch) + ch->used;
+	ch->used += sz;
+	return p;
+}
+
+/*
+ * Returns zeroed memory for @sz bytes or NULL.
+ */
+void *arena_alloc(struct libscols_arena *ar, size_t sz)
+{
+	void *p = arena_get(ar, sz);
+
+	if (p)
+		memset(p, 0, sz);
+	return p;
+}
+
+char *arena_strdup(struct libscols_arena *ar, const char *str)
+{
+	size_t sz = strlen(str) + 1;
+	char *p = arena_get(ar, sz);
+
+	if (p)
+		memcpy(p, str, sz);
+	return p;
+}
@@ -10,6 +10,8 @@ struct libscols_buffer {
 
 	size_t	bufsz;		/* size of the buffer */
 	size_t	art_idx;	/* begin of the tree ascii art or zero */
+
+	struct libscols_cell *cell;	/* the data is a copy of the cell data */
 };
 
 struct libscols_buffer *new_buffer(size_t sz)
@@ -22,6 +24,8 @@ struct libscols_buffer *new_buffer(size_t sz)
 	buf->cur = buf->begin = ((char *) buf) + sizeof(struct libscols_buffer);
 	buf->encdata = NULL;
 	buf->bufsz = sz;
+	buf->art_idx = 0;
+	buf->cell = NULL;
 
 	DBG(BUFF, ul_debugobj(buf, "alloc (size=%zu)", sz));
 	return buf;
@@ -45,6 +49,7 @@ int buffer_reset_data(struct libscols_buffer *buf)
 	buf->begin[0] = '\0';
 	buf->cur = buf->begin;
 	buf->art_idx = 0;
+	buf->cell = NULL;
 	return 0;
 }
 
@@ -64,6 +69,7 @@ int buffer_append_data(struct libscols_buffer *buf, const char *str)
 		return -EINVAL;
 	memcpy(buf->cur, str, sz + 1);
 	buf->cur += sz;
+	buf->cell = NULL;
 	return 0;
 }
 
@@ -85,6 +91,24 @@ int buffer_set_data(struct libscols_buffer *buf, const char *str)
 	return rc ? rc : buffer_append_data(buf, str);
 }
 
+/*
+ * Copies the cell data to the buffer and keeps the link to the cell, so the
+ * cached cell width and ASCII flag are usable until the buffer is modified.
+ */
+int buffer_set_cell_data(struct libscols_buffer *buf, struct libscols_cell *ce)
+{
+	int rc = buffer_set_data(buf, ce->data);
+
+	if (!rc)
+		buf->cell = ce;
+	return rc;
+}
+
+struct libscols_cell *buffer_get_cell(struct libscols_buffer *buf)
+{
+	return buf ? buf->cell : NULL;
+}
+
 /* save the current buffer position to art_idx */
 void buffer_set_art_index(struct libscols_buffer *buf)
 {
@@ -116,6 +140,14 @@ char *buffer_get_safe_data(struct libscols_table *tb,
 	if (!data)
 		goto nothing;
 
+	/* fast path, nothing to encode and width is number of bytes */
+	if (buf->cell && buf->cell->is_ascii) {
+		*cells = buf->cur - buf->begin;
+		if (!*cells)
+			goto nothing;
+		return data;
+	}
+
 	if (!buf->encdata) {
 		buf->encdata = malloc(mbs_safe_encode_size(buf->bufsz) + 1);
 		if (!buf->encdata)
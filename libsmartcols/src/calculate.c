@@ -39,6 +39,7 @@ static int count_cell_width(struct libscols_table *tb,
 {
 	size_t len;
 	char *data;
+	struct libscols_cell *ce;
 	int rc;
 
 	rc = __cell_to_buffer(tb, ln, cl, buf);
@@ -46,14 +47,24 @@ static int count_cell_width(struct libscols_table *tb,
 		return rc;
 
 	data = buffer_get_data(buf);
+	ce = buffer_get_cell(buf);
+
 	if (!data)
 		len = 0;
 	else if (scols_column_is_customwrap(cl))
 		len = cl->wrap_chunksize(cl, data, cl->wrapfunc_data);
-	else if (scols_table_is_noencoding(tb))
-		len = mbs_width(data);
-	else
-		len = mbs_safe_width(data);
+	else if (ce && ce->width_ok)
+		len = ce->width;
+	else {
+		if (scols_table_is_noencoding(tb))
+			len = mbs_width(data);
+		else
+			len = mbs_safe_width(data);
+		if (ce) {
+			ce->width = len;
+			ce->width_ok = 1;
+		}
+	}
 
 	if (len == (size_t) -1)		/* ignore broken multibyte strings */
 		len = 0;
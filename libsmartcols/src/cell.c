@@ -16,6 +16,11 @@
  * An API to access and modify per-cell data and information. Note that cell is
  * always part of the line. If you destroy (un-reference) a line than it
  * destroys all line cells too.
+ *
+ * The cell may also contain a native value (number, boolean or time, see
+ * scols_cell_set_u64() and the other setters). The value is used for sorting
+ * by scols_cmpnum_cells(), and it's formatted to the cell data when necessary
+ * if the data string is not set.
  */
 
 
@@ -23,8 +28,10 @@
 #include <unistd.h>
 #include <string.h>
 #include <ctype.h>
+#include <inttypes.h>
 
 #include "smartcolsP.h"
+#include "timeutils.h"
 
 /*
  * The cell has no ref-counting, free() and new() functions. All is
@@ -45,7 +52,8 @@ int scols_reset_cell(struct libscols_cell *ce)
 		return -EINVAL;
 
 	/*DBG(CELL, ul_debugobj(ce, "reset"));*/
-	free(ce->data);
+	if (!ce->in_arena)
+		free(ce->data);
 	free(ce->color);
 	memset(ce, 0, sizeof(*ce));
 	return 0;
@@ -62,7 +70,38 @@ int scols_reset_cell(struct libscols_cell *ce)
  */
 int scols_cell_set_data(struct libscols_cell *ce, const char *data)
 {
-	return strdup_to_struct_member(ce, data, data);
+	int rc;
+
+	if (ce && ce->in_arena) {
+		ce->data = NULL;	/* owned by arena */
+		ce->in_arena = 0;
+	}
+	rc = strdup_to_struct_member(ce, data, data);
+	if (!rc)
+		ce->width_ok = ce->is_ascii = ce->formatted = 0;
+	return rc;
+}
+
+/*
+ * The same as scols_cell_set_data(), but the copy is allocated in the line
+ * arena.
+ */
+int scols_cell_set_arena_data(struct libscols_cell *ce, const char *data,
+			      struct libscols_arena *ar)
+{
+	char *p = NULL;
+
+	if (data) {
+		p = arena_strdup(ar, data);
+		if (!p)
+			return -ENOMEM;
+	}
+	if (!ce->in_arena)
+		free(ce->data);
+	ce->data = p;
+	ce->in_arena = 1;
+	ce->width_ok = ce->is_ascii = ce->formatted = 0;
+	return 0;
 }
 
 /**
@@ -81,8 +120,10 @@ int scols_cell_refer_data(struct libscols_cell *ce, char *data)
 {
 	if (!ce)
 		return -EINVAL;
-	free(ce->data);
+	if (!ce->in_arena)
+		free(ce->data);
 	ce->data = data;
+	ce->in_arena = ce->width_ok = ce->is_ascii = ce->formatted = 0;
 	return 0;
 }
 
@@ -90,13 +131,225 @@ int scols_cell_refer_data(struct libscols_cell *ce, char *data)
  * scols_cell_get_data:
  * @ce: a pointer to a struct libscols_cell instance
  *
- * Returns: data in @ce or NULL.
+ * Returns: data in @ce or NULL. For cells with a native value and without
+ * data string returns the formatted value.
  */
 const char *scols_cell_get_data(const struct libscols_cell *ce)
 {
+	if (ce && !ce->data && ce->datatype)
+		scols_cell_format_data((struct libscols_cell *) ce);
 	return ce ? ce->data : NULL;
 }
 
+/*
+ * Formats the native value to the cell data. The numbers are formatted as
+ * decimal, booleans as "1" or "0" and time in ISO 8601 format.
+ */
+int scols_cell_format_data(struct libscols_cell *ce)
+{
+	char buf[64], *p;
+
+	if (ce->data || !ce->datatype)
+		return 0;
+
+	switch (ce->datatype) {
+	case SCOLS_DATA_U64:
+		snprintf(buf, sizeof(buf), "%" PRIu64, ce->value.u64);
+		break;
+	case SCOLS_DATA_S64:
+		snprintf(buf, sizeof(buf), "%" PRId64, ce->value.s64);
+		break;
+	case SCOLS_DATA_DOUBLE:
+		snprintf(buf, sizeof(buf), "%.15g", ce->value.dbl);
+		break;
+	case SCOLS_DATA_BOOLEAN:
+		xstrncpy(buf, ce->value.u64 ? "1" : "0", sizeof(buf));
+		break;
+	case SCOLS_DATA_TIME:
+		if (strtime_iso(&ce->value.time, ISO_TIMESTAMP_T, buf, sizeof(buf)))
+			return -EINVAL;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	p = strdup(buf);
+	if (!p)
+		return -ENOMEM;
+
+	ce->data = p;
+	ce->in_arena = 0;
+	ce->formatted = 1;
+	return 0;
+}
+
+/* the old formatted data are invalid */
+static int set_datatype(struct libscols_cell *ce, int type)
+{
+	if (!ce)
+		return -EINVAL;
+	if (ce->formatted) {
+		free(ce->data);
+		ce->data = NULL;
+		ce->formatted = 0;
+	}
+	ce->datatype = type;
+	ce->width_ok = ce->is_ascii = 0;
+	return 0;
+}
+
+/**
+ * scols_cell_set_u64:
+ * @ce: a pointer to a struct libscols_cell instance
+ * @num: value
+ *
+ * Sets native unsigned number value. If the data string is not set by
+ * scols_cell_set_data() or scols_cell_refer_data() then the value is printed
+ * as a decimal number, otherwise the value is used only for sorting (see
+ * scols_cmpnum_cells()). It's possible to set the value and data in any
+ * order.
+ *
+ * Returns: 0, a negative value in case of an error.
+ *
+ * Since: 2.37
+ */
+int scols_cell_set_u64(struct libscols_cell *ce, uint64_t num)
+{
+	int rc = set_datatype(ce, SCOLS_DATA_U64);
+
+	if (!rc)
+		ce->value.u64 = num;
+	return rc;
+}
+
+/**
+ * scols_cell_set_s64:
+ * @ce: a pointer to a struct libscols_cell instance
+ * @num: value
+ *
+ * Sets native signed number value, see scols_cell_set_u64().
+ *
+ * Returns: 0, a negative value in case of an error.
+ *
+ * Since: 2.37
+ */
+int scols_cell_set_s64(struct libscols_cell *ce, int64_t num)
+{
+	int rc = set_datatype(ce, SCOLS_DATA_S64);
+
+	if (!rc)
+		ce->value.s64 = num;
+	return rc;
+}
+
+/**
+ * scols_cell_set_double:
+ * @ce: a pointer to a struct libscols_cell instance
+ * @num: value
+ *
+ * Sets native floating point value, see scols_cell_set_u64().
+ *
+ * Returns: 0, a negative value in case of an error.
+ *
+ * Since: 2.37
+ */
+int scols_cell_set_double(struct libscols_cell *ce, double num)
+{
+	int rc = set_datatype(ce, SCOLS_DATA_DOUBLE);
+
+	if (!rc)
+		ce->value.dbl = num;
+	return rc;
+}
+
+/**
+ * scols_cell_set_boolean:
+ * @ce: a pointer to a struct libscols_cell instance
+ * @b: 1 or 0
+ *
+ * Sets native boolean value, it's printed as "1" or "0" if the data string
+ * is not set. See scols_cell_set_u64().
+ *
+ * Returns: 0, a negative value in case of an error.
+ *
+ * Since: 2.37
+ */
+int scols_cell_set_boolean(struct libscols_cell *ce, int b)
+{
+	int rc = set_datatype(ce, SCOLS_DATA_BOOLEAN);
+
+	if (!rc)
+		ce->value.u64 = b ? 1 : 0;
+	return rc;
+}
+
+/**
+ * scols_cell_set_time:
+ * @ce: a pointer to a struct libscols_cell instance
+ * @t: time
+ *
+ * Sets native time value, it's printed in ISO 8601 format if the data string
+ * is not set. See scols_cell_set_u64().
+ *
+ * Returns: 0, a negative value in case of an error.
+ *
+ * Since: 2.37
+ */
+int scols_cell_set_time(struct libscols_cell *ce, time_t t)
+{
+	int rc = set_datatype(ce, SCOLS_DATA_TIME);
+
+	if (!rc)
+		ce->value.time = t;
+	return rc;
+}
+
+/**
+ * scols_cell_get_datatype:
+ * @ce: a pointer to a struct libscols_cell instance
+ *
+ * Returns: SCOLS_DATA_* type of the native value, SCOLS_DATA_NONE if the cell
+ * contains data string only.
+ *
+ * Since: 2.37
+ */
+int scols_cell_get_datatype(const struct libscols_cell *ce)
+{
+	return ce ? ce->datatype : SCOLS_DATA_NONE;
+}
+
+/*
+ * Checks the data for characters which need mbrtowc() or encoding and resets
+ * the cached width. It's called for all lines before the table is printed,
+ * so the cache follows also changes in data referenced by
+ * scols_cell_refer_data().
+ *
+ * Returns: size of the data in bytes.
+ */
+size_t scols_cell_check_data(struct libscols_cell *ce)
+{
+	const unsigned char *p;
+	int ascii = 1;
+
+	ce->width_ok = ce->is_ascii = 0;
+	if (!ce->data && ce->datatype)
+		scols_cell_format_data(ce);
+	if (!ce->data)
+		return 0;
+
+	for (p = (const unsigned char *) ce->data; *p; p++) {
+		/* control chars and \x are encoded, see mbs_safe_encode() */
+		if (*p < 0x20 || *p > 0x7e || (*p == '\\' && *(p + 1) == 'x'))
+			ascii = 0;
+	}
+
+	if (ascii) {
+		ce->is_ascii = ce->width_ok = 1;
+		ce->width = (const char *) p - ce->data;
+	}
+	return (const char *) p - ce->data;
+}
+
 /**
  * scols_cell_set_userdata:
  * @ce: a pointer to a struct libscols_cell instance
@@ -155,6 +408,56 @@ int scols_cmpstr_cells(struct libscols_cell *a,
 	return strcmp(adata, bdata);
 }
 
+/*
+ * Compares native values. The values without type are the first, values
+ * of the different types are ordered by the type.
+ */
+int __scols_cmp_values(int atype, const union libscols_value *a,
+		       int btype, const union libscols_value *b)
+{
+	if (atype != btype)
+		return atype < btype ? -1 : 1;
+
+	switch (atype) {
+	case SCOLS_DATA_U64:
+	case SCOLS_DATA_BOOLEAN:
+		return cmp_numbers(a->u64, b->u64);
+	case SCOLS_DATA_S64:
+		return cmp_numbers(a->s64, b->s64);
+	case SCOLS_DATA_DOUBLE:
+		return cmp_numbers(a->dbl, b->dbl);
+	case SCOLS_DATA_TIME:
+		return cmp_numbers(a->time, b->time);
+	}
+	return 0;
+}
+
+/**
+ * scols_cmpnum_cells:
+ * @a: pointer to cell
+ * @b: pointer to cell
+ * @data: unused pointer to private data (defined by API)
+ *
+ * Compares native cell values (see scols_cell_set_u64()). The cells without
+ * the value are ordered before the cells with the value. The function is
+ * designed for scols_column_set_cmpfunc() and scols_sort_table().
+ *
+ * Returns: follows strcmp() return values.
+ *
+ * Since: 2.37
+ */
+int scols_cmpnum_cells(struct libscols_cell *a,
+		       struct libscols_cell *b,
+		       __attribute__((__unused__)) void *data)
+{
+	if (a == b)
+		return 0;
+	if (!a || !b)
+		return a ? 1 : -1;
+
+	return __scols_cmp_values(a->datatype, &a->value, b->datatype, &b->value);
+}
+
 /**
  * scols_cell_set_color:
  * @ce: a pointer to a struct libscols_cell instance
@@ -246,7 +549,11 @@ int scols_cell_copy_content(struct libscols_cell *dest,
 {
 	int rc;
 
-	rc = scols_cell_set_data(dest, scols_cell_get_data(src));
+	rc = scols_cell_set_data(dest, src->formatted ? NULL : src->data);
+	if (!rc) {
+		dest->datatype = src->datatype;
+		dest->value = src->value;
+	}
 	if (!rc)
 		rc = scols_cell_set_color(dest, scols_cell_get_color(src));
 	if (!rc)
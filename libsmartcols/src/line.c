@@ -35,15 +35,28 @@
  * Returns: a pointer to a new struct libscols_line instance.
  */
 struct libscols_line *scols_new_line(void)
+{
+	return __scols_new_line(NULL);
+}
+
+/*
+ * Allocates the line in the arena @ar (if not NULL). The cells and data set
+ * by scols_line_set_data() are allocated in the same arena.
+ */
+struct libscols_line *__scols_new_line(struct libscols_arena *ar)
 {
 	struct libscols_line *ln;
 
-	ln = calloc(1, sizeof(*ln));
+	ln = ar ? arena_alloc(ar, sizeof(*ln)) : calloc(1, sizeof(*ln));
 	if (!ln)
 		return NULL;
 
-	DBG(LINE, ul_debugobj(ln, "alloc"));
+	DBG(LINE, ul_debugobj(ln, "alloc%s", ar ? " [arena]" : ""));
 	ln->refcount = 1;
+	if (ar) {
+		ln->arena = ar;
+		ref_arena(ar);
+	}
 	INIT_LIST_HEAD(&ln->ln_lines);
 	INIT_LIST_HEAD(&ln->ln_children);
 	INIT_LIST_HEAD(&ln->ln_branch);
@@ -73,6 +86,8 @@ void scols_ref_line(struct libscols_line *ln)
 void scols_unref_line(struct libscols_line *ln)
 {
 	if (ln && --ln->refcount <= 0) {
+		struct libscols_arena *ar = ln->arena;
+
 		DBG(CELL, ul_debugobj(ln, "dealloc"));
 		list_del(&ln->ln_lines);
 		list_del(&ln->ln_children);
@@ -80,7 +95,10 @@ void scols_unref_line(struct libscols_line *ln)
 		scols_unref_group(ln->group);
 		scols_line_free_cells(ln);
 		free(ln->color);
-		free(ln);
+		if (ar)
+			unref_arena(ar);	/* the line memory is owned by arena */
+		else
+			free(ln);
 		return;
 	}
 }
@@ -103,7 +121,8 @@ void scols_line_free_cells(struct libscols_line *ln)
 	for (i = 0; i < ln->ncells; i++)
 		scols_reset_cell(&ln->cells[i]);
 
-	free(ln->cells);
+	if (!ln->arena)
+		free(ln->cells);
 	ln->ncells = 0;
 	ln->cells = NULL;
 }
@@ -136,9 +155,19 @@ int scols_line_alloc_cells(struct libscols_line *ln, size_t n)
 
 	DBG(LINE, ul_debugobj(ln, "alloc %zu cells", n));
 
-	ce = realloc(ln->cells, n * sizeof(struct libscols_cell));
-	if (!ce)
-		return -errno;
+	if (ln->arena) {
+		/* the old cells are not deallocated, it's rare */
+		ce = arena_alloc(ln->arena, n * sizeof(struct libscols_cell));
+		if (!ce)
+			return -ENOMEM;
+		if (ln->ncells)
+			memcpy(ce, ln->cells,
+			       min(n, ln->ncells) * sizeof(struct libscols_cell));
+	} else {
+		ce = realloc(ln->cells, n * sizeof(struct libscols_cell));
+		if (!ce)
+			return -errno;
+	}
 
 	if (n > ln->ncells)
 		memset(ce + ln->ncells, 0,
@@ -442,6 +471,8 @@ int scols_line_set_data(struct libscols_line *ln, size_t n, const char *data)
 
 	if (!ce)
 		return -EINVAL;
+	if (ln->arena)
+		return scols_cell_set_arena_data(ce, data, ln->arena);
 	return scols_cell_set_data(ce, data);
 }
 
@@ -0,0 +1,322 @@
+/*
+ * output.c - buffered output writer
+ *
+ * This file may be redistributed under the terms of the
+ * GNU Lesser General Public License.
+ *
+ * The table output is composed in a large private buffer and written to the
+ * table stream by one fwrite() call per buffer. The data are larger than
+ * the stdio buffer, so the libc writes them directly by write(2). It
+ * saves per-call stdio locking and many small syscalls for large outputs.
+ *
+ * The strings are escaped in runs: the string is scanned for characters that
+ * need an escape sequence and the parts between them are copied by memcpy().
+ *
+ * The JSON writer follows lib/jsonwrt.c, but it writes to the buffer.
+ *
+ * The buffer is flushed by __scols_cleanup_printing(), so it's always empty
+ * when the printing is not in progress and it's possible to mix the table
+ * output with the output written by the application to the same stream.
+ */
+#include <ctype.h>
+
+#include "smartcolsP.h"
+#include "all-io.h"
+
+#define OUTPUT_BUFSZ	(64 * 1024)
+
+int out_init(struct libscols_table *tb)
+{
+	struct libscols_output *o = &tb->output;
+
+	o->json_indent = 0;
+	o->json_postponed_break = 0;
+
+	if (o->data)
+		return 0;
+
+	o->data = malloc(OUTPUT_BUFSZ);
+	if (!o->data)
+		return -ENOMEM;
+	o->sz = OUTPUT_BUFSZ;
+	o->len = 0;
+
+	DBG(TAB, ul_debugobj(tb, "alloc output buffer (size=%zu)", o->sz));
+	return 0;
+}
+
+int out_flush(struct libscols_table *tb)
+{
+	struct libscols_output *o = &tb->output;
+	int rc = 0;
+
+	if (o->len) {
+		rc = fwrite_all(o->data, 1, o->len, tb->out);
+		o->len = 0;
+	}
+	return rc ? -errno : 0;
+}
+
+void out_deinit(struct libscols_table *tb)
+{
+	struct libscols_output *o = &tb->output;
+
+	out_flush(tb);
+	free(o->data);
+	memset(o, 0, sizeof(*o));
+}
+
+void out_write(struct libscols_table *tb, const char *data, size_t sz)
+{
+	struct libscols_output *o = &tb->output;
+
+	if (!sz)
+		return;
+	if (o->len + sz > o->sz) {
+		out_flush(tb);
+
+		/* not initialized (or no memory) or too large */
+		if (sz > o->sz) {
+			fwrite_all(data, 1, sz, tb->out);
+			return;
+		}
+	}
+	memcpy(o->data + o->len, data, sz);
+	o->len += sz;
+}
+
+void out_puts(struct libscols_table *tb, const char *str)
+{
+	if (str)
+		out_write(tb, str, strlen(str));
+}
+
+void out_putc(struct libscols_table *tb, char c)
+{
+	struct libscols_output *o = &tb->output;
+
+	if (o->len < o->sz)
+		o->data[o->len++] = c;
+	else
+		out_write(tb, &c, 1);
+}
+
+static inline void out_put_case(struct libscols_table *tb, const char *str,
+				size_t sz, int dir)
+{
+	if (dir == 0)
+		out_write(tb, str, sz);
+	else {
+		size_t i;
+
+		for (i = 0; i < sz; i++) {
+			unsigned char c = (unsigned char) str[i];
+			out_putc(tb, dir == 1 ? toupper(c) : tolower(c));
+		}
+	}
+}
+
+/* writes @prefix and @c as two hex digits */
+static void out_put_hex(struct libscols_table *tb, const char *prefix, unsigned char c)
+{
+	static const char hex[] = "0123456789abcdef";
+	char buf[8];
+	size_t sz = strlen(prefix);
+
+	memcpy(buf, prefix, sz);
+	buf[sz++] = hex[c >> 4];
+	buf[sz++] = hex[c & 0xf];
+	out_write(tb, buf, sz);
+}
+
+/* the same as fputs_quoted_case_json() */
+void out_puts_json(struct libscols_table *tb, const char *str, int dir)
+{
+	const char *p, *run;
+
+	out_putc(tb, '"');
+	for (p = run = str; p && *p; p++) {
+		const unsigned char c = (unsigned char) *p;
+
+		if (c >= 0x20 && c != '"' && c != '\\')
+			continue;
+		if (p > run)
+			out_put_case(tb, run, p - run, dir);
+		run = p + 1;
+
+		switch (c) {
+		case '"':
+		case '\\':
+			out_putc(tb, '\\');
+			out_putc(tb, c);
+			break;
+		case '\b':
+			out_puts(tb, "\\b");
+			break;
+		case '\t':
+			out_puts(tb, "\\t");
+			break;
+		case '\n':
+			out_puts(tb, "\\n");
+			break;
+		case '\f':
+			out_puts(tb, "\\f");
+			break;
+		case '\r':
+			out_puts(tb, "\\r");
+			break;
+		default:
+			out_put_hex(tb, "\\u00", c);
+			break;
+		}
+	}
+	if (p && p > run)
+		out_put_case(tb, run, p - run, dir);
+	out_putc(tb, '"');
+}
+
+/* the same as fputs_quoted() */
+void out_puts_quoted(struct libscols_table *tb, const char *str)
+{
+	const char *p, *run;
+
+	out_putc(tb, '"');
+	for (p = run = str; p && *p; p++) {
+		const unsigned char c = (unsigned char) *p;
+
+		if (c != 0x22 && c != 0x5c && c != 0x60 && c != 0x24	/* " \ ` $ */
+		    && isprint(c) && !iscntrl(c))
+			continue;
+		if (p > run)
+			out_write(tb, run, p - run);
+		run = p + 1;
+		out_put_hex(tb, "\\x", c);
+	}
+	if (p && p > run)
+		out_write(tb, run, p - run);
+	out_putc(tb, '"');
+}
+
+/* the same as fputs_nonblank() */
+void out_puts_nonblank(struct libscols_table *tb, const char *str)
+{
+	const char *p, *run;
+
+	for (p = run = str; p && *p; p++) {
+		const unsigned char c = (unsigned char) *p;
+
+		if (!isblank(c) && c != 0x5c && isprint(c) && !iscntrl(c))
+			continue;
+		if (p > run)
+			out_write(tb, run, p - run);
+		run = p + 1;
+		out_put_hex(tb, "\\x", c);
+	}
+	if (p && p > run)
+		out_write(tb, run, p - run);
+}
+
+/*
+ * JSON, see lib/jsonwrt.c
+ */
+static void out_json_indent(struct libscols_table *tb)
+{
+	int i;
+
+	for (i = 0; i < tb->output.json_indent; i++)
+		out_write(tb, "   ", 3);
+}
+
+void out_json_open(struct libscols_table *tb, const char *name, int type)
+{
+	struct libscols_output *o = &tb->output;
+
+	if (o->json_postponed_break && !name)
+		;
+	else {
+		out_json_indent(tb);
+		if (name)
+			out_puts_json(tb, name, -1);
+	}
+
+	switch (type) {
+	case UL_JSON_OBJECT:
+		out_puts(tb, name ? ": {\n" : "{\n");
+		o->json_indent++;
+		break;
+	case UL_JSON_ARRAY:
+		out_puts(tb, name ? ": [\n" : "{\n");
+		o->json_indent++;
+		break;
+	case UL_JSON_VALUE:
+		out_puts(tb, name ? ": " : " ");
+		break;
+	}
+	o->json_postponed_break = 0;
+}
+
+void out_json_close(struct libscols_table *tb, int type, int islast)
+{
+	struct libscols_output *o = &tb->output;
+
+	if (o->json_indent == 0) {
+		out_puts(tb, "}\n");
+		o->json_indent--;
+		return;
+	}
+	assert(o->json_indent > 0);
+
+	switch (type) {
+	case UL_JSON_OBJECT:
+		o->json_indent--;
+		out_json_indent(tb);
+		out_puts(tb, islast ? "}" : "},");
+		break;
+	case UL_JSON_ARRAY:
+		o->json_indent--;
+		out_json_indent(tb);
+		out_puts(tb, islast ? "]" : "],");
+		break;
+	case UL_JSON_VALUE:
+		if (!islast)
+			out_putc(tb, ',');
+		break;
+	}
+
+	if (!islast && (type == UL_JSON_OBJECT || type == UL_JSON_ARRAY))
+		o->json_postponed_break = 1;
+	else {
+		out_putc(tb, '\n');
+		o->json_postponed_break = 0;
+	}
+}
+
+void out_json_value_raw(struct libscols_table *tb,
+			const char *name, const char *data, int islast)
+{
+	out_json_value_open(tb, name);
+	if (data && *data)
+		out_puts(tb, data);
+	else
+		out_puts(tb, "null");
+	out_json_value_close(tb, islast);
+}
+
+void out_json_value_s(struct libscols_table *tb,
+		      const char *name, const char *data, int islast)
+{
+	out_json_value_open(tb, name);
+	if (data && *data)
+		out_puts_json(tb, data, 0);
+	else
+		out_puts(tb, "null");
+	out_json_value_close(tb, islast);
+}
+
+void out_json_value_boolean(struct libscols_table *tb,
+			    const char *name, int data, int islast)
+{
+	out_json_value_open(tb, name);
+	out_puts(tb, data ? "true" : "false");
+	out_json_value_close(tb, islast);
+}
@@ -19,7 +19,7 @@ int scols_table_print_range(	struct libscols_table *tb,
 	struct libscols_iter itr;
 	int rc;
 
-	if (scols_table_is_tree(tb))
+	if (scols_table_is_tree(tb) || tb->stream_started)
 		return -EINVAL;
 
 	DBG(TAB, ul_debugobj(tb, "printing range from API"));
@@ -114,17 +114,25 @@ static int do_print_table(struct libscols_table *tb, int *is_empty)
 		DBG(TAB, ul_debugobj(tb, "error -- no columns"));
 		return -EINVAL;
 	}
+	if (tb->stream_started) {
+		rc = __scols_finish_stream(tb);
+		scols_table_remove_lines(tb);
+		return rc;
+	}
 	if (list_empty(&tb->tb_lines)) {
 		DBG(TAB, ul_debugobj(tb, "ignore -- no lines"));
 		if (scols_table_is_json(tb)) {
-			ul_jsonwrt_init(&tb->json, tb->out, 0);
-			ul_jsonwrt_root_open(&tb->json);
-			ul_jsonwrt_array_open(&tb->json, tb->name);
-			ul_jsonwrt_array_close(&tb->json, 1);
-			ul_jsonwrt_root_close(&tb->json);
+			rc = out_init(tb);
+			if (rc)
+				return rc;
+			out_json_root_open(tb);
+			out_json_array_open(tb, tb->name);
+			out_json_array_close(tb, 1);
+			out_json_root_close(tb);
+			rc = out_flush(tb);
 		} else if (is_empty)
 			*is_empty = 1;
-		return 0;
+		return rc;
 	}
 
 	tb->header_printed = 0;
@@ -133,8 +141,8 @@ static int do_print_table(struct libscols_table *tb, int *is_empty)
 		return rc;
 
 	if (scols_table_is_json(tb)) {
-		ul_jsonwrt_root_open(&tb->json);
-		ul_jsonwrt_array_open(&tb->json, tb->name);
+		out_json_root_open(tb);
+		out_json_array_open(tb, tb->name);
 	}
 
 	if (tb->format == SCOLS_FMT_HUMAN)
@@ -150,11 +158,13 @@ static int do_print_table(struct libscols_table *tb, int *is_empty)
 		rc = __scols_print_table(tb, buf);
 
 	if (scols_table_is_json(tb)) {
-		ul_jsonwrt_array_close(&tb->json, 1);
-		ul_jsonwrt_root_close(&tb->json);
+		out_json_array_close(tb, 1);
+		out_json_root_close(tb);
 	}
 done:
 	__scols_cleanup_printing(tb, buf);
+	if (tb->streaming)
+		scols_table_remove_lines(tb);
 	return rc;
 }
 
@@ -164,6 +174,9 @@ done:
  *
  * Prints the table to the output stream and terminate by \n.
  *
+ * In streaming mode the function prints the rest of the lines and removes all
+ * the lines from the table, see scols_table_enable_streaming().
+ *
  * Returns: 0, a negative value in case of an error.
  */
 int scols_print_table(struct libscols_table *tb)
@@ -23,7 +23,6 @@
 #include <ctype.h>
 
 #include "mbsalign.h"
-#include "carefulputc.h"
 #include "smartcolsP.h"
 
 /* Fallback for symbols
@@ -232,7 +231,7 @@ static void print_empty_cell(struct libscols_table *tb,
 		if (!ln->parent) {
 			/* only print symbols->vert if followed by child */
 			if (!list_empty(&ln->ln_branch)) {
-				fputs(vertical_symbol(tb), tb->out);
+				out_puts(tb, vertical_symbol(tb));
 				len_pad = scols_table_is_noencoding(tb) ?
 						mbs_width(vertical_symbol(tb)) :
 						mbs_safe_width(vertical_symbol(tb));
@@ -249,7 +248,7 @@ static void print_empty_cell(struct libscols_table *tb,
 					buffer_append_data(art, vertical_symbol(tb));
 				data = buffer_get_safe_data(tb, art, &len_pad, NULL);
 				if (data && len_pad)
-					fputs(data, tb->out);
+					out_puts(tb, data);
 				free_buffer(art);
 			}
 		}
@@ -265,10 +264,10 @@ static void print_empty_cell(struct libscols_table *tb,
 
 	/* fill rest of cell with space */
 	for(; len_pad < cl->width; ++len_pad)
-		fputs(cellpadding_symbol(tb), tb->out);
+		out_puts(tb, cellpadding_symbol(tb));
 
 	if (!is_last_column(cl))
-		fputs(colsep(tb), tb->out);
+		out_puts(tb, colsep(tb));
 }
 
 
@@ -313,7 +312,7 @@ static void print_newline_padding(struct libscols_table *tb,
 
 	DBG(LINE, ul_debugobj(ln, "printing newline padding"));
 
-	fputs(linesep(tb), tb->out);		/* line break */
+	out_puts(tb, linesep(tb));		/* line break */
 	tb->termlines_used++;
 
 	/* fill cells after line break */
@@ -408,10 +407,10 @@ static int print_pending_data(
 		step_pending_data(cl, bytes);
 
 	if (color)
-		fputs(color, tb->out);
-	fputs(data, tb->out);
+		out_puts(tb, color);
+	out_puts(tb, data);
 	if (color)
-		fputs(UL_COLOR_RESET, tb->out);
+		out_puts(tb, UL_COLOR_RESET);
 	free(data);
 
 	/* minout -- don't fill */
@@ -424,10 +423,10 @@ static int print_pending_data(
 
 	/* fill rest of cell with space */
 	for(i = len; i < width; i++)
-		fputs(cellpadding_symbol(tb), tb->out);
+		out_puts(tb, cellpadding_symbol(tb));
 
 	if (!is_last_column(cl))
-		fputs(colsep(tb), tb->out);
+		out_puts(tb, colsep(tb));
 
 	return 0;
 err:
@@ -466,28 +465,29 @@ static int print_data(struct libscols_table *tb,
 
 	switch (tb->format) {
 	case SCOLS_FMT_RAW:
-		fputs_nonblank(data, tb->out);
+		out_puts_nonblank(tb, data);
 		if (!is_last)
-			fputs(colsep(tb), tb->out);
+			out_puts(tb, colsep(tb));
 		return 0;
 
 	case SCOLS_FMT_EXPORT:
-		fprintf(tb->out, "%s=", name);
-		fputs_quoted(data, tb->out);
+		out_puts(tb, name);
+		out_putc(tb, '=');
+		out_puts_quoted(tb, data);
 		if (!is_last)
-			fputs(colsep(tb), tb->out);
+			out_puts(tb, colsep(tb));
 		return 0;
 
 	case SCOLS_FMT_JSON:
 		switch (cl->json_type) {
 		case SCOLS_JSON_STRING:
-			ul_jsonwrt_value_s(&tb->json, name, data, is_last);
+			out_json_value_s(tb, name, data, is_last);
 			break;
 		case SCOLS_JSON_NUMBER:
-			ul_jsonwrt_value_raw(&tb->json, name, data, is_last);
+			out_json_value_raw(tb, name, data, is_last);
 			break;
 		case SCOLS_JSON_BOOLEAN:
-			ul_jsonwrt_value_boolean(&tb->json, name,
+			out_json_value_boolean(tb, name,
 				!*data ? 0 :
 				*data == '0' ? 0 :
 				*data == 'N' || *data == 'n' ? 0 : 1,
@@ -552,12 +552,12 @@ static int print_data(struct libscols_table *tb,
 	if (data && *data) {
 		if (scols_column_is_right(cl)) {
 			if (color)
-				fputs(color, tb->out);
+				out_puts(tb, color);
 			for (i = len; i < width; i++)
-				fputs(cellpadding_symbol(tb), tb->out);
-			fputs(data, tb->out);
+				out_puts(tb, cellpadding_symbol(tb));
+			out_puts(tb, data);
 			if (color)
-				fputs(UL_COLOR_RESET, tb->out);
+				out_puts(tb, UL_COLOR_RESET);
 			len = width;
 
 		} else if (color) {
@@ -566,15 +566,15 @@ static int print_data(struct libscols_table *tb,
 
 			/* we don't want to colorize tree ascii art */
 			if (scols_column_is_tree(cl) && art && art < bytes) {
-				fwrite(p, 1, art, tb->out);
+				out_write(tb, p, art);
 				p += art;
 			}
 
-			fputs(color, tb->out);
-			fputs(p, tb->out);
-			fputs(UL_COLOR_RESET, tb->out);
+			out_puts(tb, color);
+			out_puts(tb, p);
+			out_puts(tb, UL_COLOR_RESET);
 		} else
-			fputs(data, tb->out);
+			out_puts(tb, data);
 	}
 
 	/* minout -- don't fill */
@@ -587,14 +587,15 @@ static int print_data(struct libscols_table *tb,
 
 	/* fill rest of cell with space */
 	for(i = len; i < width; i++)
-		fputs(cellpadding_symbol(tb), tb->out);
+		out_puts(tb, cellpadding_symbol(tb));
 
-	if (len > width && !scols_column_is_trunc(cl)) {
+	/* streaming -- the widths are fixed, the line is never split */
+	if (len > width && !scols_column_is_trunc(cl) && !tb->stream_started) {
 		DBG(COL, ul_debugobj(cl, "*** data len=%zu > column width=%zu", len, width));
 		print_newline_padding(tb, cl, ln, buffer_get_size(buf));	/* next column starts on next line */
 
 	} else if (!is_last)
-		fputs(colsep(tb), tb->out);		/* columns separator */
+		out_puts(tb, colsep(tb));		/* columns separator */
 
 	return 0;
 }
@@ -620,7 +621,7 @@ int __cell_to_buffer(struct libscols_table *tb,
 	data = ce ? scols_cell_get_data(ce) : NULL;
 
 	if (!scols_column_is_tree(cl))
-		return data ? buffer_set_data(buf, data) : 0;
+		return data ? buffer_set_cell_data(buf, ce) : 0;
 
 	/*
 	 * Group stuff
@@ -682,7 +683,7 @@ static int print_line(struct libscols_table *tb,
 	while (rc == 0 && pending) {
 		DBG(LINE, ul_debugobj(ln, "printing pending data"));
 		pending = 0;
-		fputs(linesep(tb), tb->out);
+		out_puts(tb, linesep(tb));
 		tb->termlines_used++;
 		scols_reset_iter(&itr, SCOLS_ITER_FORWARD);
 		while (rc == 0 && scols_table_next_column(tb, &itr, &cl) == 0) {
@@ -786,14 +787,14 @@ int __scols_print_title(struct libscols_table *tb)
 	if (tb->colors_wanted && tb->title.color)
 		color = 1;
 	if (color)
-		fputs(tb->title.color, tb->out);
+		out_puts(tb, tb->title.color);
 
-	fputs(title, tb->out);
+	out_puts(tb, title);
 
 	if (color)
-		fputs(UL_COLOR_RESET, tb->out);
+		out_puts(tb, UL_COLOR_RESET);
 
-	fputc('\n', tb->out);
+	out_putc(tb, '\n');
 	rc = 0;
 done:
 	free(buf);
@@ -843,7 +844,7 @@ int __scols_print_header(struct libscols_table *tb, struct libscols_buffer *buf)
 	}
 
 	if (rc == 0) {
-		fputs(linesep(tb), tb->out);
+		out_puts(tb, linesep(tb));
 		tb->termlines_used++;
 	}
 
@@ -872,14 +873,14 @@ int __scols_print_range(struct libscols_table *tb,
 		int last = scols_iter_is_last(itr);
 
 		if (scols_table_is_json(tb))
-			ul_jsonwrt_object_open(&tb->json, NULL);
+			out_json_object_open(tb, NULL);
 
 		rc = print_line(tb, ln, buf);
 
 		if (scols_table_is_json(tb))
-			ul_jsonwrt_object_close(&tb->json, last);
+			out_json_object_close(tb, last);
 		else if (last == 0 && tb->no_linesep == 0) {
-			fputs(linesep(tb), tb->out);
+			out_puts(tb, linesep(tb));
 			tb->termlines_used++;
 		}
 
@@ -914,7 +915,7 @@ static int print_tree_line(struct libscols_table *tb,
 	DBG(LINE, ul_debugobj(ln, "   printing tree line"));
 
 	if (scols_table_is_json(tb))
-		ul_jsonwrt_object_open(&tb->json, NULL);
+		out_json_object_open(tb, NULL);
 
 	rc = print_line(tb, ln, buf);
 	if (rc)
@@ -922,10 +923,10 @@ static int print_tree_line(struct libscols_table *tb,
 
 	if (has_children(ln)) {
 		if (scols_table_is_json(tb))
-			ul_jsonwrt_array_open(&tb->json, "children");
+			out_json_array_open(tb, "children");
 		else {
 			/* between parent and child is separator */
-			fputs(linesep(tb), tb->out);
+			out_puts(tb, linesep(tb));
 			tb->termlines_used++;
 		}
 	} else {
@@ -937,9 +938,9 @@ static int print_tree_line(struct libscols_table *tb,
 				last = (is_child(ln) && is_last_child(ln)) ||
 				       (is_tree_root(ln) && is_last_tree_root(tb, ln));
 
-				ul_jsonwrt_object_close(&tb->json, last);
+				out_json_object_close(tb, last);
 				if (last && is_child(ln))
-					ul_jsonwrt_array_close(&tb->json, last);
+					out_json_array_close(tb, last);
 				ln = ln->parent;
 			} while(ln && last);
 
@@ -948,7 +949,7 @@ static int print_tree_line(struct libscols_table *tb,
 
 			if (last_in_tree == 0) {
 				/* standard output */
-				fputs(linesep(tb), tb->out);
+				out_puts(tb, linesep(tb));
 				tb->termlines_used++;
 			}
 		}
@@ -973,9 +974,8 @@ static size_t strlen_line(struct libscols_line *ln)
 
 	for (i = 0; i < ln->ncells; i++) {
 		struct libscols_cell *ce = scols_line_get_cell(ln, i);
-		const char *data = ce ? scols_cell_get_data(ce) : NULL;
 
-		sz += data ? strlen(data) : 0;
+		sz += ce ? scols_cell_check_data(ce) : 0;
 	}
 
 	return sz;
@@ -987,6 +987,7 @@ void __scols_cleanup_printing(struct libscols_table *tb, struct libscols_buffer
 		return;
 
 	free_buffer(buf);
+	out_flush(tb);
 
 	if (tb->priv_symbols) {
 		scols_table_set_symbols(tb, NULL);
@@ -1004,6 +1005,10 @@ int __scols_initialize_printing(struct libscols_table *tb, struct libscols_buffe
 	DBG(TAB, ul_debugobj(tb, "initialize printing"));
 	*buf = NULL;
 
+	rc = out_init(tb);
+	if (rc)
+		return rc;
+
 	if (!tb->symbols) {
 		rc = scols_table_set_default_symbols(tb);
 		if (rc)
@@ -1043,7 +1048,6 @@ int __scols_initialize_printing(struct libscols_table *tb, struct libscols_buffe
 		extra_bufsz += tb->ncols;			/* separator between columns */
 		break;
 	case SCOLS_FMT_JSON:
-		ul_jsonwrt_init(&tb->json, tb->out, 0);
 		extra_bufsz += tb->nlines * 3;		/* indentation */
 		/* fallthrough */
 	case SCOLS_FMT_EXPORT:
@@ -1064,6 +1068,8 @@ int __scols_initialize_printing(struct libscols_table *tb, struct libscols_buffe
 		break;
 	}
 
+	tb->stream_extra = extra_bufsz;
+
 	/*
 	 * Enlarge buffer if necessary, the buffer should be large enough to
 	 * store line data and tree ascii art (or another decoration).
@@ -1101,3 +1107,147 @@ err:
 	return rc;
 }
 
+
+/*
+ * Streaming mode -- the lines are printed and removed from the table when the
+ * next line is added (see scols_table_enable_streaming()). The output is
+ * initialized on the first flush; the column widths are calculated from the
+ * lines in the table at this time and they are never changed.
+ */
+static int start_stream(struct libscols_table *tb)
+{
+	int rc;
+
+	DBG(TAB, ul_debugobj(tb, "start streaming [sample=%zu lines]", tb->nlines));
+
+	tb->header_printed = 0;
+	rc = __scols_initialize_printing(tb, &tb->stream_buf);
+	if (rc) {
+		tb->stream_buf = NULL;
+		return rc;
+	}
+	tb->stream_started = 1;
+
+	if (scols_table_is_json(tb)) {
+		out_json_root_open(tb);
+		out_json_array_open(tb, tb->name);
+	}
+	if (tb->format == SCOLS_FMT_HUMAN)
+		__scols_print_title(tb);
+
+	return 0;
+}
+
+/* the buffer is allocated for the sampled lines, the next lines may be longer */
+static int stream_fit_buffer(struct libscols_table *tb, struct libscols_line *ln)
+{
+	size_t sz = strlen_line(ln) + tb->stream_extra + 1;
+	struct libscols_buffer *buf;
+
+	if (sz <= buffer_get_size(tb->stream_buf))
+		return 0;
+
+	buf = new_buffer(sz);
+	if (!buf)
+		return -ENOMEM;
+	free_buffer(tb->stream_buf);
+	tb->stream_buf = buf;
+	return 0;
+}
+
+/*
+ * Prints and removes all lines in the table. The caller is going to add a next
+ * line, so none of the lines is the last one.
+ */
+int __scols_print_stream(struct libscols_table *tb)
+{
+	int rc = 0;
+
+	assert(tb);
+	assert(tb->streaming);
+
+	if (scols_table_is_tree(tb) || has_groups(tb) || list_empty(&tb->tb_columns))
+		return 0;
+
+	if (!tb->stream_started) {
+		if (tb->format == SCOLS_FMT_HUMAN && tb->nlines < tb->stream_sample)
+			return 0;
+		rc = start_stream(tb);
+	}
+
+	while (rc == 0 && !list_empty(&tb->tb_lines)) {
+		struct libscols_line *ln = list_entry(tb->tb_lines.next,
+						struct libscols_line, ln_lines);
+
+		rc = stream_fit_buffer(tb, ln);
+		if (rc)
+			break;
+
+		/* the first header or the repeated header */
+		if (want_repeat_header(tb)) {
+			rc = __scols_print_header(tb, tb->stream_buf);
+			if (rc)
+				break;
+		}
+
+		if (scols_table_is_json(tb))
+			out_json_object_open(tb, NULL);
+
+		rc = print_line(tb, ln, tb->stream_buf);
+
+		if (scols_table_is_json(tb))
+			out_json_object_close(tb, 0);
+		else if (tb->no_linesep == 0) {
+			out_puts(tb, linesep(tb));
+			tb->termlines_used++;
+		}
+
+		scols_table_remove_line(tb, ln);
+	}
+
+	out_flush(tb);
+	fflush(tb->out);
+	return rc;
+}
+
+/*
+ * Prints the rest of the lines and terminates the output.
+ */
+int __scols_finish_stream(struct libscols_table *tb)
+{
+	struct libscols_iter itr;
+	struct libscols_line *ln;
+	int rc = 0;
+
+	assert(tb);
+	assert(tb->stream_started);
+
+	DBG(TAB, ul_debugobj(tb, "finish streaming"));
+
+	scols_reset_iter(&itr, SCOLS_ITER_FORWARD);
+	while (rc == 0 && scols_table_next_line(tb, &itr, &ln) == 0)
+		rc = stream_fit_buffer(tb, ln);
+
+	if (rc == 0)
+		rc = __scols_print_header(tb, tb->stream_buf);
+	if (rc == 0)
+		rc = __scols_print_table(tb, tb->stream_buf);
+
+	if (scols_table_is_json(tb)) {
+		out_json_array_close(tb, 1);
+		out_json_root_close(tb);
+	}
+
+	__scols_cleanup_stream(tb);
+	return rc;
+}
+
+void __scols_cleanup_stream(struct libscols_table *tb)
+{
+	if (!tb || !tb->stream_started)
+		return;
+
+	__scols_cleanup_printing(tb, tb->stream_buf);
+	tb->stream_buf = NULL;
+	tb->stream_started = 0;
+}
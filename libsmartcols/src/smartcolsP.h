@@ -72,6 +72,18 @@ struct libscols_symbols {
 	char	*cell_padding;
 };
 
+struct libscols_arena;
+
+/*
+ * Native value of the typed cell, see SCOLS_DATA_*
+ */
+union libscols_value {
+	uint64_t	u64;
+	int64_t		s64;
+	double		dbl;
+	time_t		time;
+};
+
 /*
  * Table cells
  */
@@ -80,9 +92,24 @@ struct libscols_cell {
 	char	*color;
 	void    *userdata;
 	int	flags;
+
+	int	datatype;	/* SCOLS_DATA_* */
+	union libscols_value value;	/* native value for typed cells */
+
+	size_t	width;		/* cached display width of the data */
+	unsigned int	width_ok :1,	/* the width is up to date */
+			is_ascii :1,	/* printable ASCII only, no encoding necessary */
+			in_arena :1,	/* data allocated in the line arena */
+			formatted :1;	/* data generated from the value */
 };
 
 extern int scols_line_move_cells(struct libscols_line *ln, size_t newn, size_t oldn);
+extern size_t scols_cell_check_data(struct libscols_cell *ce);
+extern int scols_cell_set_arena_data(struct libscols_cell *ce, const char *data,
+				     struct libscols_arena *ar);
+extern int scols_cell_format_data(struct libscols_cell *ce);
+extern int __scols_cmp_values(int atype, const union libscols_value *a,
+			      int btype, const union libscols_value *b);
 
 /*
  * Table column
@@ -185,8 +212,12 @@ struct libscols_line {
 	struct libscols_line	*parent;
 	struct libscols_group	*parent_group;	/* for group childs */
 	struct libscols_group	*group;		/* for group members */
+
+	struct libscols_arena	*arena;		/* owner of the line and cells or NULL */
 };
 
+extern struct libscols_line *__scols_new_line(struct libscols_arena *ar);
+
 enum {
 	SCOLS_FMT_HUMAN = 0,		/* default, human readable */
 	SCOLS_FMT_RAW,			/* space separated */
@@ -194,6 +225,23 @@ enum {
 	SCOLS_FMT_JSON			/* http://en.wikipedia.org/wiki/JSON */
 };
 
+/*
+ * Default number of lines used to calculate column widths in streaming mode
+ */
+#define SCOLS_STREAM_SAMPLE	32
+
+/*
+ * Output buffer, see output.c
+ */
+struct libscols_output {
+	char	*data;
+	size_t	len;		/* used bytes */
+	size_t	sz;		/* allocated size */
+
+	int	json_indent;
+	unsigned int	json_postponed_break :1;
+};
+
 /*
  * The table
  */
@@ -225,13 +273,19 @@ struct libscols_table {
 	struct libscols_symbols	*symbols;
 	struct libscols_cell	title;		/* optional table title (for humans) */
 
-	struct ul_jsonwrt	json;		/* JSON formatting */
+	struct libscols_output	output;		/* output buffer and JSON formatting */
 
 	int	format;		/* SCOLS_FMT_* */
 
 	size_t	termlines_used;	/* printed line counter */
 	size_t	header_next;	/* where repeat header */
 
+	struct libscols_arena	*arena;		/* memory for lines or NULL */
+
+	struct libscols_buffer	*stream_buf;	/* streaming mode output buffer */
+	size_t	stream_sample;	/* number of lines to calculate widths in streaming mode */
+	size_t	stream_extra;	/* extra buffer space for output decoration */
+
 	/* flags */
 	unsigned int	ascii		:1,	/* don't use unicode */
 			colors_wanted	:1,	/* enable colors */
@@ -247,7 +301,9 @@ struct libscols_table {
 			no_headings	:1,	/* don't print header */
 			no_encode	:1,	/* don't care about control and non-printable chars */
 			no_linesep	:1,	/* don't print line separator */
-			no_wrap		:1;	/* never wrap lines */
+			no_wrap		:1,	/* never wrap lines */
+			streaming	:1,	/* print lines when added */
+			stream_started	:1;	/* streaming output initialized */
 };
 
 #define IS_ITER_FORWARD(_i)	((_i)->direction == SCOLS_ITER_FORWARD)
@@ -291,6 +347,40 @@ int scols_table_next_group(struct libscols_table *tb,
                           struct libscols_iter *itr,
                           struct libscols_group **gr);
 
+/*
+ * output.c
+ */
+extern int out_init(struct libscols_table *tb);
+extern int out_flush(struct libscols_table *tb);
+extern void out_deinit(struct libscols_table *tb);
+extern void out_write(struct libscols_table *tb, const char *data, size_t sz);
+extern void out_puts(struct libscols_table *tb, const char *str);
+extern void out_putc(struct libscols_table *tb, char c);
+extern void out_puts_json(struct libscols_table *tb, const char *str, int dir);
+extern void out_puts_quoted(struct libscols_table *tb, const char *str);
+extern void out_puts_nonblank(struct libscols_table *tb, const char *str);
+
+extern void out_json_open(struct libscols_table *tb, const char *name, int type);
+extern void out_json_close(struct libscols_table *tb, int type, int islast);
+extern void out_json_value_raw(struct libscols_table *tb,
+			const char *name, const char *data, int islast);
+extern void out_json_value_s(struct libscols_table *tb,
+			const char *name, const char *data, int islast);
+extern void out_json_value_boolean(struct libscols_table *tb,
+			const char *name, int data, int islast);
+
+#define out_json_root_open(_t)		out_json_open(_t, NULL, UL_JSON_OBJECT)
+#define out_json_root_close(_t)		out_json_close(_t, UL_JSON_OBJECT, 1)
+
+#define out_json_array_open(_t, _n)	out_json_open(_t, _n, UL_JSON_ARRAY)
+#define out_json_array_close(_t, _l)	out_json_close(_t, UL_JSON_ARRAY, _l)
+
+#define out_json_object_open(_t, _n)	out_json_open(_t, _n, UL_JSON_OBJECT)
+#define out_json_object_close(_t, _l)	out_json_close(_t, UL_JSON_OBJECT, _l)
+
+#define out_json_value_open(_t, _n)	out_json_open(_t, _n, UL_JSON_VALUE)
+#define out_json_value_close(_t, _l)	out_json_close(_t, UL_JSON_VALUE, _l)
+
 /*
  * buffer.c
  */
@@ -301,6 +391,8 @@ extern int buffer_reset_data(struct libscols_buffer *buf);
 extern int buffer_append_data(struct libscols_buffer *buf, const char *str);
 extern int buffer_append_ntimes(struct libscols_buffer *buf, size_t n, const char *str);
 extern int buffer_set_data(struct libscols_buffer *buf, const char *str);
+extern int buffer_set_cell_data(struct libscols_buffer *buf, struct libscols_cell *ce);
+extern struct libscols_cell *buffer_get_cell(struct libscols_buffer *buf);
 extern void buffer_set_art_index(struct libscols_buffer *buf);
 extern char *buffer_get_data(struct libscols_buffer *buf);
 extern size_t buffer_get_size(struct libscols_buffer *buf);
@@ -334,6 +426,15 @@ extern int scols_walk_tree(struct libscols_table *tb,
                     void *data);
 extern int scols_walk_is_last(struct libscols_table *tb, struct libscols_line *ln);
 
+/*
+ * arena.c
+ */
+extern struct libscols_arena *new_arena(void);
+extern void ref_arena(struct libscols_arena *ar);
+extern void unref_arena(struct libscols_arena *ar);
+extern void *arena_alloc(struct libscols_arena *ar, size_t sz);
+extern char *arena_strdup(struct libscols_arena *ar, const char *str);
+
 /*
  * calculate.c
  */
@@ -353,6 +454,9 @@ int __scols_print_tree(struct libscols_table *tb, struct libscols_buffer *buf);
 int __scols_print_table(struct libscols_table *tb, struct libscols_buffer *buf);
 int __scols_print_header(struct libscols_table *tb, struct libscols_buffer *buf);
 int __scols_print_title(struct libscols_table *tb);
+int __scols_print_stream(struct libscols_table *tb);
+int __scols_finish_stream(struct libscols_table *tb);
+void __scols_cleanup_stream(struct libscols_table *tb);
 int __scols_print_range(struct libscols_table *tb,
                         struct libscols_buffer *buf,
                         struct libscols_iter *itr,
@@ -76,6 +76,7 @@ struct libscols_table *scols_new_table(void)
 
 	tb->refcount = 1;
 	tb->out = stdout;
+	tb->stream_sample = SCOLS_STREAM_SAMPLE;
 
 	get_terminal_dimension(&c, &l);
 	tb->termwidth  = c > 0 ? c : 80;
@@ -125,6 +126,7 @@ void scols_unref_table(struct libscols_table *tb)
 {
 	if (tb && (--tb->refcount <= 0)) {
 		DBG(TAB, ul_debugobj(tb, "dealloc <-"));
+		__scols_cleanup_stream(tb);
 		scols_table_remove_groups(tb);
 		scols_table_remove_lines(tb);
 		scols_table_remove_columns(tb);
@@ -134,6 +136,8 @@ void scols_unref_table(struct libscols_table *tb)
 		free(tb->linesep);
 		free(tb->colsep);
 		free(tb->name);
+		unref_arena(tb->arena);
+		out_deinit(tb);
 		free(tb);
 		DBG(TAB, ul_debug("<- done"));
 	}
@@ -619,6 +623,9 @@ struct libscols_column *scols_table_get_column(struct libscols_table *tb,
  * Note that this function calls scols_line_alloc_cells() if number
  * of the cells in the line is too small for @tb.
  *
+ * In streaming mode the lines already in the table are printed and removed
+ * before @ln is added.
+ *
  * Returns: 0, a negative value in case of an error.
  */
 int scols_table_add_line(struct libscols_table *tb, struct libscols_line *ln)
@@ -629,6 +636,12 @@ int scols_table_add_line(struct libscols_table *tb, struct libscols_line *ln)
 	if (!list_empty(&ln->ln_lines))
 		return -EINVAL;
 
+	if (tb->streaming) {
+		int rc = __scols_print_stream(tb);
+		if (rc)
+			return rc;
+	}
+
 	if (tb->ncols > ln->ncells) {
 		int rc = scols_line_alloc_cells(ln, tb->ncols);
 		if (rc)
@@ -738,7 +751,7 @@ struct libscols_line *scols_table_new_line(struct libscols_table *tb,
 	if (!tb)
 		return NULL;
 
-	ln = scols_new_line();
+	ln = __scols_new_line(tb->arena);
 	if (!ln)
 		return NULL;
 
@@ -1236,6 +1249,115 @@ int scols_table_is_nowrap(const struct libscols_table *tb)
 	return tb->no_wrap;
 }
 
+/**
+ * scols_table_enable_streaming:
+ * @tb: table
+ * @enable: 1 or 0
+ *
+ * Enable streaming mode. The lines are printed to the table stream when the
+ * next line is added by scols_table_new_line() or scols_table_add_line(), and
+ * then they are removed from the table. scols_print_table() prints the rest of
+ * the lines and terminates the output. The table does not keep all the lines
+ * in memory and the output is not delayed until the end.
+ *
+ * The JSON, raw and export output is printed immediately. The human readable
+ * output is started when the table contains the number of lines specified by
+ * scols_table_set_stream_sample(); the column widths are calculated from these
+ * lines and the column width hints, and they are never changed later. The
+ * longer data in the next lines is truncated (for columns with
+ * SCOLS_FL_TRUNC) or they overflow the column width.
+ *
+ * Don't use the line after the next line is added, the line is already
+ * deallocated. The streaming mode is not supported for trees and groups
+ * (the table is printed in the usual way by scols_print_table()), and the
+ * lines cannot be sorted.
+ *
+ * Returns: 0 on success, negative number in case of an error (for example if
+ * the output is already in progress).
+ *
+ * Since: 2.37
+ */
+int scols_table_enable_streaming(struct libscols_table *tb, int enable)
+{
+	if (!tb || tb->stream_started)
+		return -EINVAL;
+	DBG(TAB, ul_debugobj(tb, "streaming: %s", enable ? "ENABLE" : "DISABLE"));
+	tb->streaming = enable ? 1 : 0;
+	return 0;
+}
+
+/**
+ * scols_table_is_streaming:
+ * @tb: a pointer to a struct libscols_table instance
+ *
+ * Returns: 1 if streaming mode is enabled.
+ *
+ * Since: 2.37
+ */
+int scols_table_is_streaming(const struct libscols_table *tb)
+{
+	return tb->streaming;
+}
+
+/**
+ * scols_table_set_stream_sample:
+ * @tb: table
+ * @nlines: number of lines
+ *
+ * Sets the number of lines used to calculate the column widths for the human
+ * readable output in streaming mode. The default is 32 lines. Use zero to
+ * start the output immediately; the widths are calculated from the column
+ * headers and the width hints (see scols_column_set_whint()) only.
+ *
+ * Returns: 0 on success, negative number in case of an error.
+ *
+ * Since: 2.37
+ */
+int scols_table_set_stream_sample(struct libscols_table *tb, size_t nlines)
+{
+	if (!tb || tb->stream_started)
+		return -EINVAL;
+	tb->stream_sample = nlines;
+	return 0;
+}
+
+/**
+ * scols_table_enable_arena:
+ * @tb: table
+ * @enable: 1 or 0
+ *
+ * Allocate the lines created by scols_table_new_line(), their cells and data
+ * set by scols_line_set_data() from large memory chunks rather than by
+ * separate malloc() calls. The memory is deallocated at once when the table
+ * and all its lines are deallocated; it's not released when a line is
+ * removed from the table, so it's not a good idea to use it together with
+ * scols_table_enable_streaming().
+ *
+ * The setting affects only the lines created after this call. The lines
+ * allocated by scols_new_line() and data set by scols_line_refer_data() or
+ * scols_cell_set_data() are not allocated in the arena.
+ *
+ * Returns: 0 on success, negative number in case of an error.
+ *
+ * Since: 2.37
+ */
+int scols_table_enable_arena(struct libscols_table *tb, int enable)
+{
+	if (!tb)
+		return -EINVAL;
+
+	DBG(TAB, ul_debugobj(tb, "arena: %s", enable ? "ENABLE" : "DISABLE"));
+	if (enable && !tb->arena) {
+		tb->arena = new_arena();
+		if (!tb->arena)
+			return -ENOMEM;
+	} else if (!enable && tb->arena) {
+		unref_arena(tb->arena);
+		tb->arena = NULL;
+	}
+	return 0;
+}
+
 /**
  * scols_table_enable_noencoding:
  * @tb: table
@@ -1445,67 +1567,176 @@ const char *scols_table_get_line_separator(const struct libscols_table *tb)
 {
 	return tb->linesep;
 }
-/* for lines in the struct libscols_line->ln_lines list */
-static int cells_cmp_wrapper_lines(struct list_head *a, struct list_head *b, void *data)
+/*
+ * Sorting
+ *
+ * The lines (and their sort keys) are copied to an array, the array is sorted
+ * by a stable merge sort and the list is rebuilt in the new order.
+ */
+struct sort_item {
+	struct libscols_line	*ln;
+	struct libscols_cell	*ce;
+	const char		*str;		/* string key */
+	int			datatype;	/* native key */
+	union libscols_value	value;
+};
+
+struct sort_ctl {
+	struct libscols_column	*cl;
+	int (*cmp)(const struct sort_item *, const struct sort_item *,
+		   struct libscols_column *);
+	struct sort_item	*buf;		/* items and merge buffer */
+	size_t			nitems;		/* allocated items */
+};
+
+static int cmp_items_str(const struct sort_item *a, const struct sort_item *b,
+			 struct libscols_column *cl __attribute__((__unused__)))
 {
-	struct libscols_column *cl = (struct libscols_column *) data;
-	struct libscols_line *ra, *rb;
-	struct libscols_cell *ca, *cb;
+	if (!a->str || !b->str)
+		return a->str ? 1 : b->str ? -1 : 0;
+	return strcmp(a->str, b->str);
+}
 
-	assert(a);
-	assert(b);
-	assert(cl);
+static int cmp_items_value(const struct sort_item *a, const struct sort_item *b,
+			   struct libscols_column *cl __attribute__((__unused__)))
+{
+	return __scols_cmp_values(a->datatype, &a->value, b->datatype, &b->value);
+}
 
-	ra = list_entry(a, struct libscols_line, ln_lines);
-	rb = list_entry(b, struct libscols_line, ln_lines);
-	ca = scols_line_get_cell(ra, cl->seqnum);
-	cb = scols_line_get_cell(rb, cl->seqnum);
+/* used if the column cmpfunc is not defined */
+static int cmp_items_default(const struct sort_item *a, const struct sort_item *b,
+			     struct libscols_column *cl)
+{
+	if (a->datatype || b->datatype)
+		return cmp_items_value(a, b, cl);
+	return cmp_items_str(a, b, cl);
+}
 
-	return cl->cmpfunc(ca, cb, cl->cmpfunc_data);
+static int cmp_items_func(const struct sort_item *a, const struct sort_item *b,
+			  struct libscols_column *cl)
+{
+	return cl->cmpfunc(a->ce, b->ce, cl->cmpfunc_data);
 }
 
-/* for lines in the struct libscols_line->ln_children list */
-static int cells_cmp_wrapper_children(struct list_head *a, struct list_head *b, void *data)
+/* returns sorted items, @src or @dst */
+static struct sort_item *sort_items(struct sort_ctl *ctl, struct sort_item *src,
+				    struct sort_item *dst, size_t n)
 {
-	struct libscols_column *cl = (struct libscols_column *) data;
-	struct libscols_line *ra, *rb;
-	struct libscols_cell *ca, *cb;
+	struct sort_item *tmp;
+	size_t width;
 
-	assert(a);
-	assert(b);
-	assert(cl);
+	/* bottom-up merge sort; equal items keep the original order */
+	for (width = 1; width < n; width *= 2) {
+		size_t lo;
 
-	ra = list_entry(a, struct libscols_line, ln_children);
-	rb = list_entry(b, struct libscols_line, ln_children);
-	ca = scols_line_get_cell(ra, cl->seqnum);
-	cb = scols_line_get_cell(rb, cl->seqnum);
+		for (lo = 0; lo < n; lo += 2 * width) {
+			size_t mid = min(lo + width, n),
+			       hi = min(lo + 2 * width, n),
+			       i = lo, j = mid, k = lo;
 
-	return cl->cmpfunc(ca, cb, cl->cmpfunc_data);
+			while (i < mid && j < hi) {
+				if (ctl->cmp(&src[j], &src[i], ctl->cl) < 0)
+					dst[k++] = src[j++];
+				else
+					dst[k++] = src[i++];
+			}
+			while (i < mid)
+				dst[k++] = src[i++];
+			while (j < hi)
+				dst[k++] = src[j++];
+		}
+		tmp = src;
+		src = dst;
+		dst = tmp;
+	}
+	return src;
 }
 
+/*
+ * Sorts list of lines, @member is offset of the list_head in the struct
+ * libscols_line (ln_lines or ln_children).
+ */
+static int sort_list(struct sort_ctl *ctl, struct list_head *head, size_t member)
+{
+	struct sort_item *items;
+	struct list_head *p, *pnext;
+	size_t i, n = 0;
+
+	list_for_each(p, head)
+		n++;
+	if (n < 2)
+		return 0;
 
-static int sort_line_children(struct libscols_line *ln, struct libscols_column *cl)
+	if (n > ctl->nitems) {
+		items = realloc(ctl->buf, 2 * n * sizeof(*items));
+		if (!items)
+			return -ENOMEM;
+		ctl->buf = items;
+		ctl->nitems = n;
+	}
+
+	i = 0;
+	list_for_each(p, head) {
+		struct sort_item *it = &ctl->buf[i++];
+		struct libscols_cell *ce;
+
+		it->ln = (struct libscols_line *) ((char *) p - member);
+		it->ce = ce = scols_line_get_cell(it->ln, ctl->cl->seqnum);
+		if (!ce) {
+			it->str = NULL;
+			it->datatype = SCOLS_DATA_NONE;
+			continue;
+		}
+		if (ctl->cmp == cmp_items_str && !ce->data && ce->datatype)
+			scols_cell_format_data(ce);
+		it->str = ce->data;
+		it->datatype = ce->datatype;
+		it->value = ce->value;
+	}
+
+	items = sort_items(ctl, ctl->buf, ctl->buf + n, n);
+
+	list_for_each_safe(p, pnext, head)
+		list_del_init(p);
+	for (i = 0; i < n; i++)
+		list_add_tail((struct list_head *) ((char *) items[i].ln + member), head);
+
+	return 0;
+}
+
+static int sort_line_children(struct sort_ctl *ctl, struct libscols_line *ln)
 {
 	struct list_head *p;
+	int rc;
 
 	if (!list_empty(&ln->ln_branch)) {
 		list_for_each(p, &ln->ln_branch) {
 			struct libscols_line *chld =
 					list_entry(p, struct libscols_line, ln_children);
-			sort_line_children(chld, cl);
+			rc = sort_line_children(ctl, chld);
+			if (rc)
+				return rc;
 		}
 
-		list_sort(&ln->ln_branch, cells_cmp_wrapper_children, cl);
+		rc = sort_list(ctl, &ln->ln_branch,
+			       offsetof(struct libscols_line, ln_children));
+		if (rc)
+			return rc;
 	}
 
 	if (is_first_group_member(ln)) {
 		list_for_each(p, &ln->group->gr_children) {
 			struct libscols_line *chld =
 					list_entry(p, struct libscols_line, ln_children);
-			sort_line_children(chld, cl);
+			rc = sort_line_children(ctl, chld);
+			if (rc)
+				return rc;
 		}
 
-		list_sort(&ln->group->gr_children, cells_cmp_wrapper_children, cl);
+		rc = sort_list(ctl, &ln->group->gr_children,
+			       offsetof(struct libscols_line, ln_children));
+		if (rc)
+			return rc;
 	}
 
 	return 0;
@@ -1519,26 +1750,43 @@ static int sort_line_children(struct libscols_line *ln, struct libscols_column *
  * Orders the table by the column. See also scols_column_set_cmpfunc(). If the
  * tree output is enabled then children in the tree are recursively sorted too.
  *
+ * The sort is stable. If the column compare function is not defined (since
+ * 2.37) then the cells with native values (see scols_cell_set_u64()) are
+ * compared by the values and the other cells by data strings.
+ *
  * Returns: 0, a negative value in case of an error.
  */
 int scols_sort_table(struct libscols_table *tb, struct libscols_column *cl)
 {
-	if (!tb || !cl || !cl->cmpfunc)
+	struct sort_ctl ctl = { .cl = cl };
+	int rc;
+
+	if (!tb || !cl)
 		return -EINVAL;
 
+	if (!cl->cmpfunc)
+		ctl.cmp = cmp_items_default;
+	else if (cl->cmpfunc == scols_cmpstr_cells)
+		ctl.cmp = cmp_items_str;
+	else if (cl->cmpfunc == scols_cmpnum_cells)
+		ctl.cmp = cmp_items_value;
+	else
+		ctl.cmp = cmp_items_func;
+
 	DBG(TAB, ul_debugobj(tb, "sorting table"));
-	list_sort(&tb->tb_lines, cells_cmp_wrapper_lines, cl);
+	rc = sort_list(&ctl, &tb->tb_lines, offsetof(struct libscols_line, ln_lines));
 
-	if (scols_table_is_tree(tb)) {
+	if (!rc && scols_table_is_tree(tb)) {
 		struct libscols_line *ln;
 		struct libscols_iter itr;
 
 		scols_reset_iter(&itr, SCOLS_ITER_FORWARD);
-		while (scols_table_next_line(tb, &itr, &ln) == 0)
-			sort_line_children(ln, cl);
+		while (rc == 0 && scols_table_next_line(tb, &itr, &ln) == 0)
+			rc = sort_line_children(&ctl, ln);
 	}
 
-	return 0;
+	free(ctl.buf);
+	return rc;
 }
 
 static struct libscols_line *move_line_and_children(struct libscols_line *ln, struct libscols_line *pre)
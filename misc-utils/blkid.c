@@ -59,7 +59,8 @@ struct blkid_control {
 		lowprobe_superblocks:1,
 		lowprobe_topology:1,
 		no_part_details:1,
-		raw_chars:1;
+		raw_chars:1,
+		watch:1;
 };
 
 static void __attribute__((__noreturn__)) usage(void)
@@ -86,6 +87,7 @@ static void __attribute__((__noreturn__)) usage(void)
 	fputs(_(	" -l, --list-one             look up only first device with token specified by -t\n"), out);
 	fputs(_(	" -L, --label <label>        convert LABEL to device name\n"), out);
 	fputs(_(	" -U, --uuid <uuid>          convert UUID to device name\n"), out);
+	fputs(_(	"     --watch                keep the cache file up to date by kernel uevents\n"), out);
 	fputs(          "\n", out);
 	fputs(_(	"Low-level probing options:\n"), out);
 	fputs(_(	" -p, --probe                low-level superblocks probing (bypass cache)\n"), out);
@@ -668,6 +670,9 @@ int main(int argc, char **argv)
 	unsigned int i;
 	int c;
 
+	enum {
+		OPT_WATCH = CHAR_MAX + 1
+	};
 	static const struct option longopts[] = {
 		{ "cache-file",	      required_argument, NULL, 'c' },
 		{ "no-encoding",      no_argument,	 NULL, 'd' },
@@ -686,6 +691,7 @@ int main(int argc, char **argv)
 		{ "offset",	      required_argument, NULL, 'O' },
 		{ "usages",	      required_argument, NULL, 'u' },
 		{ "match-types",      required_argument, NULL, 'n' },
+		{ "watch",	      no_argument,	 NULL, OPT_WATCH },
 		{ "version",	      no_argument,	 NULL, 'V' },
 		{ "help",	      no_argument,       NULL, 'h' },
 		{ NULL, 0, NULL, 0 }
@@ -808,6 +814,9 @@ int main(int argc, char **argv)
 		case 'w':
 			/* ignore - backward compatibility */
 			break;
+		case OPT_WATCH:
+			ctl.watch = 1;
+			break;
 		case 'h':
 			usage();
 			break;
@@ -841,6 +850,21 @@ int main(int argc, char **argv)
 		err = 0;
 		goto exit;
 	}
+	if (ctl.watch) {
+		int rc;
+
+		if (ctl.lowprobe || ctl.eval || numdev)
+			errx(BLKID_EXIT_OTHER, _("--watch cannot be combined "
+						 "with probing or devices"));
+		blkid_probe_all(cache);
+		rc = blkid_cache_watch(cache, -1);
+		if (rc < 0) {
+			errno = -rc;
+			warn(_("failed to watch uevents"));
+		} else
+			err = 0;
+		goto exit;
+	}
 	err = BLKID_EXIT_NOTFOUND;
 
 	if (ctl.eval == 0 && (ctl.output & OUTPUT_PRETTY_LIST)) {
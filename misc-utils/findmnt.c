@@ -46,6 +46,8 @@
 #include "xalloc.h"
 #include "optutils.h"
 #include "mangle.h"
+#include "monotonic.h"
+#include "jsonwrt.h"
 
 #include "findmnt.h"
 
@@ -1078,8 +1080,79 @@ static int poll_match(struct libmnt_fs *fs)
 	return rc;
 }
 
+static inline uint64_t msecs_since(struct timeval *start)
+{
+	struct timeval now, diff;
+
+	gettime_monotonic(&now);
+	timersub(&now, start, &diff);
+	return (uint64_t) diff.tv_sec * 1000 + diff.tv_usec / 1000;
+}
+
+/*
+ * findmnt --poll --batch <msecs>
+ *
+ * Waits until the end of the batch window started by the first event at
+ * @start. The kernel reports POLLPRI only once for all changes since the
+ * previous poll() call, so every event does not have to be a single change.
+ *
+ * Returns number of events within the window or -1 on error.
+ */
+static int wait_batch(struct pollfd *fds, unsigned int window, struct timeval *start)
+{
+	int nevents = 0;
+
+	while (1) {
+		uint64_t elapsed = msecs_since(start);
+		int count;
+
+		if (elapsed >= window)
+			break;
+		count = poll(fds, 1, window - elapsed);
+		if (count == 0)
+			break;
+		if (count < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		nevents++;
+	}
+	return nevents;
+}
+
+/*
+ * Prints JSON output for one batch, the usual "filesystems" document is
+ * followed by a separate document with the "batch" statistics.
+ */
+static int print_batch(struct libscols_table *table, int nevents,
+		       int nchanges, struct timeval *start)
+{
+	FILE *out = scols_table_get_stream(table);
+	struct ul_jsonwrt json;
+	int rc;
+
+	/* the whole table, scols_table_print_range() does not use the array */
+	rc = scols_print_table(table);
+	if (rc)
+		return rc;
+
+	ul_jsonwrt_init(&json, out, 0);
+	ul_jsonwrt_root_open(&json);
+	ul_jsonwrt_object_open(&json, "batch");
+	ul_jsonwrt_value_u64(&json, "events", nevents, 0);
+	ul_jsonwrt_value_u64(&json, "coalesced", nevents - 1, 0);
+	ul_jsonwrt_value_u64(&json, "changes", nchanges, 0);
+	ul_jsonwrt_value_u64(&json, "latency", msecs_since(start), 1);
+	ul_jsonwrt_object_close(&json, 1);
+	ul_jsonwrt_root_close(&json);
+
+	return 0;
+}
+
 static int poll_table(struct libmnt_table *tb, const char *tabfile,
-		  int timeout, struct libscols_table *table, int direction)
+		  int timeout, unsigned int batch,
+		  struct libscols_table *table, int direction)
 {
 	FILE *f = NULL;
 	int rc = -1;
@@ -1124,7 +1197,8 @@ static int poll_table(struct libmnt_table *tb, const char *tabfile,
 	while (1) {
 		struct libmnt_table *tmp;
 		struct libmnt_fs *old, *new;
-		int change, count;
+		struct timeval start;
+		int change, count, nevents = 1;
 
 		count = poll(fds, 1, timeout);
 		if (count == 0)
@@ -1134,6 +1208,17 @@ static int poll_table(struct libmnt_table *tb, const char *tabfile,
 			goto done;
 		}
 
+		if (batch) {
+			/* coalesce all events within the window to one diff */
+			gettime_monotonic(&start);
+			count = wait_batch(fds, batch, &start);
+			if (count < 0) {
+				warn(_("poll() failed"));
+				goto done;
+			}
+			nevents += count;
+		}
+
 		rewind(f);
 		rc = mnt_table_parse_stream(tb_new, f, tabfile);
 		if (!rc)
@@ -1159,7 +1244,10 @@ static int poll_table(struct libmnt_table *tb, const char *tabfile,
 		}
 
 		if (count) {
-			rc = scols_table_print_range(table, NULL, NULL);
+			if (batch && (flags & FL_JSON))
+				rc = print_batch(table, nevents, count, &start);
+			else
+				rc = scols_table_print_range(table, NULL, NULL);
 			if (rc == 0)
 				fputc('\n', scols_table_get_stream(table));
 			fflush(stdout);
@@ -1223,6 +1311,7 @@ static void __attribute__((__noreturn__)) usage(void)
 	fputc('\n', out);
 	fputs(_(" -p, --poll[=<list>]    monitor changes in table of mounted filesystems\n"), out);
 	fputs(_(" -w, --timeout <num>    upper limit in milliseconds that --poll will block\n"), out);
+	fputs(_("     --batch <num>      coalesce --poll events within <num> milliseconds\n"), out);
 	fputc('\n', out);
 
 	fputs(_(" -A, --all              disable all built-in filters, print all filesystems\n"), out);
@@ -1282,6 +1371,7 @@ int main(int argc, char *argv[])
 	int direction = MNT_ITER_FORWARD;
 	int verify = 0;
 	int c, rc = -1, timeout = -1;
+	unsigned int batch = 0;
 	int ntabfiles = 0, tabtype = 0;
 	char *outarg = NULL;
 	size_t i;
@@ -1294,7 +1384,8 @@ int main(int argc, char *argv[])
 		FINDMNT_OPT_TREE,
 		FINDMNT_OPT_OUTPUT_ALL,
 		FINDMNT_OPT_PSEUDO,
-		FINDMNT_OPT_REAL
+		FINDMNT_OPT_REAL,
+		FINDMNT_OPT_BATCH
 	};
 
 	static const struct option longopts[] = {
@@ -1331,6 +1422,7 @@ int main(int argc, char *argv[])
 		{ "task",	    required_argument, NULL, 'N'		 },
 		{ "target",	    required_argument, NULL, 'T'		 },
 		{ "timeout",	    required_argument, NULL, 'w'		 },
+		{ "batch",	    required_argument, NULL, FINDMNT_OPT_BATCH },
 		{ "uniq",	    no_argument,       NULL, 'U'		 },
 		{ "verify",	    no_argument,       NULL, 'x'		 },
 		{ "version",	    no_argument,       NULL, 'V'		 },
@@ -1503,6 +1595,9 @@ int main(int argc, char *argv[])
 		case FINDMNT_OPT_VERBOSE:
 			flags |= FL_VERBOSE;
 			break;
+		case FINDMNT_OPT_BATCH:
+			batch = strtou32_or_err(optarg, _("invalid batch argument"));
+			break;
 		case FINDMNT_OPT_TREE:
 			force_tree = 1;
 			break;
@@ -1552,6 +1647,8 @@ int main(int argc, char *argv[])
 
 	if ((flags & FL_POLL) && ntabfiles > 1)
 		errx(EXIT_FAILURE, _("--poll accepts only one file, but more specified by --tab-file"));
+	if (batch && !(flags & FL_POLL))
+		errx(EXIT_FAILURE, _("--batch requires --poll"));
 
 	if (optind < argc && (get_match(COL_SOURCE) || get_match(COL_TARGET)))
 		errx(EXIT_FAILURE, _(
@@ -1689,7 +1786,8 @@ int main(int argc, char *argv[])
 	 */
 	if (flags & FL_POLL) {
 		/* poll mode (accept the first tabfile only) */
-		rc = poll_table(tb, tabfiles ? *tabfiles : _PATH_PROC_MOUNTINFO, timeout, table, direction);
+		rc = poll_table(tb, tabfiles ? *tabfiles : _PATH_PROC_MOUNTINFO,
+				timeout, batch, table, direction);
 
 	} else if ((flags & FL_TREE) && !(flags & FL_SUBMOUNTS)) {
 		/* whole tree */
@@ -565,21 +565,6 @@ static char *mk_dm_name(const char *name)
 	return p;
 }
 
-/* stores data to scols cell userdata (invisible and independent on output)
- * to make the original values accessible for sort functions
- */
-static void set_sortdata_u64(struct libscols_line *ln, int col, uint64_t x)
-{
-	struct libscols_cell *ce = scols_line_get_cell(ln, col);
-	uint64_t *data;
-
-	if (!ce)
-		return;
-	data = xmalloc(sizeof(uint64_t));
-	*data = x;
-	scols_cell_set_userdata(ce, data);
-}
-
 /* do not modify *data on any error */
 static void str2u64(const char *str, uint64_t *data)
 {
@@ -596,26 +581,6 @@ static void str2u64(const char *str, uint64_t *data)
 	*data = num;
 }
 
-static void unref_sortdata(struct libscols_table *tb)
-{
-	struct libscols_iter *itr;
-	struct libscols_line *ln;
-
-	if (!tb || !lsblk->sort_col)
-		return;
-	itr = scols_new_iter(SCOLS_ITER_FORWARD);
-	if (!itr)
-		return;
-	while (scols_table_next_line(tb, itr, &ln) == 0) {
-		struct libscols_cell *ce = scols_line_get_column_cell(ln,
-								lsblk->sort_col);
-		void *data = scols_cell_get_userdata(ce);
-		free(data);
-	}
-
-	scols_free_iter(itr);
-}
-
 static char *get_vfs_attribute(struct lsblk_device *dev, int id)
 {
 	char *sizestr;
@@ -1111,7 +1076,7 @@ static void device_to_scols(
 
 			data = device_get_data(dev, parent, id, &sortdata);
 			if (data && sortdata != (uint64_t) -1)
-				set_sortdata_u64(ln, i, sortdata);
+				scols_cell_set_u64(scols_line_get_cell(ln, i), sortdata);
 		}
 		DBG(DEV, ul_debugobj(dev, " refer data[%zu]=\"%s\"", i, data));
 		if (data && scols_line_refer_data(ln, i, data))
@@ -1713,25 +1678,6 @@ static void parse_includes(const char *str0)
 	}
 }
 
-/*
- * see set_sortdata_u64() and columns initialization in main()
- */
-static int cmp_u64_cells(struct libscols_cell *a,
-			 struct libscols_cell *b,
-			 __attribute__((__unused__)) void *data)
-{
-	uint64_t *adata = (uint64_t *) scols_cell_get_userdata(a),
-		 *bdata = (uint64_t *) scols_cell_get_userdata(b);
-
-	if (adata == NULL && bdata == NULL)
-		return 0;
-	if (adata == NULL)
-		return -1;
-	if (bdata == NULL)
-		return 1;
-	return *adata == *bdata ? 0 : *adata >= *bdata ? 1 : -1;
-}
-
 static void device_set_dedupkey(
 			struct lsblk_device *dev,
 			struct lsblk_device *parent,
@@ -2151,9 +2097,9 @@ int main(int argc, char *argv[])
 		if (!lsblk->sort_col && lsblk->sort_id == id) {
 			lsblk->sort_col = cl;
 			scols_column_set_cmpfunc(cl,
-				ci->type == COLTYPE_NUM     ? cmp_u64_cells :
-				ci->type == COLTYPE_SIZE    ? cmp_u64_cells :
-			        ci->type == COLTYPE_SORTNUM ? cmp_u64_cells : scols_cmpstr_cells,
+				ci->type == COLTYPE_NUM     ? scols_cmpnum_cells :
+				ci->type == COLTYPE_SIZE    ? scols_cmpnum_cells :
+			        ci->type == COLTYPE_SORTNUM ? scols_cmpnum_cells : scols_cmpstr_cells,
 				NULL);
 		}
 		if (lsblk->flags & LSBLK_JSON) {
@@ -2214,9 +2160,6 @@ int main(int argc, char *argv[])
 	scols_print_table(lsblk->table);
 
 leave:
-	if (lsblk->sort_col)
-		unref_sortdata(lsblk->table);
-
 	scols_unref_table(lsblk->table);
 
 	lsblk_mnt_deinit();
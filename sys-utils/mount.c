@@ -168,6 +168,41 @@ static void print_all(struct libmnt_context *cxt, char *pattern, int show_label)
 	mnt_free_iter(itr);
 }
 
+/*
+ * mount -a --fork verbose output
+ */
+static void child_done(struct libmnt_context *cxt, struct libmnt_fs *fs,
+		       int status, unsigned long msecs)
+{
+	if (!mnt_context_is_verbose(cxt))
+		return;
+	if (status == 0)
+		printf(_("%-25s: successfully mounted (%lu.%03lu s)\n"),
+				mnt_fs_get_target(fs), msecs / 1000, msecs % 1000);
+	else
+		printf(_("%-25s: mount failed (%lu.%03lu s)\n"),
+				mnt_fs_get_target(fs), msecs / 1000, msecs % 1000);
+}
+
+/*
+ * mount --stats
+ */
+static void print_stats(struct libmnt_context *cxt)
+{
+	const char *name;
+	int id;
+
+	for (id = 0; (name = mnt_stat_get_name(id)); id++) {
+		unsigned long count = 0;
+		uint64_t usec = 0;
+
+		if (mnt_context_get_stat(cxt, id, &count, &usec) != 0 || !count)
+			continue;
+		printf(_("%-10s: %lu calls, %ju.%03ju ms\n"), name, count,
+				(uintmax_t) usec / 1000, (uintmax_t) usec % 1000);
+	}
+}
+
 /*
  * mount -a [-F]
  */
@@ -184,6 +219,8 @@ static int mount_all(struct libmnt_context *cxt)
 		warn(_("failed to initialize libmount iterator"));
 		return MNT_EX_SYSERR;
 	}
+	if (mnt_context_is_fork(cxt))
+		mnt_context_set_children_cb(cxt, child_done);
 
 	while (mnt_context_next_mount(cxt, itr, &fs, &mntrc, &ignored) == 0) {
 
@@ -460,6 +497,7 @@ static void __attribute__((__noreturn__)) usage(void)
 	" -c, --no-canonicalize   don't canonicalize paths\n"
 	" -f, --fake              dry run; skip the mount(2) syscall\n"
 	" -F, --fork              fork off for each device (use with -a)\n"
+	"     --jobs <num>        max. number of parallel mounts (implies --fork)\n"
 	" -T, --fstab <path>      alternative file to /etc/fstab\n"));
 	fprintf(out, _(
 	" -i, --internal-only     don't call the mount.<type> helpers\n"));
@@ -486,7 +524,8 @@ static void __attribute__((__noreturn__)) usage(void)
 	"     --target-prefix <path>\n"
 	"                         specifies path use for all mountpoints\n"));
 	fprintf(out, _(
-	" -v, --verbose           say what is being done\n"));
+	" -v, --verbose           say what is being done\n"
+	"     --stats             print time spent in the mount phases\n"));
 	fprintf(out, _(
 	" -w, --rw, --read-write  mount the filesystem read-write (default)\n"));
 	fprintf(out, _(
@@ -586,7 +625,7 @@ static pid_t parse_pid(const char *str)
 
 int main(int argc, char **argv)
 {
-	int c, rc = MNT_EX_SUCCESS, all = 0, show_labels = 0;
+	int c, rc = MNT_EX_SUCCESS, all = 0, show_labels = 0, show_stats = 0;
 	struct libmnt_context *cxt;
 	struct libmnt_table *fstab = NULL;
 	char *srcbuf = NULL;
@@ -609,7 +648,9 @@ int main(int argc, char **argv)
 		MOUNT_OPT_SOURCE,
 		MOUNT_OPT_OPTMODE,
 		MOUNT_OPT_OPTSRC,
-		MOUNT_OPT_OPTSRC_FORCE
+		MOUNT_OPT_OPTSRC_FORCE,
+		MOUNT_OPT_JOBS,
+		MOUNT_OPT_STATS
 	};
 
 	static const struct option longopts[] = {
@@ -617,11 +658,13 @@ int main(int argc, char **argv)
 		{ "fake",             no_argument,       NULL, 'f'                   },
 		{ "fstab",            required_argument, NULL, 'T'                   },
 		{ "fork",             no_argument,       NULL, 'F'                   },
+		{ "jobs",             required_argument, NULL, MOUNT_OPT_JOBS        },
 		{ "help",             no_argument,       NULL, 'h'                   },
 		{ "no-mtab",          no_argument,       NULL, 'n'                   },
 		{ "read-only",        no_argument,       NULL, 'r'                   },
 		{ "ro",               no_argument,       NULL, 'r'                   },
 		{ "verbose",          no_argument,       NULL, 'v'                   },
+		{ "stats",            no_argument,       NULL, MOUNT_OPT_STATS       },
 		{ "version",          no_argument,       NULL, 'V'                   },
 		{ "read-write",       no_argument,       NULL, 'w'                   },
 		{ "rw",               no_argument,       NULL, 'w'                   },
@@ -847,6 +890,15 @@ int main(int argc, char **argv)
 		case MOUNT_OPT_OPTSRC_FORCE:
 			optmode |= MNT_OMODE_FORCE;
 			break;
+		case MOUNT_OPT_JOBS:
+			mnt_context_enable_fork(cxt, TRUE);
+			if (mnt_context_set_fork_jobs(cxt,
+				strtos32_or_err(optarg, _("invalid jobs argument"))))
+				errx(MNT_EX_USAGE, _("invalid jobs argument: '%s'"), optarg);
+			break;
+		case MOUNT_OPT_STATS:
+			show_stats = 1;
+			break;
 
 		case 'h':
 			mnt_free_context(cxt);
@@ -999,6 +1051,8 @@ int main(int argc, char **argv)
 	if (rc == MNT_EX_SUCCESS && mnt_context_is_verbose(cxt))
 		success_message(cxt);
 done:
+	if (show_stats)
+		print_stats(cxt);
 	mnt_free_context(cxt);
 	env_list_free(envs_removed);
 	return rc;
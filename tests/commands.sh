@@ -2,8 +2,10 @@
 TS_TESTUSER=${TS_TESTUSER:-"nobody"}
 
 # helpers
+TS_HELPER_BLKID_UEVENT="${ts_helpersdir}test_blkid_uevent"
 TS_HELPER_BYTESWAP="${ts_helpersdir}test_byteswap"
 TS_HELPER_CPUSET="${ts_helpersdir}test_cpuset"
+TS_HELPER_CRC32="${ts_helpersdir}test_crc32"
 TS_HELPER_DMESG="${ts_helpersdir}test_dmesg"
 TS_HELPER_ISLOCAL="${ts_helpersdir}test_islocal"
 TS_HELPER_ISMOUNTED="${ts_helpersdir}test_ismounted"